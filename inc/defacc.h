@@ -49,6 +49,7 @@
  * version 3.4  12/06/2008  WD  #including stdinc.h
  * version 3.5  11/09/2008  WD  no inclusion of NEMO header files
  * version 3.6  24/04/2009  WD  avoid compiler warning with -Wshadow
+ * version 3.7  19/10/2026      AccInstall: loop over bodies in parallel
  *
  *******************************************************************************
  *
@@ -370,6 +371,7 @@ namespace {
     const Acceleration Acc;     // our acceleration
     double             Time;    // last/actual simulation time
     bool               First;   // true only after initialization
+    static const int   NOMP=256;// min # bodies for a parallel loop
     //--------------------------------------------------------------------------
     // private methods                                                          
     void remember(const double*pars, int npar, const char*file) {
@@ -436,11 +438,16 @@ namespace {
       // compute gravity and add/assign pot/acc
     {
       set_time<scalar>(NDIM,__t,__nb,__m,__x,__v);
-      if(__add & 1) 
+      // the bodies are independent, so we loop them in parallel; for this,
+      // Acc.acc<>() must not modify any shared data (search hints in tables
+      // must be kept per thread or be used as hints only)
+      if(__add & 1)
 	if(__add & 2) {
 	  // add both potential and acceleration
-	  for(int n=0,nn=0; n!=__nb; ++n,nn+=NDIM)
+#pragma omp parallel for if(__nb > NOMP) schedule(static)
+	  for(int n=0; n<__nb; ++n)
 	    if(__f==0 || __f[n] & 1) {
+	      const int nn = NDIM*n;
 	      scalar P,A[NDIM];
 	      Acc.template acc<NDIM>(__m+n, __x+nn, __v+nn, P, A);
 	      __pot[n] += P;
@@ -448,8 +455,10 @@ namespace {
 	    }
 	} else {
 	  // add potential, assign acceleration
-	  for(int n=0,nn=0; n!=__nb; ++n,nn+=NDIM)
+#pragma omp parallel for if(__nb > NOMP) schedule(static)
+	  for(int n=0; n<__nb; ++n)
 	    if(__f==0 || __f[n] & 1) {
+	      const int nn = NDIM*n;
 	      scalar P;
 	      Acc.template acc<NDIM>(__m+n, __x+nn, __v+nn, P, __acc+nn);
 	      __pot[n] += P;
@@ -457,16 +466,20 @@ namespace {
       } else {
         if(__add & 2) {
 	  // assign potential, add acceleration
-	  for(int n=0,nn=0; n!=__nb; ++n,nn+=NDIM)
+#pragma omp parallel for if(__nb > NOMP) schedule(static)
+	  for(int n=0; n<__nb; ++n)
 	    if(__f==0 || __f[n] & 1) {
+	      const int nn = NDIM*n;
 	      scalar A[NDIM];
 	      Acc.template acc<NDIM>(__m+n, __x+nn, __v+nn, __pot[n], A);
 	      v_add<NDIM>(__acc+nn,A);
 	    }
         } else {
 	  // assign both potential and acceleration
-	  for(int n=0,nn=0; n!=__nb; ++n,nn+=NDIM)
+#pragma omp parallel for if(__nb > NOMP) schedule(static)
+	  for(int n=0; n<__nb; ++n)
 	    if(__f==0 || __f[n] & 1) {
+	      const int nn = NDIM*n;
 	      Acc.template acc<NDIM>(__m+n, __x+nn, __v+nn, __pot[n], __acc+nn);
 	    }
 	}
@@ -0,0 +1,45 @@
+/*
+ * GRIDSUM.H: include file for the threaded gridding engine in gridsum.c,
+ *	      used by snapgrid, snapccd, snapslit and snapifu
+ *
+ *	19-oct-26	created		PJT
+ */
+
+#ifndef _gridsum_h
+#define _gridsum_h
+
+#include <stdinc.h>
+
+/*
+ * A gridsum holds, for each thread, its own copy of nout output grids of
+ * size reals each, in which that thread deposits its bodies; the copies
+ * are added to the output grids, in thread order, by gridsum_reduce().
+ * With one thread the output grids are used directly, so the results are
+ * those of a plain serial loop.
+ */
+
+typedef struct gridsum {
+    int nthread;		/* number of threads, and copies */
+    int nout;			/* number of output grids */
+    size_t size;		/* reals per grid */
+    real **out;			/* [nout] output grids, NULL if not used */
+    real **grids;		/* [nthread*nout] copies */
+} gridsum;
+
+#define NGCHUNK	256		/* bodies per batch of bodytrans calls */
+
+extern gridsum *gridsum_init(int nout, real **out, size_t size, bool Qpar);
+extern real **gridsum_grids(gridsum *g);	/* of the calling thread */
+extern void gridsum_reduce(gridsum *g);
+extern void gridsum_free(gridsum *g);
+
+/*
+ * gridsum_gauss: weights expfac*exp(-(z-zp[iz])^2/(2 zsig^2)) of the nz
+ *		  planes at zp[], spaced dz apart, near z; w[j] is for plane
+ *		  *izlo+j, and the number of weights is returned.  Planes
+ *		  beyond cutoff*zsig get weight 0.
+ */
+extern int gridsum_gauss(real z, real zsig, real cutoff, real expfac,
+			 real *zp, int nz, real dz, real *w, int *izlo);
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * mquantile.h:  mass weighted quantiles of (key,mass) pairs, see mquantile.c
+ *
+ *	19-oct-26  created, for snapmradii	PJT
+ *	19-oct-26  added qselect()		PJT
+ */
+
+#ifndef _mquantile_h
+#define _mquantile_h
+
+typedef struct mqpair {
+    real key;			/* quantity to take the quantiles of */
+    real mass;			/* its weight */
+} mqpair;
+
+/*
+ * mquantile: given n pairs, find the key at each of the nq mass fractions
+ *	      frac[] (sorted, increasing) of the total mass, and return the
+ *	      total mass.  The pairs are reordered.
+ */
+extern real mquantile(mqpair *p, int n, int nq, real *frac, real *quant);
+
+/*
+ * qselect: partially order a[lo..hi-1] such that a[rank[]], for nr
+ *	    increasing ranks in lo..hi-1, hold the values they would have
+ *	    if a[lo..hi-1] were sorted.
+ */
+extern void qselect(real *a, int lo, int hi, int *rank, int nr);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * TREEPOT.H: include file for the potential routines in treepot.c
+ *
+ *	19-oct-26	created, for unbind and snapstat	PJT
+ */
+
+#ifndef _treepot_h
+#define _treepot_h
+
+#include <stdinc.h>
+
+/*
+ * pos:    NDIM coordinates per body, successive bodies stride reals apart
+ *         (NDIM for a plain array of positions, 2*NDIM for phase space)
+ * mass:   masses; massless bodies do not contribute, but get phi and acc
+ * phi:    potential (G=1), with Plummer softening eps
+ * acc:    acceleration, NDIM per body; may be NULL
+ * tol:    opening angle of the tree
+ */
+
+extern void exactpot(int nbody, real *pos, int stride, real *mass,
+		     real eps, real *phi, real *acc);
+extern void treepot(int nbody, real *pos, int stride, real *mass,
+		    real eps, real tol, real *phi, real *acc);
+
+#endif
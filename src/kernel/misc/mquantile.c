@@ -0,0 +1,256 @@
+/*
+ * MQUANTILE: mass weighted quantiles of (key,mass) pairs, without a full sort
+ *
+ *	The quantile at mass fraction f is found at the first pair, in
+ *	order of increasing key, where the cumulative mass reaches f times
+ *	the total mass, interpolating linearly in cumulative mass from the
+ *	previous pair (key 0 and mass 0 before the first), as snapmradii
+ *	always did.  Instead of sorting, the pairs are partitioned
+ *	quicksort-like around a pivot, only recursing into segments that
+ *	still contain a requested fraction, which is O(N) for a handful of
+ *	fractions.  Large segments are handed out as OpenMP tasks; the
+ *	results do not depend on the number of threads.
+ *	qselect() is the unweighted counterpart, for given ranks.
+ *
+ *	19-oct-26  created, for snapmradii	PJT
+ *	19-oct-26  added qselect(), from snapcmp and snapshell	PJT
+ */
+
+#include <stdinc.h>
+#include <mquantile.h>
+
+#define NSMALL  32		/* segments this small are sorted */
+#define NTASK   65536		/* segments this large become a task */
+
+local void mqselect(mqpair *, int, int, real, real, real *, int, int, real *);
+local void mqscan(mqpair *, int, int, real, real, real *, int, int, real *);
+local void mqsort(mqpair *, int);
+
+real mquantile(mqpair *p, int n, int nq, real *frac, real *quant)
+{
+    real tmass, *targ;
+    int i;
+
+    for (i = 0, tmass = 0.0; i < n; i++)
+        tmass += p[i].mass;
+    if (n < 1 || nq < 1 || tmass == 0.0)
+        return tmass;
+    targ = (real *) allocate(nq * sizeof(real));
+    for (i = 0; i < nq; i++)
+        targ[i] = frac[i] * tmass;		/* cumulative mass wanted */
+#pragma omp parallel
+#pragma omp single
+    mqselect(p, 0, n, 0.0, 0.0, targ, 0, nq, quant);
+    free(targ);
+    return tmass;
+}
+
+/*
+ * MQSELECT: find quantiles q0..q1-1 in segment lo..hi-1; mbelow is the
+ *	     mass in front of the segment, kbelow the largest key there.
+ */
+
+local void mqselect(mqpair *p, int lo, int hi, real mbelow, real kbelow,
+                    real *targ, int q0, int q1, real *quant)
+{
+    mqpair tmp;
+    real a, b, c, pivot, mleft, mmid, kleft;
+    int i, lt, gt, qa, qb;
+
+    if (q0 >= q1)
+        return;
+    if (hi - lo <= NSMALL) {
+        mqsort(p + lo, hi - lo);
+        mqscan(p, lo, hi, mbelow, kbelow, targ, q0, q1, quant);
+        return;
+    }
+    a = p[lo].key;				/* median of three pivot */
+    b = p[(lo + hi) / 2].key;
+    c = p[hi - 1].key;
+    if (a < b)
+        pivot = (b < c ? b : (a < c ? c : a));
+    else
+        pivot = (a < c ? a : (b < c ? c : b));
+
+    lt = i = lo;				/* three way partition */
+    gt = hi;
+    while (i < gt) {
+        if (p[i].key < pivot) {
+            tmp = p[lt]; p[lt++] = p[i]; p[i++] = tmp;
+        } else if (p[i].key > pivot) {
+            tmp = p[--gt]; p[gt] = p[i]; p[i] = tmp;
+        } else
+            i++;
+    }
+    for (i = lo, mleft = mbelow; i < lt; i++)
+        mleft += p[i].mass;
+    for (i = lt, mmid = mleft; i < gt; i++)
+        mmid += p[i].mass;
+
+    qa = q0;					/* split the fractions */
+    if (lt > lo)
+        while (qa < q1 && targ[qa] <= mleft)
+            qa++;
+    qb = qa;
+    if (gt < hi)
+        while (qb < q1 && targ[qb] <= mmid)
+            qb++;
+    else
+        qb = q1;
+    kleft = kbelow;
+    if (qb > qa && lt > lo)			/* key in front of pivots */
+        for (i = lo, kleft = p[lo].key; i < lt; i++)
+            kleft = MAX(kleft, p[i].key);
+
+#pragma omp task if(lt - lo > NTASK)
+    mqselect(p, lo, lt, mbelow, kbelow, targ, q0, qa, quant);
+    mqscan(p, lt, gt, mleft, kleft, targ, qa, qb, quant);
+    mqselect(p, gt, hi, mmid, pivot, targ, qb, q1, quant);
+}
+
+/*
+ * MQSCAN: quantiles in a sorted segment; what is left at the end of the
+ *	   segment (roundoff in the cumulative mass) goes to its last pair.
+ */
+
+local void mqscan(mqpair *p, int lo, int hi, real mbelow, real kbelow,
+                  real *targ, int q0, int q1, real *quant)
+{
+    real cmass, mold, kold;
+    int i, q;
+
+    cmass = mbelow;
+    kold = kbelow;
+    for (i = lo, q = q0; i < hi && q < q1; i++) {
+        mold = cmass;
+        cmass += p[i].mass;
+        while (q < q1 && (targ[q] <= cmass || i == hi - 1)) {
+            if (cmass > mold)
+                quant[q] = kold + (targ[q] - mold) * (p[i].key - kold) /
+                                  (cmass - mold);
+            else
+                quant[q] = p[i].key;
+            q++;
+        }
+        kold = p[i].key;
+    }
+}
+
+/*
+ * MQSORT: straight insertion sort of a small segment
+ */
+
+local void mqsort(mqpair *p, int n)
+{
+    mqpair tmp;
+    int i, j;
+
+    for (i = 1; i < n; i++) {
+        tmp = p[i];
+        for (j = i; j > 0 && p[j - 1].key > tmp.key; j--)
+            p[j] = p[j - 1];
+        p[j] = tmp;
+    }
+}
+
+/*
+ * QSELECT: partially order a[lo..hi-1] such that a[rank[]] (nr increasing
+ *	    ranks in lo..hi-1) hold the values they would have if sorted;
+ *	    quickselect with a three way partition.
+ */
+
+void qselect(real *a, int lo, int hi, int *rank, int nr)
+{
+    real tmp, pivot, x, y, z;
+    int i, j, lt, gt, r0, r1;
+
+    while (nr > 0) {
+        if (hi - lo <= NSMALL) {		/* insertion sort */
+            for (i = lo + 1; i < hi; i++) {
+                tmp = a[i];
+                for (j = i; j > lo && a[j - 1] > tmp; j--)
+                    a[j] = a[j - 1];
+                a[j] = tmp;
+            }
+            return;
+        }
+        x = a[lo];				/* median of three pivot */
+        y = a[(lo + hi) / 2];
+        z = a[hi - 1];
+        if (x < y)
+            pivot = (y < z ? y : (x < z ? z : x));
+        else
+            pivot = (x < z ? x : (y < z ? z : y));
+        lt = i = lo;				/* three way partition */
+        gt = hi;
+        while (i < gt) {
+            if (a[i] < pivot) {
+                tmp = a[lt]; a[lt++] = a[i]; a[i++] = tmp;
+            } else if (a[i] > pivot) {
+                tmp = a[--gt]; a[gt] = a[i]; a[i] = tmp;
+            } else
+                i++;
+        }
+        for (r0 = 0; r0 < nr && rank[r0] < lt; r0++)	/* left of pivot */
+            ;
+        for (r1 = r0; r1 < nr && rank[r1] < gt; r1++)	/* on the pivot */
+            ;
+        qselect(a, lo, lt, rank, r0);
+        rank += r1;				/* continue on the right */
+        nr -= r1;
+        lo = gt;
+    }
+}
+
+#ifdef TESTBED
+
+#include <getparam.h>
+
+string defv[] = {
+    "n=100000\n                 Number of pairs",
+    "fraction=0.1:0.9:0.1\n     Mass fractions",
+    "seed=0\n                   Random seed",
+    "ties=0\n                   If > 0, keys are integers 0..ties-1",
+    "VERSION=1.0\n              19-oct-26 PJT",
+    NULL,
+};
+
+string usage="test mquantile() against a full sort";
+
+local int cmp_key(const void *a, const void *b)
+{
+    real ka = ((mqpair *) a)->key, kb = ((mqpair *) b)->key;
+
+    return (ka < kb ? -1 : ka > kb ? 1 : 0);
+}
+
+void nemo_main(void)
+{
+    int i, k, nq, n = getiparam("n"), ties = getiparam("ties");
+    real frac[256], q1[256], q2[256], tmass, cmass, mold, kold;
+    mqpair *p = (mqpair *) allocate(n * sizeof(mqpair));
+
+    nq = nemoinpr(getparam("fraction"), frac, 256);
+    init_xrandom(getparam("seed"));
+    for (i = 0; i < n; i++) {
+        p[i].key = ties > 0 ? (int) xrandom(0.0, (real) ties) : xrandom(0.0, 1.0);
+        p[i].mass = xrandom(0.0, 1.0);
+    }
+    tmass = mquantile(p, n, nq, frac, q1);
+    qsort(p, n, sizeof(mqpair), cmp_key);
+    cmass = mold = kold = 0.0;
+    for (i = 0, k = 0; i < n && k < nq; i++) {
+        cmass += p[i].mass;
+        while (k < nq && (cmass >= frac[k] * tmass || i == n - 1)) {
+            q2[k] = kold + (frac[k] * tmass - mold) * (p[i].key - kold) /
+                           (cmass - mold);
+            k++;
+        }
+        kold = p[i].key;
+        mold = cmass;
+    }
+    for (k = 0; k < nq; k++)
+        printf("%g %.15g %.15g %g\n", frac[k], q1[k], q2[k], q1[k] - q2[k]);
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * GRIDSUM.C: threaded gridding engine for the snapshot imaging programs.
+ *
+ *	Each thread deposits its share of the bodies in its own copy of
+ *	the output grids, which are added to the output in thread order
+ *	at the end, so results depend on the number of threads only in
+ *	the last bits.  The number of threads is limited such that the
+ *	copies take no more than GRIDMEM bytes; with a single thread no
+ *	copies are made.  Also a Gaussian kernel along the third axis,
+ *	which only visits the planes within the cutoff.
+ *
+ *	19-oct-26  created, for snapgrid, snapccd, snapslit, snapifu	PJT
+ */
+
+#include <stdinc.h>
+#include <gridsum.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#define GRIDMEM  (1024*1024*1024L)	/* max bytes in thread copies */
+
+gridsum *gridsum_init(int nout, real **out, size_t size, bool Qpar)
+{
+    gridsum *g;
+    int t, k, nused = 0, maxthread;
+
+    g = (gridsum *) allocate(sizeof(gridsum));
+    g->nout = nout;
+    g->size = size;
+    g->out = (real **) allocate(nout * sizeof(real *));
+    for (k = 0; k < nout; k++) {
+	g->out[k] = out[k];
+	if (out[k]) nused++;
+    }
+    g->nthread = 1;
+#if defined(_OPENMP)
+    if (Qpar && nused > 0) {
+	g->nthread = omp_get_max_threads();
+	maxthread = GRIDMEM / (nused * size * sizeof(real));
+	if (maxthread < g->nthread) {
+	    dprintf(1,"gridsum: memory limits to %d threads\n", MAX(maxthread,1));
+	    g->nthread = MAX(maxthread,1);
+	}
+    }
+#endif
+    g->grids = (real **) allocate(g->nthread * nout * sizeof(real *));
+    for (t = 0; t < g->nthread; t++)
+	for (k = 0; k < nout; k++)
+	    if (g->nthread == 1)
+		g->grids[k] = out[k];
+	    else if (out[k])			/* zeroed by allocate() */
+		g->grids[t*nout + k] = (real *) allocate(size * sizeof(real));
+    dprintf(1,"gridsum: %d grid(s) of %ld on %d thread(s)\n",
+	    nused, (long) size, g->nthread);
+    return g;
+}
+
+real **gridsum_grids(gridsum *g)
+{
+    int t = 0;
+
+#if defined(_OPENMP)
+    t = omp_get_thread_num();
+#endif
+    return g->grids + t * g->nout;
+}
+
+void gridsum_reduce(gridsum *g)
+{
+    long i;
+    int t, k;
+    real sum, *o;
+
+    if (g->nthread == 1)
+	return;
+    for (k = 0; k < g->nout; k++) {
+	if ((o = g->out[k]) == NULL)
+	    continue;
+#pragma omp parallel for private(t, sum)
+	for (i = 0; i < (long) g->size; i++) {
+	    sum = o[i];
+	    for (t = 0; t < g->nthread; t++)
+		sum += g->grids[t*g->nout + k][i];
+	    o[i] = sum;
+	}
+    }
+}
+
+void gridsum_free(gridsum *g)
+{
+    int i;
+
+    if (g->nthread > 1)
+	for (i = 0; i < g->nthread * g->nout; i++)
+	    if (g->grids[i])
+		free(g->grids[i]);
+    free(g->grids);
+    free(g->out);
+    free(g);
+}
+
+int gridsum_gauss(real z, real zsig, real cutoff, real expfac,
+		  real *zp, int nz, real dz, real *w, int *izlo)
+{
+    real fac, zc, zw;
+    int j, lo, hi;
+
+    lo = 0;
+    hi = nz - 1;
+    if (dz != 0.0) {				/* planes near z only */
+	zc = (z - zp[0]) / dz;
+	zw = cutoff * zsig / ABS(dz);
+	if (zc + zw < -1.0 || zc - zw > nz)
+	    return 0;
+	lo = MAX(lo, (int) floor(zc - zw) - 1);
+	hi = MIN(hi, (int) ceil(zc + zw) + 1);
+    }
+    for (j = lo; j <= hi; j++) {
+	fac = (z - zp[j]) / zsig;
+	w[j - lo] = ABS(fac) > cutoff ? 0.0 : expfac * exp(-0.5 * fac * fac);
+    }
+    *izlo = lo;
+    return hi < lo ? 0 : hi - lo + 1;
+}
@@ -0,0 +1,571 @@
+/*
+ * TREEPOT.C: potential and acceleration of a set of bodies, either by
+ *	      exact summation over all pairs, or with a Barnes & Hut tree.
+ * Public routines: exactpot(), treepot().
+ *
+ *	The tree is that of hackcode1, with quadrupole moments; it is
+ *	walked once for each group of up to NGROUP bodies, as in
+ *	hackgrav_group(), and a cell overlapping the group is always
+ *	opened.  Both are done in parallel if compiled with OpenMP: the
+ *	pair sums in blocks, each thread summing into its own copy of phi
+ *	and acc, and the tree walks group by group.  Tree results do not
+ *	depend on the number of threads, the pair sums only in the last
+ *	bits.  Bodies with the same (integer) position share a leaf, as
+ *	a list of bodies that is always summed body by body.
+ *
+ *	19-oct-26  created, for unbind and snapstat	PJT
+ *	19-oct-26  coincident bodies share a leaf	PJT
+ */
+
+#include <stdinc.h>
+#include <vectmath.h>
+#include <treepot.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#define NBLOCK  256			/* bodies per block of pair sums */
+
+local void pairsum(int, int, int, int, real *, int, real *, real,
+		   real *, real *);
+
+/*
+ * EXACTPOT: potential (and acceleration) by summation over all pairs.
+ */
+
+void exactpot(int nbody, real *pos, int stride, real *mass,
+	      real eps, real *phi, real *acc)
+{
+    int i, nthread = 1, nblk, npair;
+    real *pbuf, *abuf = NULL;
+
+#if defined(_OPENMP)
+    if (nbody >= 2*NBLOCK)
+	nthread = omp_get_max_threads();
+#endif
+    if (nthread == 1) {				/* same as the old N^2 loop */
+	for (i = 0; i < nbody; i++)
+	    phi[i] = 0.0;
+	if (acc)
+	    for (i = 0; i < nbody*NDIM; i++)
+		acc[i] = 0.0;
+	pairsum(0, nbody, 0, nbody, pos, stride, mass, eps*eps, phi, acc);
+	return;
+    }
+    nblk = (nbody + NBLOCK - 1) / NBLOCK;
+    npair = nblk * (nblk + 1) / 2;		/* blocks (I,J) with J<=I */
+    pbuf = (real *) allocate(nthread * nbody * sizeof(real));
+    if (acc)
+	abuf = (real *) allocate(nthread * nbody * NDIM * sizeof(real));
+#pragma omp parallel num_threads(nthread)
+    {
+	int t = 0, p, ib, jb, it, k;
+	real *at = NULL;
+#if defined(_OPENMP)
+	t = omp_get_thread_num();
+#endif
+	if (acc)
+	    at = abuf + t * nbody * NDIM;
+#pragma omp for schedule(static,1)
+	for (p = 0; p < npair; p++) {
+	    for (ib = 0, jb = p; jb > ib; jb -= ++ib)	/* p -> (ib,jb) */
+		;
+	    pairsum(ib*NBLOCK, MIN((ib+1)*NBLOCK, nbody),
+		    jb*NBLOCK, MIN((jb+1)*NBLOCK, nbody),
+		    pos, stride, mass, eps*eps, pbuf + t*nbody, at);
+	}
+#pragma omp for schedule(static)
+	for (p = 0; p < nbody; p++) {		/* sum over the threads */
+	    phi[p] = 0.0;
+	    for (it = 0; it < nthread; it++)
+		phi[p] += pbuf[it*nbody + p];
+	    if (acc)
+		for (k = 0; k < NDIM; k++) {
+		    acc[p*NDIM + k] = 0.0;
+		    for (it = 0; it < nthread; it++)
+			acc[p*NDIM + k] += abuf[(it*nbody + p)*NDIM + k];
+		}
+	}
+    }
+    if (acc)
+	free(abuf);
+    free(pbuf);
+}
+
+/*
+ * PAIRSUM: add the pairs i in [i0,i1), j in [j0,j1), j<i, to phi and acc.
+ */
+
+local void pairsum(int i0, int i1, int j0, int j1, real *pos, int stride,
+		   real *mass, real eps2, real *phi, real *acc)
+{
+    int i, j, k;
+    real *pi, *pj, rij, mor3, dr[NDIM];
+
+    for (i = i0, pi = pos + i0*stride; i < i1; i++, pi += stride) {
+	for (j = j0, pj = pos + j0*stride; j < i && j < j1; j++, pj += stride) {
+	    rij = 0.0;
+	    for (k = 0; k < NDIM; k++) {
+		dr[k] = pj[k] - pi[k];
+		rij += sqr(dr[k]);
+	    }
+	    rij = 1.0/sqrt(eps2 + rij);
+	    phi[i] -= mass[j]*rij;			/* G==1 */
+	    phi[j] -= mass[i]*rij;			/* G==1 */
+	    if (acc) {
+		mor3 = rij*rij*rij;
+		for (k = 0; k < NDIM; k++) {
+		    acc[i*NDIM + k] += mass[j]*mor3*dr[k];
+		    acc[j*NDIM + k] -= mass[i]*mor3*dr[k];
+		}
+	    }
+	}
+    }
+}
+
+/*
+ * The tree: BODY and CELL nodes as in hackcode1, allocated here.
+ */
+
+#define BODY 01
+#define CELL 02
+
+#define NSUB (1 << NDIM)		/* subcells per cell */
+#define IMAX (1 << (8 * sizeof(int) - 2))	/* highest bit of int coord */
+
+typedef struct {
+    short type;
+    real mass;				/* total mass of node */
+    vector pos;				/* position of node */
+} tnode, *tnodeptr;
+
+typedef struct tbody {
+    short type;
+    real mass;
+    vector pos;
+    int index;				/* index in the caller's arrays */
+    struct tbody *next;			/* next body at the same position */
+} tbody, *tbodyptr;
+
+typedef struct {
+    short type;
+    real mass;
+    vector pos;				/* center of mass */
+    matrix quad;			/* quadrupole moment */
+    tnodeptr subp[NSUB];		/* subnodes */
+    int count;				/* number of bodies in cell */
+} tcell, *tcellptr;
+
+#define Type(x) (((tnodeptr) (x))->type)
+#define Mass(x) (((tnodeptr) (x))->mass)
+#define Pos(x)  (((tnodeptr) (x))->pos)
+#define Quad(x) (((tcellptr) (x))->quad)
+#define Subp(x) (((tcellptr) (x))->subp)
+#define Next(x) (Type(x) == BODY ? (tnodeptr) ((tbodyptr) (x))->next : NULL)
+#define Count(x) (Type(x) == BODY ? leafcount(x) : ((tcellptr) (x))->count)
+
+typedef struct {
+    tnodeptr root;
+    vector rmin;			/* lower left corner of root */
+    real rsize;				/* size of root */
+    tcellptr *blocks;			/* cells are allocated in blocks */
+    int nblock, ncell, nalloc;
+} ttree;
+
+#define CBLOCK  4096			/* cells per block */
+#define NGROUP  32			/* max bodies in a group */
+
+typedef struct {
+    int first, count;			/* bodies of group in order[] */
+} tgroup;
+
+typedef struct {
+    tnodeptr *list;			/* interaction list of a group */
+    int nlist, maxlist;
+} tlist;
+
+local void loadtree(ttree *, tbodyptr);
+local void intcoord(ttree *, int [NDIM], vector);
+local int subindex(int [NDIM], int);
+local int leafcount(tnodeptr);
+local void hackcofm(tnodeptr);
+local tcellptr makecell(ttree *);
+local int treeorder(tnodeptr, tbodyptr *, int, tgroup *, int *, bool);
+local void gravgroup(ttree *, tbodyptr *, int, real, real, tlist *,
+		     real *, real *);
+local void walkgroup(tnodeptr, vector, real, vector, vector, vector, real,
+		     real, tlist *);
+
+/*
+ * TREEPOT: potential (and acceleration) with a tree code.
+ */
+
+void treepot(int nbody, real *pos, int stride, real *mass,
+	     real eps, real tol, real *phi, real *acc)
+{
+    ttree tree;
+    tbodyptr btab, *order;
+    tgroup *gtab;
+    vector rmax;
+    int i, k, nload, ngroup;
+    real *p;
+
+    btab = (tbodyptr) allocate(nbody * sizeof(tbody));
+    order = (tbodyptr *) allocate(nbody * sizeof(tbodyptr));
+    gtab = (tgroup *) allocate(nbody * sizeof(tgroup));
+    for (i = 0, p = pos; i < nbody; i++, p += stride) {
+	Type(btab+i) = BODY;
+	Mass(btab+i) = mass[i];
+	SETV(Pos(btab+i), p);
+	btab[i].index = i;
+	btab[i].next = NULL;
+	for (k = 0; k < NDIM; k++) {		/* find bounding box        */
+	    if (i == 0 || p[k] < tree.rmin[k]) tree.rmin[k] = p[k];
+	    if (i == 0 || p[k] > rmax[k]) rmax[k] = p[k];
+	}
+    }
+    tree.rsize = 0.0;
+    for (k = 0; k < NDIM; k++)
+	tree.rsize = MAX(tree.rsize, rmax[k] - tree.rmin[k]);
+    if (tree.rsize == 0.0)
+	tree.rsize = 1.0;
+    tree.rsize *= 1.001;			/* all strictly inside      */
+    for (k = 0; k < NDIM; k++)
+	tree.rmin[k] = 0.5 * (tree.rmin[k] + rmax[k] - tree.rsize);
+    tree.root = NULL;
+    tree.blocks = NULL;
+    tree.nblock = tree.ncell = tree.nalloc = 0;
+    for (i = 0; i < nbody; i++)			/* only load massive ones   */
+	if (Mass(btab+i) != 0.0)
+	    loadtree(&tree, btab+i);
+    nload = ngroup = 0;
+    if (tree.root != NULL) {
+	hackcofm(tree.root);
+	nload = treeorder(tree.root, order, 0, gtab, &ngroup, FALSE);
+    }
+    dprintf(1,"treepot: %d cells for %d bodies in %d groups, tol=%g\n",
+	    tree.ncell, nload, ngroup, tol);
+    for (i = 0; i < nbody; i++)			/* massless ones on their own */
+	if (Mass(btab+i) == 0.0) {
+	    gtab[ngroup].first = nload;
+	    gtab[ngroup++].count = 1;
+	    order[nload++] = btab+i;
+	}
+
+    if (tree.root != NULL)
+#pragma omp parallel
+    {
+	tlist ial;
+	int g;
+
+	ial.list = NULL;
+	ial.nlist = ial.maxlist = 0;
+#pragma omp for schedule(dynamic,16)
+	for (g = 0; g < ngroup; g++)
+	    gravgroup(&tree, order + gtab[g].first, gtab[g].count,
+		      tol*tol, eps*eps, &ial, phi, acc);
+	if (ial.list)
+	    free(ial.list);
+    }
+    else
+	for (i = 0; i < nbody; i++) {		/* no mass, no field */
+	    phi[i] = 0.0;
+	    if (acc)
+		CLRV(acc + i*NDIM);
+	}
+
+    for (i = 0; i < tree.nblock; i++)
+	free(tree.blocks[i]);
+    if (tree.blocks)
+	free(tree.blocks);
+    free(gtab);
+    free(order);
+    free(btab);
+}
+
+/*
+ * LOADTREE: descend tree and insert particle; a body at the integer
+ *	     position of a leaf is added to the list of that leaf.
+ */
+
+local void loadtree(ttree *t, tbodyptr p)
+{
+    int l, k, xp[NDIM], xq[NDIM];
+    tnodeptr *qptr;
+    tcellptr c;
+
+    intcoord(t, xp, Pos(p));			/* form integer coords      */
+    l = IMAX >> 1;				/* start with top bit       */
+    qptr = &t->root;				/* start with tree root     */
+    while (*qptr != NULL) {			/* loop descending tree     */
+	if (Type(*qptr) == BODY) {		/*   reached a "leaf"?      */
+	    intcoord(t, xq, Pos(*qptr));	/*     get integer coords   */
+	    for (k = 0; k < NDIM && xq[k] == xp[k]; k++)
+		;
+	    if (k == NDIM) {			/*     same place: share it */
+		p->next = ((tbodyptr) *qptr)->next;
+		((tbodyptr) *qptr)->next = p;
+		return;
+	    }
+	    c = makecell(t);			/*     alloc a new cell     */
+	    Subp(c)[subindex(xq, l)] = *qptr;	/*     put body in cell     */
+	    *qptr = (tnodeptr) c;		/*     link cell in tree    */
+	}
+	qptr = &Subp(*qptr)[subindex(xp, l)];	/*   move down one level    */
+	l = l >> 1;				/*   and test next bit      */
+    }
+    *qptr = (tnodeptr) p;			/* found place, store p     */
+}
+
+/*
+ * INTCOORD: compute integerized coordinates; the box holds all bodies.
+ */
+
+local void intcoord(ttree *t, int xp[NDIM], vector rp)
+{
+    int k;
+    double xsc;
+
+    for (k = 0; k < NDIM; k++) {
+	xsc = (rp[k] - t->rmin[k]) / t->rsize;	/*   scale to range [0,1)   */
+	xp[k] = floor(IMAX * xsc);
+    }
+}
+
+/*
+ * SUBINDEX: determine which subcell to select.
+ */
+
+local int subindex(int x[NDIM], int l)
+{
+    int i, k;
+
+    i = 0;                                      /* sum index in i           */
+    for (k = 0; k < NDIM; k++)                  /* check each dimension     */
+	if (x[k] & l)                           /*   if beyond midpoint     */
+	    i += NSUB >> (k + 1);               /*     skip over subcells   */
+    return i;
+}
+
+/*
+ * LEAFCOUNT: number of bodies in the list of a leaf.
+ */
+
+local int leafcount(tnodeptr q)
+{
+    int n;
+
+    for (n = 0; q != NULL; q = Next(q))
+	n++;
+    return n;
+}
+
+/*
+ * HACKCOFM: descend tree finding center-of-mass coordinates and
+ *	     quadrupole moments.
+ */
+
+local void hackcofm(tnodeptr q)
+{
+    int i;
+    tnodeptr r;
+    vector tmpv, dr;
+    real drsq;
+    matrix drdr, Idrsq, tmpm;
+
+    if (Type(q) != CELL)
+	return;
+    Mass(q) = 0.0;				/* init total mass          */
+    CLRV(Pos(q));				/* and c. of m.             */
+    ((tcellptr) q)->count = 0;
+    for (i = 0; i < NSUB; i++) {		/* loop over subcells       */
+	for (r = Subp(q)[i]; r != NULL; r = Next(r)) {
+	    hackcofm(r);			/*   find subcell cm        */
+	    Mass(q) += Mass(r);			/*   sum total mass         */
+	    ((tcellptr) q)->count += (Type(r) == BODY ? 1 : Count(r));
+	    MULVS(tmpv, Pos(r), Mass(r));	/*   find moment            */
+	    ADDV(Pos(q), Pos(q), tmpv);		/*   sum tot. moment        */
+	}
+    }
+    DIVVS(Pos(q), Pos(q), Mass(q));		/* rescale cms position     */
+    CLRM(Quad(q));				/* init. quad. moment       */
+    for (i = 0; i < NSUB; i++) {
+	for (r = Subp(q)[i]; r != NULL; r = Next(r)) {
+	    SUBV(dr, Pos(r), Pos(q));		/*   displacement vect.     */
+	    OUTVP(drdr, dr, dr);		/*   outer prod. of dr      */
+	    DOTVP(drsq, dr, dr);		/*   dot prod. dr * dr      */
+	    SETMI(Idrsq);			/*   init unit matrix       */
+	    MULMS(Idrsq, Idrsq, drsq);		/*   scale by dr * dr       */
+	    MULMS(tmpm, drdr, 3.0);		/*   scale drdr by 3        */
+	    SUBM(tmpm, tmpm, Idrsq);		/*   form quad. moment      */
+	    MULMS(tmpm, tmpm, Mass(r));		/*   of cm of subnode,      */
+	    if (Type(r) == CELL)		/*   if subnode is cell     */
+		ADDM(tmpm, tmpm, Quad(r));	/*     use its moment       */
+	    ADDM(Quad(q), Quad(q), tmpm);	/*   add to qm of cell      */
+	}
+    }
+}
+
+/*
+ * MAKECELL: allocation routine for cells.
+ */
+
+local tcellptr makecell(ttree *t)
+{
+    tcellptr c;
+    int i;
+
+    if (t->ncell == t->nblock * CBLOCK) {	/* need a new block?        */
+	if (t->nblock == t->nalloc) {
+	    t->nalloc = MAX(2 * t->nalloc, 16);
+	    t->blocks = (tcellptr *) reallocate(t->blocks,
+						t->nalloc * sizeof(tcellptr));
+	}
+	t->blocks[t->nblock++] = (tcellptr) allocate(CBLOCK * sizeof(tcell));
+    }
+    c = t->blocks[t->ncell / CBLOCK] + t->ncell % CBLOCK;
+    t->ncell++;
+    Type(c) = CELL;
+    for (i = 0; i < NSUB; i++)
+	Subp(c)[i] = NULL;
+    return c;
+}
+
+/*
+ * TREEORDER: list the bodies in the order of the tree, so that bodies of
+ *	      a cell are contiguous, and make the largest cells of at most
+ *	      NGROUP bodies into groups.
+ */
+
+local int treeorder(tnodeptr q, tbodyptr *order, int n,
+		    tgroup *gtab, int *ngroup, bool ingroup)
+{
+    int i;
+
+    if (!ingroup && Count(q) <= NGROUP) {
+	gtab[*ngroup].first = n;
+	gtab[(*ngroup)++].count = Count(q);
+	ingroup = TRUE;
+    }
+    if (Type(q) == BODY)
+	for ( ; q != NULL; q = Next(q))
+	    order[n++] = (tbodyptr) q;
+    else
+	for (i = 0; i < NSUB; i++)
+	    if (Subp(q)[i] != NULL)
+		n = treeorder(Subp(q)[i], order, n, gtab, ngroup, ingroup);
+    return n;
+}
+
+/*
+ * GRAVGROUP: field at a group of bodies, from a single tree walk; the
+ *	      physics is that of gravsub.
+ */
+
+local void gravgroup(ttree *t, tbodyptr *gtab, int ngrp, real tolsq,
+		     real eps2, tlist *ial, real *phi, real *acc)
+{
+    vector gmin, gmax, gpos, dr, ai, acc0, quaddr;
+    real grad, drsq, drabs, phii, mor3, dr5inv, phiquad, drquaddr, phi0;
+    tnodeptr p;
+    tbodyptr b;
+    int i, j, k;
+
+    SETV(gmin, Pos(gtab[0]));			/* find bounding box        */
+    SETV(gmax, Pos(gtab[0]));
+    for (i = 1; i < ngrp; i++)
+	for (k = 0; k < NDIM; k++) {
+	    gmin[k] = MIN(gmin[k], Pos(gtab[i])[k]);
+	    gmax[k] = MAX(gmax[k], Pos(gtab[i])[k]);
+	}
+    ADDV(gpos, gmin, gmax);			/* center of group          */
+    DIVVS(gpos, gpos, 2.0);
+    grad = 0.0;					/* and its radius           */
+    for (i = 0; i < ngrp; i++) {
+	SUBV(dr, Pos(gtab[i]), gpos);
+	DOTVP(drsq, dr, dr);
+	grad = MAX(grad, drsq);
+    }
+    grad = sqrt(grad);
+    ial->nlist = 0;
+    walkgroup(t->root, t->rmin, t->rsize, gmin, gmax, gpos, grad, tolsq, ial);
+
+    for (i = 0; i < ngrp; i++) {		/* sum list for each body   */
+	b = gtab[i];
+	phi0 = 0.0;
+	CLRV(acc0);
+	for (j = 0; j < ial->nlist; j++)
+	    for (p = ial->list[j]; p != NULL; p = Next(p)) {
+		if (p == (tnodeptr) b)		/* skip self-interaction    */
+		    continue;
+		SUBV(dr, Pos(p), Pos(b));
+		DOTVP(drsq, dr, dr);
+		drsq += eps2;			/* use standard softening   */
+		drabs = sqrt(drsq);
+		phii = Mass(p) / drabs;
+		phi0 -= phii;			/* add to grav. pot.        */
+		mor3 = phii / drsq;
+		MULVS(ai, dr, mor3);
+		ADDV(acc0, acc0, ai);		/* add to net accel.        */
+		if (Type(p) == CELL) {		/* if cell, add quad. term  */
+		    dr5inv = 1.0/(drsq * drsq * drabs);
+		    MULMV(quaddr, Quad(p), dr);	/*   form Q * dr            */
+		    DOTVP(drquaddr, dr, quaddr); /*   form dr * Q * dr       */
+		    phiquad = -0.5 * dr5inv * drquaddr;
+		    phi0 += phiquad;		/*   quad. part of poten.   */
+		    phiquad = 5.0 * phiquad / drsq;
+		    MULVS(ai, dr, phiquad);
+		    SUBV(acc0, acc0, ai);
+		    MULVS(quaddr, quaddr, dr5inv);
+		    SUBV(acc0, acc0, quaddr);
+		}
+	    }
+	phi[b->index] = phi0;
+	if (acc)
+	    SETV(acc + b->index * NDIM, acc0);
+    }
+}
+
+/*
+ * WALKGROUP: gather the interaction list of a group; a cell, of size
+ *	      'size' and lower left corner 'corner', is opened if it
+ *	      overlaps the group's box or is too close to its sphere.
+ */
+
+local void walkgroup(tnodeptr p, vector corner, real size, vector gmin,
+		     vector gmax, vector gpos, real grad, real tolsq,
+		     tlist *ial)
+{
+    vector dr, csub;
+    real dmin, half;
+    bool overlap;
+    int i, k;
+
+    if (Type(p) == CELL) {
+	overlap = TRUE;
+	for (k = 0; k < NDIM; k++)
+	    if (gmax[k] < corner[k] || gmin[k] >= corner[k] + size)
+		overlap = FALSE;
+	SUBV(dr, Pos(p), gpos);
+	ABSV(dmin, dr);
+	dmin -= grad;				/* nearest group point      */
+	if (overlap || dmin <= 0.0 || tolsq * dmin * dmin < size * size) {
+	    half = 0.5 * size;
+	    for (i = 0; i < NSUB; i++)
+		if (Subp(p)[i] != NULL) {
+		    for (k = 0; k < NDIM; k++)
+			csub[k] = corner[k] +
+			    ((i & (NSUB >> (k + 1))) ? half : 0.0);
+		    walkgroup(Subp(p)[i], csub, half, gmin, gmax, gpos, grad,
+			      tolsq, ial);
+		}
+	    return;
+	}
+    }
+    if (ial->nlist >= ial->maxlist) {		/* grow list if needed      */
+	ial->maxlist = MAX(2 * ial->maxlist, 256);
+	ial->list = (tnodeptr *) reallocate(ial->list,
+					    ial->maxlist * sizeof(tnodeptr));
+    }
+    ial->list[ial->nlist++] = p;
+}
@@ -69,20 +69,30 @@ typedef struct {
 #define Aux(p)   ((p)->aux)
 #define Key(p)   ((p)->key)
 
-#ifndef MBODY
-#  define MBODY 4096		/* max number of bodies */
-#endif
-
 global int nbody;			/* number of bodies simulated */
 
-global body bodytab[MBODY];		/* array representing state */
+global bodyptr bodytab;			/* array representing state */
 
 typedef void (*fproc)(bodyptr p, int np, real time, bool Qnew);
 
+/*
+ * CHUNKVEC: structure-of-arrays block of body vectors, used by the
+ *           ensemble stepper (ensemble.c) to advance NCHUNK bodies at once.
+ */
+
+#ifndef NCHUNK
+#  define NCHUNK 256
+#endif
+
+typedef real chunkvec[NDIM][NCHUNK];
+
+global bool Qensemble;			/* advance bodies as an ensemble ? */
+
 /* flowcode.c */
 
 extern void setparams(void);
 extern void force(bodyptr btab, int nb, real time, bool Qnew);
+extern void forcechunk(int n, chunkvec x, chunkvec a, real *phi, real time);
 
 /* diffuse.c */
 extern void rotate_aux(bodyptr btab, int nb);
@@ -100,3 +110,7 @@ extern void restorestate(string file);
 /* orbstep.c */
 extern void initstep(bodyptr btab, int nb, real *tptr, fproc force);
 extern void orbstep(bodyptr btab, int nb, real *tptr, fproc force, real dt, int mode);
+
+/* ensemble.c */
+extern void ensinit(bodyptr btab, int nb, real *tptr);
+extern void ensstep(bodyptr btab, int nb, real *tptr, real dt, int mode);
@@ -0,0 +1,230 @@
+/*
+ * ENSEMBLE.C: flow integration of all bodies as an ensemble.
+ * Defines: ensinit(), ensstep().
+ *
+ *	Bodies are gathered in chunks of NCHUNK into structure-of-arrays
+ *	blocks, the whole time-step is taken on a chunk with one batched
+ *	flow evaluation per force call (forcechunk), and the result is
+ *	scattered back into bodytab.  Chunks are independent, and are done in
+ *	parallel if compiled with OpenMP, so the flow must be reentrant.
+ *	The arithmetic follows orbstep.c, so results are identical; as
+ *	there, Acc() is the flow velocity, and Vel() a copy of it.
+ *	No diffusion is done here, see flowcode.c.
+ *
+ * oct-2026    created, for modes 0..4 of orbstep()
+ */
+
+#include "defs.h"
+
+/*
+ * CHUNK: working storage of one chunk, one per thread.
+ */
+
+typedef struct {
+    int n;			/* bodies in this chunk */
+    chunkvec x, v, a;		/* body position, velocity, flow */
+    real phi[NCHUNK];		/* body potential */
+    chunkvec xt, at;		/* trial position, flow */
+    real phit[NCHUNK];		/* trial potential */
+    chunkvec d1, d2;		/* saved flows (rk4) */
+} chunk, *chunkptr;
+
+/*
+ * ABAK: saved flows, latest to oldest, by coordinate; the slots
+ *	 rotate after each step instead of being copied (see moveaccel).
+ */
+
+local real *abak[4][NDIM];
+local int ibak = 0;		/* slot of abak0 */
+local int nstep = 0;		/* integration step counter */
+
+#define ABAK(h,k)  abak[(ibak + (h)) % 4][k]
+
+local void loadchunk(chunkptr c, bodyptr btab, int nb, int i0);
+local void savechunk(chunkptr c, bodyptr btab, int i0);
+local void stepchunk(chunkptr c, int i0, real t, real dt, int mode);
+
+/*
+ * ENSINIT: initialize the ensemble integrator.
+ */
+
+void ensinit(bodyptr btab, int nb, real *tptr)
+{
+    chunk c;
+    int h, k, i0;
+
+    nstep = 0;
+    ibak = 0;
+    for (h = 0; h < 4; h++)
+	for (k = 0; k < NDIM; k++)
+	    abak[h][k] = (real *) allocate(nb * sizeof(real));
+#pragma omp parallel for private(c, k) schedule(dynamic)
+    for (i0 = 0; i0 < nb; i0 += NCHUNK) {
+	loadchunk(&c, btab, nb, i0);
+	forcechunk(c.n, c.x, c.a, c.phi, *tptr);
+	for (k = 0; k < NDIM; k++)		/* save resulting flow */
+	    memcpy(ABAK(0,k) + i0, c.a[k], c.n * sizeof(real));
+	savechunk(&c, btab, i0);
+    }
+}
+
+/*
+ * ENSSTEP: advance the ensemble by one time-step, like orbstep().
+ */
+
+void ensstep(bodyptr btab, int nb, real *tptr, real dt, int mode)
+{
+    chunk c;
+    int i0;
+
+    if (mode == 5)
+	error("leapfrog stepping not implemented");
+    if (mode < 0 || mode > 4)
+	error("ensstep: unknown mode %d", mode);
+#pragma omp parallel for private(c) schedule(dynamic)
+    for (i0 = 0; i0 < nb; i0 += NCHUNK) {
+	loadchunk(&c, btab, nb, i0);
+	stepchunk(&c, i0, *tptr, dt, mode);
+	savechunk(&c, btab, i0);
+    }
+    ibak = (ibak + 3) % 4;			/* oldest slot is now abak0 */
+    *tptr += dt;
+    nstep++;
+}
+
+/*
+ * LOADCHUNK, SAVECHUNK: gather bodies into a chunk, and scatter back.
+ */
+
+local void loadchunk(chunkptr c, bodyptr btab, int nb, int i0)
+{
+    bodyptr p;
+    int i, k;
+
+    c->n = MIN(NCHUNK, nb - i0);
+    for (i = 0, p = btab + i0; i < c->n; i++, p++) {
+	for (k = 0; k < NDIM; k++) {
+	    c->x[k][i] = Pos(p)[k];
+	    c->v[k][i] = Vel(p)[k];
+	    c->a[k][i] = Acc(p)[k];
+	}
+	c->phi[i] = Phi(p);
+    }
+}
+
+local void savechunk(chunkptr c, bodyptr btab, int i0)
+{
+    bodyptr p;
+    int i, k;
+
+    for (i = 0, p = btab + i0; i < c->n; i++, p++) {
+	for (k = 0; k < NDIM; k++) {
+	    Pos(p)[k] = c->x[k][i];
+	    Vel(p)[k] = c->v[k][i];
+	    Acc(p)[k] = c->a[k][i];
+	}
+	Phi(p) = c->phi[i];
+    }
+}
+
+/*
+ * STEPCHUNK: take a complete time-step on one chunk; see orbstep() for
+ *	      the meaning of mode.  Final flow evaluations that orbstep()
+ *	      repeats at the same positions are done only once here.
+ *	      The final flows are stored in the oldest history slot,
+ *	      which becomes abak0.
+ */
+
+local void stepchunk(chunkptr c, int i0, real t, real dt, int mode)
+{
+    int i, k, n = c->n;
+    real dt2, dts4, dt6, dt360, dts32, dt720, app, acp, acv;
+    real *a0, *a1, *a2, *a3;
+
+    if (mode == 0) {				/* Euler */
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->x[k][i] += dt * c->a[k][i];
+		c->v[k][i] = c->a[k][i];
+	    }
+	forcechunk(n, c->x, c->a, c->phi, t + dt);
+    } else if (mode == 4) {			/* RK4 */
+	dt2 = 0.5*dt;
+	dt6 = dt/6.0;
+	forcechunk(n, c->x, c->a, c->phi, t);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->xt[k][i] = c->x[k][i] + dt2*c->a[k][i];
+	forcechunk(n, c->xt, c->at, c->phit, t + dt2);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->d1[k][i] = c->at[k][i];		/* save 'dyt' */
+		c->xt[k][i] = c->x[k][i] + dt2*c->at[k][i];
+	    }
+	forcechunk(n, c->xt, c->at, c->phit, t + dt2);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->d2[k][i] = c->at[k][i];		/* save 'dym' */
+		c->xt[k][i] = c->x[k][i] + dt*c->at[k][i];
+		c->d2[k][i] = c->d2[k][i] + c->d1[k][i];
+	    }
+	forcechunk(n, c->xt, c->at, c->phit, t + dt);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt6*(c->a[k][i]+c->at[k][i]+2*c->d2[k][i]);
+	forcechunk(n, c->x, c->a, c->phi, t + dt);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->v[k][i] = c->a[k][i];
+    } else if (mode == 1 || nstep < 3) {	/* RK */
+	dt2 = dt / 2;
+	dts4 = dt2 * dt2;
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt2 * c->a[k][i];		/* set position x_1 */
+	forcechunk(n, c->x, c->a, c->phi, t + dt2);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dts4 * a0[i];		/* set position x_2 */
+	}
+	forcechunk(n, c->x, c->a, c->phi, t + dt2);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt2 * c->a[k][i];		/* set position x_3 */
+	forcechunk(n, c->x, c->a, c->phi, t + dt);
+    } else {					/* PC and PC1 */
+	dt360 = dt / 360;
+	dts32 = dt*dt / 32;
+	dt720 = dt / 720;
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    a1 = ABAK(1,k) + i0;
+	    a2 = ABAK(2,k) + i0;
+	    a3 = ABAK(3,k) + i0;
+	    for (i = 0; i < n; i++) {
+		app = 323 * a0[i] - 264 * a1[i] + 159 * a2[i] -  38 * a3[i];
+		c->x[k][i] += dt * (c->v[k][i] + dt360 * app);
+	    }
+	}
+	forcechunk(n, c->x, c->a, c->phi, t + dt);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    a1 = ABAK(1,k) + i0;
+	    a2 = ABAK(2,k) + i0;
+	    a3 = ABAK(3,k) + i0;
+	    for (i = 0; i < n; i++) {
+		acp = 3 * c->a[k][i] - 12 * a0[i] +
+		    18 * a1[i] - 12 * a2[i] + 3 * a3[i];
+		c->x[k][i] += dts32 * acp;		/* correct position */
+		acv = 251 * c->a[k][i] + 646 * a0[i] -
+		    264 * a1[i] + 106 * a2[i] - 19 * a3[i];
+		c->v[k][i] += dt720 * acv;		/* advance velocity */
+	    }
+	}
+	if (mode == 2)
+	    forcechunk(n, c->x, c->a, c->phi, t + dt);
+    }
+    for (k = 0; k < NDIM; k++)			/* moveaccel: oldest slot */
+	memcpy(ABAK(3,k) + i0, c->a[k], n * sizeof(real));
+}
@@ -6,8 +6,7 @@
  *       3-feb-04  0.4 major CVS version skew fix
  *      24-dec-04  0.6b global fix for MacOSX 
  *       7-feb-07  0.6c prototype fix for gcc4
- *
- * To improve:  use allocate() for number of particles; not static
+ *      19-oct-26  0.7  allocate bodies, added ensemble= mode
  *
  * See also:
  *    http://www.amara.com/ftpstuff/streamlines1.txt
@@ -38,7 +37,8 @@ string defv[] = {
     "freqdiff=\n          frequency of diffusion [freq]",
     "seed=0\n		  random seed",
     "headline=\n          random verbiage",
-    "VERSION=0.6c\n	  7-feb-07 PJT",
+    "ensemble=f\n         Advance bodies as an ensemble in chunks (threads via np=)",
+    "VERSION=0.7\n	  19-oct-26 PJT",
     NULL,
 };
 
@@ -51,10 +51,16 @@ void nemo_main()
     setparams();
     inputdata();
     initoutput();
-    initstep(bodytab, nbody, &tnow, force);
+    if (Qensemble)
+        ensinit(bodytab, nbody, &tnow);
+    else
+        initstep(bodytab, nbody, &tnow, force);
     output();
     while (tnow + 0.1/freq < tstop) {
-	orbstep(bodytab, nbody, &tnow, force, 1.0/freq, mode);
+        if (Qensemble)
+	    ensstep(bodytab, nbody, &tnow, 1.0/freq, mode);
+	else
+	    orbstep(bodytab, nbody, &tnow, force, 1.0/freq, mode);
 	output();
     }
     stopoutput();
@@ -90,6 +96,11 @@ void setparams(void)
     rmax = getdparam("rmax");
     fheat = getdparam("fheat");
     headline = getparam("headline");
+    Qensemble = getbparam("ensemble");
+    if (Qensemble && sigma > 0.0) {
+        warning("ensemble=t not used with diffusion (sigma>0)");
+        Qensemble = FALSE;
+    }
     set_xrandom(getiparam("seed"));
 }
 
@@ -127,3 +138,25 @@ void force(bodyptr btab, int nb, real time, bool Qnew)
       time_next_diff += 1.0/freqdiff;
     }
 }
+
+/*
+ * FORCECHUNK: 'force' calculation on a chunk of bodies, by coordinate,
+ *	       for the ensemble stepper.  Since this is called from
+ *	       parallel regions, there is no diffusion here.
+ */
+
+void forcechunk(int n, chunkvec x, chunkvec a, real *phi, real time)
+{
+    vector lacc,lpos;
+    real   lphi, ltime = time;
+    int    i, k, ndim=NDIM;
+
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < NDIM; k++)
+	    lpos[k] = x[k][i];
+        (*pot)(&ndim,lpos,lacc,&lphi,&ltime);
+        for (k = 0; k < NDIM; k++)
+	    a[k][i] = lacc[k];
+        phi[i] = lphi;
+    }
+}
@@ -4,7 +4,7 @@
  *            
  *
  * Defines: initstep(), orbstep().
- * Requires: MBODY, body, bodyptr, Pos(), Vel(), Acc().
+ * Requires: body, bodyptr, Pos(), Vel(), Acc().
  *
  *  10-jun-92  Added the 'rk4' method, but this
  *             now uses VECTMATH and assumes particles are
@@ -13,6 +13,7 @@
  *             potentials.					PJT
  *  11-apr-96  adapted for flowcode from the potcode version    PJT
  *   6-feb-04  overhauled the code and defined diffusion angles in Aux()  PJT
+ *  19-oct-26  history arrays allocated, no more MBODY
  *
  */
 
@@ -22,12 +23,11 @@
  * ABAK0, ..., ABAK3: saved accelerations, latest to oldest.
  */
 
-#define MCOR  (NDIM * MBODY)
-
-local real abak0[MCOR];
-local real abak1[MCOR];
-local real abak2[MCOR];
-local real abak3[MCOR];
+local real *abak0 = NULL;
+local real *abak1 = NULL;
+local real *abak2 = NULL;
+local real *abak3 = NULL;
+local real *atmp2 = NULL;		/* scratch for rkstep */
 
 
 /*
@@ -45,7 +45,6 @@ real atmp1[];		/* scratch accelerations */
     int i, k;
     register real *pptr, *vptr, *aptr;
     real dt2, dts4, dt6, dts6;
-    static real atmp2[MCOR];			/* dont alloc on stack */
 
     dt2 = dt / 2;
     for (p = btab; p < btab+nb; p++) {		/* loop over bodies */
@@ -276,6 +275,13 @@ real *tptr;		/* initial time */
 fproc force;		/* acceleration calculation */
 {
     nstep = 0;					/* start counting steps */
+    if (abak0 == NULL) {			/* allocate accel history */
+	abak0 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak1 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak2 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak3 = (real *) allocate(NDIM * nb * sizeof(real));
+	atmp2 = (real *) allocate(NDIM * nb * sizeof(real));
+    }
     (*force)(btab, nb, *tptr, TRUE);		/* compute (t-dep) force */
     moveaccel(btab, nb);			/* save resulting accel */
 }
@@ -13,6 +13,7 @@
  *                plus LOTS of prototype cleanup
  *     23-jul-11  V1.5    Use log= to be able to bypass log  pjt
  *                        removed debug= to enable system key
+ *     19-oct-26  V1.6    ckpt= and savetime= for cheap checkpoints  pjt
  */
 
 #define global                                  /* don't default to extern  */
@@ -28,6 +29,8 @@ string defv[] = {		/* DEFAULT PARAMETER VALUES */
     "restart=\n			  input state and set controls ",
     "continue=\n		  input state and continue run ",
     "save=\n			  output state as code runs ",
+    "ckpt=f\n			  save= writes a compact, mappable checkpoint ",
+    "savetime=0.0\n		  minimum wall-clock minutes between saves ",
 
     /* params used only if "in", "restart" and "continue" not given */
     "nbody=128\n		  number of particles to generate ",
@@ -46,7 +49,7 @@ string defv[] = {		/* DEFAULT PARAMETER VALUES */
     "minor_freqout=32.0\n	  minor data-output frequency ",
 
     "log=-\n                      logging output",
-    "VERSION=1.5a\n		  27-jul-11 PJT",
+    "VERSION=1.6\n		  19-oct-26 PJT",
     NULL,
 };
 
@@ -77,6 +80,8 @@ void startrun(void)
     restfile = getparam("restart");
     contfile = getparam("continue");
     savefile = getparam("save");
+    ckpt = getbparam("ckpt");
+    savetime = getdparam("savetime");
     logfile = getparam("log");
     options = getparam("options");		/* set control options      */
     if (*contfile)				/* resume interrupted run   */
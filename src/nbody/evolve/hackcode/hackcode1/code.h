@@ -41,6 +41,8 @@ extern int debug_level;                 /* see dprinft.c */
 global string infile;			/* file name for snapshot input */
 global string outfile;			/* file name for snapshot output */
 global string savefile;		        /* file name for state output */
+global bool ckpt;			/* save state as mappable checkpoint */
+global real savetime;			/* min. wall-clock minutes per save */
 global string logfile;                  /* file name for log output */
 
 global real freq;			/* fundamental integration frequency */
@@ -8,11 +8,20 @@
  *	26-jun-92 fixed allocate decl. once more ... ???   	PJT
  *	24-mar-94 ansi fixes
  *      29-mar-04 prototypes
+ *	19-oct-26 compact checkpoints (ckpt=), restored by mapping	PJT
  */
 
 #include "code.h"
 #include <filestruct.h>
 #include <history.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
 
 /*	Snapshot I/O routines - special local one for diagnostics */
 #include <snapshot/snapshot.h>
@@ -23,6 +32,10 @@ local void put_snap_diagnostics(stream, int *);
 
 /* forward declarations: */
 local void diagnostics(void);
+local bool savedue(void);
+local void savecheckpoint(string file);
+local bool ischeckpoint(string file);
+local void restorecheckpoint(string file);
 
 extern double cputime(void);
 extern bool scanopt(string,string);
@@ -149,7 +162,7 @@ void output(void)
 	if (bits & PhaseSpaceBit)
 	  fprintf(logstr,"\n\tparticle data written\n");
     }
-    if (*savefile)				/* state file specified?    */
+    if (*savefile && savedue())			/* state file, and time?    */
 	savestate(savefile);			/*   save system data       */
 }
 
@@ -215,6 +228,23 @@ local void my_put_snap_diagnostics(stream outstr, int *ofptr)
     put_tes(outstr, DiagnosticsTag);
 }
 
+/*
+ * SAVEDUE: decide if the state is to be saved at this step; with
+ * savetime > 0 only when that many wall-clock minutes have passed
+ * since the last save, and at the last step of the run.
+ */
+
+local time_t lastsave = 0;		/* wall-clock time of last save */
+
+local bool savedue(void)
+{
+    if (savetime <= 0.0 || lastsave == 0)
+	return TRUE;
+    if (tnow + 1.0/freq >= tstop + 0.1/freq)	/* last step of the run?    */
+	return TRUE;
+    return difftime(time(NULL), lastsave) >= 60.0 * savetime;
+}
+
 /*
  * SAVESTATE: write current state to disk file.
  */
@@ -223,6 +253,11 @@ void savestate(string file)
 {
     stream str;
 
+    lastsave = time(NULL);
+    if (ckpt) {					/* compact checkpoint?      */
+	savecheckpoint(file);
+	return;
+    }
     str = stropen(file, "a");			/* open state output file   */
     fseek(str, 0L, 0);				/* rewind stream to origin  */
     put_string(str, "program", getargv0());
@@ -256,6 +291,10 @@ void restorestate(string file)
     stream str;
     string program, version;
 
+    if (ischeckpoint(file)) {			/* written with ckpt=t?     */
+	restorecheckpoint(file);
+	return;
+    }
     str = stropen(file, "r");			/* open state input file    */
     program = get_string(str, "program");
     version = get_string(str, "version");
@@ -282,3 +321,156 @@ void restorestate(string file)
     get_data(str, "bodytab", AnyType, bodytab, nbody, sizeof(body), 0);
     strclose(str);
 }
+
+/*
+ * CKPTHEAD: header of a checkpoint, as written with ckpt=t.  It is
+ * followed by the program, version, headline and options strings, and
+ * at offset bodyoff by the body table, all in the native binary format.
+ * The file is one contiguous block, written in one pass to a scratch
+ * file which is then renamed over the previous checkpoint, so there is
+ * always one complete checkpoint on disk; the state is restored by
+ * mapping the file, the body table is used in place.
+ */
+
+#define CKPTMAGIC  "HACKCKPT"
+#define CKPTALIGN  64
+#define CKPTROUND(n)  ((((n) + CKPTALIGN - 1) / CKPTALIGN) * CKPTALIGN)
+
+typedef struct {
+    char magic[8];			/* CKPTMAGIC, not terminated        */
+    int headsize;			/* sizeof(ckpthead)                 */
+    int bodysize;			/* sizeof(body)                     */
+    int ndim;				/* NDIM                             */
+    int nbody;				/* number of bodies                 */
+    int nstep;				/* number of micro-steps            */
+    real freq, tol, eps, fcells;	/* control parameters               */
+    real tstop, freqout, minor_freqout;
+    real tnow, tout, minor_tout;	/* state variables                  */
+    vector rmin;
+    real rsize;
+    long strsize;			/* bytes of strings after header    */
+    long bodyoff;			/* offset of body table             */
+    long filesize;			/* total size, to catch truncation  */
+} ckpthead;
+
+#define safewrite(ptr,len,str)				\
+    if ((len) > 0 && fwrite((void *) (ptr), (len), 1, str) != 1)	\
+	error("savestate: fwrite failed\n")
+
+local void savecheckpoint(string file)
+{
+    static char pad[CKPTALIGN];
+    ckpthead hd;
+    string strs[4], tmpfile;
+    stream str;
+    int i;
+
+    strs[0] = getargv0();
+    strs[1] = getparam("VERSION");
+    strs[2] = headline;
+    strs[3] = options;
+    memset(&hd, 0, sizeof(hd));
+    memcpy(hd.magic, CKPTMAGIC, sizeof(hd.magic));
+    hd.headsize = sizeof(ckpthead);
+    hd.bodysize = sizeof(body);
+    hd.ndim = NDIM;
+    hd.nbody = nbody;
+    hd.nstep = nstep;
+    hd.freq = freq;
+    hd.tol = tol;
+    hd.eps = eps;
+    hd.fcells = fcells;
+    hd.tstop = tstop;
+    hd.freqout = freqout;
+    hd.minor_freqout = minor_freqout;
+    hd.tnow = tnow;
+    hd.tout = tout;
+    hd.minor_tout = minor_tout;
+    SETV(hd.rmin, rmin);
+    hd.rsize = rsize;
+    for (i = 0; i < 4; i++)
+	hd.strsize += strlen(strs[i]) + 1;
+    hd.bodyoff = CKPTROUND(sizeof(ckpthead) + hd.strsize);
+    hd.filesize = hd.bodyoff + nbody * sizeof(body);
+
+    tmpfile = (string) allocate(strlen(file) + 5);
+    sprintf(tmpfile, "%s.tmp", file);
+    str = stropen(tmpfile, "w!");
+    safewrite(&hd, sizeof(ckpthead), str);
+    for (i = 0; i < 4; i++)
+	safewrite(strs[i], strlen(strs[i]) + 1, str);
+    safewrite(pad, hd.bodyoff - sizeof(ckpthead) - hd.strsize, str);
+    safewrite(bodytab, nbody * sizeof(body), str);
+    if (fflush(str) != 0 || fsync(fileno(str)) != 0)
+	error("savestate: cannot flush %s\n", tmpfile);
+    strclose(str);
+    if (rename(tmpfile, file) != 0)		/* replace old checkpoint   */
+	error("savestate: cannot rename %s to %s\n", tmpfile, file);
+    free(tmpfile);
+}
+
+local bool ischeckpoint(string file)
+{
+    stream str;
+    char magic[8];
+    bool ok;
+
+    str = stropen(file, "r");
+    ok = fread(magic, sizeof(magic), 1, str) == 1 &&
+	   memcmp(magic, CKPTMAGIC, sizeof(magic)) == 0;
+    strclose(str);
+    return ok;
+}
+
+local void restorecheckpoint(string file)
+{
+    struct stat st;
+    char *base;
+    ckpthead *hd;
+    string program, version;
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+	error("restorestate: cannot open %s\n", file);
+    if (st.st_size < sizeof(ckpthead))
+	error("restorestate: %s is truncated\n", file);
+#if defined(HAVE_MMAP)
+    base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+	error("restorestate: cannot map %s\n", file);
+#else
+    base = (char *) allocate(st.st_size);
+    if (read(fd, base, st.st_size) != st.st_size)
+	error("restorestate: cannot read %s\n", file);
+#endif
+    close(fd);
+    hd = (ckpthead *) base;
+    if (hd->headsize != sizeof(ckpthead) || hd->bodysize != sizeof(body) ||
+	  hd->ndim != NDIM)
+	error("restorestate: %s was written by a different build\n", file);
+    if (hd->filesize != st.st_size)
+	error("restorestate: %s is truncated\n", file);
+    program = base + sizeof(ckpthead);
+    version = program + strlen(program) + 1;
+    if (! streq(program, getargv0()) ||		/* check program, version   */
+	  ! streq(version, getparam("VERSION")))
+	warning("state file may be outdated");	/* logstr not yet open      */
+    headline = version + strlen(version) + 1;	/* strings stay in the map  */
+    options = headline + strlen(headline) + 1;
+    freq = hd->freq;				/* control parameters       */
+    tol = hd->tol;
+    eps = hd->eps;
+    fcells = hd->fcells;
+    tstop = hd->tstop;
+    freqout = hd->freqout;
+    minor_freqout = hd->minor_freqout;
+    tnow = hd->tnow;				/* state variables          */
+    tout = hd->tout;
+    minor_tout = hd->minor_tout;
+    nstep = hd->nstep;
+    SETV(rmin, hd->rmin);
+    rsize = hd->rsize;
+    nbody = hd->nbody;
+    bodytab = (bodyptr) (base + hd->bodyoff);	/* use bodies in place      */
+}
@@ -108,6 +108,16 @@ typedef struct {
 
 #define Subp(x) (((cellptr) (x))->subp)
 
+/*
+ * IACLIST: interaction list gathered by a group walk; each thread owns one.
+ */
+
+typedef struct {
+    nodeptr *list;              /* bodies and cells to interact with */
+    int nlist;                  /* entries in use */
+    int maxlist;                /* entries allocated */
+} iaclist;
+
 
 #if defined(cray)
 #define IMAX (1 << 30)
@@ -1,6 +1,8 @@
 /*
- * GRAV.C: routines to compute gravity. Public routines: hackgrav().
+ * GRAV.C: routines to compute gravity.
+ * Public routines: hackgrav(), hackwalk(), hackgrav_group().
  *	21-may-92 extra forward decl for SGI
+ *	19-oct-26 added reentrant group walk hackgrav_group()
  */
 
 #include "code.h"
@@ -129,3 +131,134 @@ local bool subdivp(nodeptr p,      /* body/cell to be tested */
     pmem = p;                                   /* remember we know them    */
     return (tolsq * drsq < dsq);                /* use geometrical rule     */
 }
+
+/*
+ * HACKGRAV_GROUP: evaluate grav field at a group of spatially close
+ * particles with a single tree walk.  A node is accepted for the whole
+ * group if the opening criterion holds for the point of the group's
+ * bounding sphere nearest to it, so each body sees at least the accuracy
+ * of hackgrav().  All state lives on the stack or in the caller's
+ * interaction list, so different groups may be done by different threads.
+ */
+
+local void walkgroup(nodeptr, real, vector, real, real, iaclist *);
+local void gravlist(bodyptr, iaclist *, int *, int *);
+
+void hackgrav_group(
+    bodyptr *gtab,			/* pointers to bodies in group */
+    int ngrp,				/* number of bodies in group */
+    iaclist *ial,			/* interaction list (per thread) */
+    int *n2b,				/* accumulates body-body terms */
+    int *nbc)				/* accumulates body-cell terms */
+{
+    vector gmin, gmax, gpos, dr;
+    real grad, drsq;
+    int i, k;
+
+    SETV(gmin, Pos(gtab[0]));			/* find bounding box        */
+    SETV(gmax, Pos(gtab[0]));
+    for (i = 1; i < ngrp; i++)
+	for (k = 0; k < NDIM; k++) {
+	    gmin[k] = MIN(gmin[k], Pos(gtab[i])[k]);
+	    gmax[k] = MAX(gmax[k], Pos(gtab[i])[k]);
+	}
+    ADDV(gpos, gmin, gmax);			/* center of group          */
+    DIVVS(gpos, gpos, 2.0);
+    grad = 0.0;					/* and its radius           */
+    for (i = 0; i < ngrp; i++) {
+	SUBV(dr, Pos(gtab[i]), gpos);
+	DOTVP(drsq, dr, dr);
+	grad = MAX(grad, drsq);
+    }
+    grad = sqrt(grad);
+    ial->nlist = 0;
+    walkgroup(troot, rsize * rsize, gpos, grad, tol * tol, ial);
+    for (i = 0; i < ngrp; i++)			/* sum list for each body   */
+	gravlist(gtab[i], ial, n2b, nbc);
+}
+
+/*
+ * WALKGROUP: recursive routine to gather the group interaction list.
+ */
+
+local void walkgroup(nodeptr p,			/* pointer into body-tree */
+		     real dsq,			/* size of box squared */
+		     vector gpos,		/* center of group */
+		     real grad,			/* radius of group */
+		     real tolsq,		/* opening tolerance squared */
+		     iaclist *ial)		/* list to append to */
+{
+    vector dr;
+    real dmin;
+    int k;
+
+    if (Type(p) == CELL) {			/* cells may be opened      */
+	SUBV(dr, Pos(p), gpos);
+	ABSV(dmin, dr);
+	dmin -= grad;				/*   nearest group point    */
+	if (dmin <= 0.0 || tolsq * dmin * dmin < dsq) {
+	    for (k = 0; k < NSUB; k++)
+		if (Subp(p)[k] != NULL)
+		    walkgroup(Subp(p)[k], dsq / 4.0, gpos, grad, tolsq, ial);
+	    return;
+	}
+    }
+    if (ial->nlist >= ial->maxlist) {		/* grow list if needed      */
+	ial->maxlist = MAX(2 * ial->maxlist, 256);
+	ial->list = (nodeptr *) reallocate(ial->list,
+					   ial->maxlist * sizeof(nodeptr));
+    }
+    ial->list[ial->nlist++] = p;
+}
+
+/*
+ * GRAVLIST: sum the interaction list for one body; same physics as gravsub.
+ */
+
+local void gravlist(bodyptr b, iaclist *ial, int *n2b, int *nbc)
+{
+    nodeptr p;
+    vector dr, ai, acc;
+    real drsq, drabs, phii, mor3, phi;
+#ifdef QUADPOLE
+    vector quaddr;
+    real dr5inv, phiquad, drquaddr;
+#endif
+    int i;
+
+    phi = 0.0;
+    CLRV(acc);
+    for (i = 0; i < ial->nlist; i++) {
+	p = ial->list[i];
+	if (p == (nodeptr) b)			/* skip self-interaction    */
+	    continue;
+	SUBV(dr, Pos(p), Pos(b));
+	DOTVP(drsq, dr, dr);
+	drsq += eps*eps;
+	drabs = sqrt(drsq);
+	phii = Mass(p) / drabs;
+	phi -= phii;
+	mor3 = phii / drsq;
+	MULVS(ai, dr, mor3);
+	ADDV(acc, acc, ai);
+	if (Type(p) == BODY) {
+	    (*n2b)++;
+	    continue;
+	}
+	(*nbc)++;
+#ifdef QUADPOLE
+	dr5inv = 1.0/(drsq * drsq * drabs);
+	MULMV(quaddr, Quad(p), dr);
+	DOTVP(drquaddr, dr, quaddr);
+	phiquad = -0.5 * dr5inv * drquaddr;
+	phi += phiquad;
+	phiquad = 5.0 * phiquad / drsq;
+	MULVS(ai, dr, phiquad);
+	SUBV(acc, acc, ai);
+	MULVS(quaddr, quaddr, dr5inv);
+	SUBV(acc, acc, quaddr);
+#endif
+    }
+    Phi(b) = phi;
+    SETV(Acc(b), acc);
+}
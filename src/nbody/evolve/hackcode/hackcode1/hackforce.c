@@ -18,6 +18,8 @@
  *	7-aug-94  V1.5a declaration of atof() fails on macro-versions (linux)
  *     20-sep-01      b NULL -> 0
  *     29-mar-04  V1.6  using 'global' macro to prevent mu;ltiple definitons
+ *     19-oct-26  V1.7  group= spatially sorted group walks, OpenMP over groups;
+ *                      the mass tree is kept for all snapshots in test=   PJT
  */
 
 #define global                                  /* don't default to extern  */
@@ -45,7 +47,8 @@ string defv[] = {
     "rmin=\n              Lower left corner of initial box [default is -rsize/2 (centered)",
     "options=mass,phase\n Output options: phase and/or mass",
     "fcells=0.75\n        Cell/body allocation ratio",
-    "VERSION=1.6a\n       28-mar-05 PJT",
+    "group=0\n           Max test bodies per group tree walk (0=one walk per body)",
+    "VERSION=1.7\n        19-oct-26 PJT",
     NULL,
 };
 
@@ -73,6 +76,8 @@ static int ntest;		/* number of test points */
 
 static real tsnap;              /* some time that was obtained from input/test */
 
+static bool newmass;            /* massdata changed since the last tree build */
+
 static stream instr=NULL;	/* input file for masses */
 static stream tststr=NULL;	/* file for which force calc done (def: in-file */
 
@@ -93,6 +98,7 @@ int input_data(void)
         get_history(instr);
         i = read_snapshot(&massdata, &nmass, instr); /* read mass coord data */
         if (i==0) return 0;
+        newmass = TRUE;
 	testdata = massdata;			/* use mass data for tests */
 	ntest = nmass;
     } else {                                /* else data from test */
@@ -100,7 +106,9 @@ int input_data(void)
             get_history(instr);            
             i=read_snapshot(&massdata, &nmass, instr);
             if (i==0) return 0;
+            newmass = TRUE;
         }
+        if (testdata != NULL) free(testdata);   /* previous test frame */
 	get_history(tststr);                    /* read (next) testdata */
 	i=read_snapshot(&testdata, &ntest, tststr);
         if (i==0) return(0);
@@ -174,46 +182,142 @@ int n2btot, nbctot;		/* body-body, body-cell interactions */
 
 real cputree, cpufcal;		/* CPU time to build tree, compute forces */
 
+local void sort_testdata(bodyptr *order);
+local void group_force(bodyptr *order, int ngroup);
+
 void force_calc(void)
 {
     real *pp, *ap;
     double cpubase;
     string *rminxstr;
-    int i;
-    bodyptr bp;
+    int i, ngroup;
+    bodyptr bp, *order;
 
     tol = getdparam("tol");
     eps = getdparam("eps");
-    rsize = getdparam("rsize");
-    rminxstr = burststring(getparam("rmin"), ", ");
-    if (xstrlen(rminxstr, sizeof(string)) < NDIM) {
-	SETVS(rmin, - rsize / 2.0);
-    } else
-	for (i = 0; i < NDIM; i++)
-	    rmin[i] = atof(rminxstr[i]);
-    dprintf(0,"initial rsize: %8f    rmin: %8f  %8f  %8f\n",
-	   rsize, rmin[0], rmin[1], rmin[2]);
     fcells = getdparam("fcells");
+    ngroup = getiparam("group");
+    if (phidata != NULL) {
+	free(phidata);
+	free(accdata);
+    }
     phidata = pp = (real *) allocate(ntest * sizeof(real));
     accdata = ap = (real *) allocate(ntest * NDIM * sizeof(real));
-    cpubase = cputime();
-    maketree(massdata, nmass);
-    cputree = cputime() - cpubase;
-    dprintf(0,"  final rsize: %8f    rmin: %8f  %8f  %8f\n",
-	   rsize, rmin[0], rmin[1], rmin[2]);
+    cputree = 0.0;
+    if (newmass) {				/* (re)build the mass tree  */
+	rsize = getdparam("rsize");
+	rminxstr = burststring(getparam("rmin"), ", ");
+	if (xstrlen(rminxstr, sizeof(string)) < NDIM) {
+	    SETVS(rmin, - rsize / 2.0);
+	} else
+	    for (i = 0; i < NDIM; i++)
+		rmin[i] = atof(rminxstr[i]);
+	dprintf(0,"initial rsize: %8f    rmin: %8f  %8f  %8f\n",
+		rsize, rmin[0], rmin[1], rmin[2]);
+	cpubase = cputime();
+	maketree(massdata, nmass);
+	cputree = cputime() - cpubase;
+	dprintf(0,"  final rsize: %8f    rmin: %8f  %8f  %8f\n",
+		rsize, rmin[0], rmin[1], rmin[2]);
+	newmass = FALSE;
+    } else
+	dprintf(1,"reusing mass tree for next test snapshot\n");
     cpubase = cputime();
     n2btot = nbctot = 0;
-    for (bp = testdata; bp < testdata+ntest; bp++) {
-	hackgrav(bp);
-	*pp++ = Phi(bp);
-	SETV(ap, Acc(bp));
-	ap += NDIM;
-	n2btot += n2bterm;
-	nbctot += nbcterm;
+    if (ngroup > 0) {				/* group walks */
+	order = (bodyptr *) allocate(ntest * sizeof(bodyptr));
+	sort_testdata(order);
+	group_force(order, ngroup);
+	free(order);
+	for (bp = testdata; bp < testdata+ntest; bp++) {
+	    *pp++ = Phi(bp);
+	    SETV(ap, Acc(bp));
+	    ap += NDIM;
+	}
+    } else {					/* one walk per body */
+	for (bp = testdata; bp < testdata+ntest; bp++) {
+	    hackgrav(bp);
+	    *pp++ = Phi(bp);
+	    SETV(ap, Acc(bp));
+	    ap += NDIM;
+	    n2btot += n2bterm;
+	    nbctot += nbcterm;
+	}
     }
     cpufcal = cputime() - cpubase;
 }
-
+
+/*
+ * SORT_TESTDATA: order test bodies along a Morton curve through the
+ * tree box, so consecutive bodies make compact groups.
+ */
+
+#define KEYBITS (60 / NDIM)		/* bits per dimension in sort key */
+
+typedef struct {
+    unsigned long long key;
+    bodyptr bp;
+} testkey;
+
+local int cmp_testkey(const void *a, const void *b)
+{
+    unsigned long long ka = ((testkey *) a)->key;
+    unsigned long long kb = ((testkey *) b)->key;
+
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+local void sort_testdata(bodyptr *order)
+{
+    testkey *tk;
+    unsigned long long key, ix[NDIM];
+    real xsc;
+    int i, k, l;
+
+    tk = (testkey *) allocate(ntest * sizeof(testkey));
+#pragma omp parallel for private(k,l,key,ix,xsc)
+    for (i = 0; i < ntest; i++) {
+	for (k = 0; k < NDIM; k++) {		/* clamp into the tree box  */
+	    xsc = (Pos(testdata+i)[k] - rmin[k]) / rsize;
+	    xsc = MAX(0.0, MIN(xsc, 1.0));
+	    ix[k] = (unsigned long long) (xsc * ((1 << KEYBITS) - 1));
+	}
+	key = 0;				/* interleave the bits      */
+	for (l = KEYBITS-1; l >= 0; l--)
+	    for (k = 0; k < NDIM; k++)
+		key = (key << 1) | ((ix[k] >> l) & 1);
+	tk[i].key = key;
+	tk[i].bp = testdata + i;
+    }
+    qsort(tk, ntest, sizeof(testkey), cmp_testkey);
+    for (i = 0; i < ntest; i++)
+	order[i] = tk[i].bp;
+    free(tk);
+}
+
+/*
+ * GROUP_FORCE: walk the tree once per group of ngroup consecutive sorted
+ * bodies; groups are shared out over threads, each with its own list.
+ */
+
+local void group_force(bodyptr *order, int ngroup)
+{
+    int i, n2b = 0, nbc = 0;
+    iaclist ial;
+
+#pragma omp parallel private(ial) reduction(+:n2b,nbc)
+    {
+	ial.list = NULL;
+	ial.nlist = ial.maxlist = 0;
+#pragma omp for schedule(dynamic)
+	for (i = 0; i < ntest; i += ngroup)
+	    hackgrav_group(order + i, MIN(ngroup, ntest - i), &ial, &n2b, &nbc);
+	if (ial.list != NULL) free(ial.list);
+    }
+    n2btot = n2b;
+    nbctot = nbc;
+}
+
 stream outstr=NULL;
 
 void out_result(void)
@@ -14,6 +14,7 @@ void restorestate(string file);
 /* grav.c */
 void hackgrav(bodyptr p);
 void hackwalk(proc sub);
+void hackgrav_group(bodyptr *gtab, int ngrp, iaclist *ial, int *n2b, int *nbc);
 
 /* hackforce.c */
 int  input_data(void);
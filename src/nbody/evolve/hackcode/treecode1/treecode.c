@@ -4,6 +4,8 @@
 /* 22-jun-01   NEMOfied for NEMO V3                                         */
 /* 22-feb-04   dtime->dtimes                                                */
 /* 25-apr-04   implemented USE_NEMO_IO                                      */ 
+/* 19-oct-26   V1.5 parallel force walk (see treegrav.c)                    */
+/* 19-oct-26   V1.6 mappable state files, restore= enabled, savetime=       */
 /****************************************************************************/
 
 #include <stdinc.h>
@@ -46,7 +48,8 @@ string defv[] = {
     "seed=123\n                  Random number seed for test run",
     "save=\n                     Write state file as code runs",
     "restore=\n                  Continue run from state file",
-    "VERSION=1.4.2\n             25-apr-04 PJT",
+    "savetime=0.0\n              Minimum wall-clock minutes between saves",
+    "VERSION=1.6\n               19-oct-26 PJT",
     NULL,
 };
 
@@ -140,6 +143,7 @@ local void startrun(void)
     infile = getparam("in");                    /* set I/O file names       */
     outfile = getparam("out");
     savefile = getparam("save");
+    savetime = getdparam("savetime");
     if (strnull(getparam("restore"))) {         /* if starting a new run    */
         eps = getdparam("eps");                 /* get input parameters     */
 #if defined(USEFREQ)
@@ -172,32 +176,17 @@ local void startrun(void)
         nstep = 0;                              /* begin counting steps     */
         tout = tnow;                            /* schedule first output    */
     } else {                                    /* else restart old run     */
-#if 1
-      error("restore= not yet implemented for NEMO version");
-#else
         restorestate(getparam("restore"));      /* read in state file       */
-        if (getparamstat("eps") & ARGPARAM)     /* if given, set new params */
-            eps = getdparam("eps");
-#if !defined(QUICKSCAN)
-        if (getparamstat("theta") & ARGPARAM)
-            theta = getdparam("theta");
-#endif
-        if (getparamstat("usequad") & ARGPARAM)
-            usequad = getbparam("usequad");
-        if (getparamstat("options") & ARGPARAM)
-            options = getparam("options");
-        if (getparamstat("tstop") & ARGPARAM)
-            tstop = getdparam("tstop");
+        tstop = getdparam("tstop");             /* take new output controls */
+        options = getparam("options");
 #if defined(USEFREQ)
-        if (getparamstat("freqout") & ARGPARAM)
-            freqout = getdparam("freqout");
+        freqout = getdparam("freqout");
         if (scanopt(options, "new-tout"))       /* if output time reset     */
             tout = tnow + 1 / freqout;          /* then offset from now     */
 #else
-	dtout = getdparam("dtout");
+        dtout = getdparam("dtout");
         if (scanopt(options, "new-tout"))       /* if output time reset     */
             tout = tnow + dtout;                /* then offset from now     */
-#endif
 #endif
     }
 }
@@ -18,6 +18,8 @@ global string outfile;                  /* file name for snapshot output    */
 
 global string savefile;                 /* file name for state output       */
 
+global real savetime;                   /* min. wall-clock minutes per save */
+
 #if defined(USEFREQ)
 
 global real freq;                       /* basic integration frequency      */
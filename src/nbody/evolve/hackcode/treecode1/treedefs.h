@@ -30,6 +30,7 @@ typedef struct _node {
     real mass;                  /* total mass of node */
     vector pos;                 /* position of node */
     struct _node *next;         /* link to next force calc */
+    int cost;                   /* interactions: body last step, cell sum */
 } node, *nodeptr;
 
 #define Type(x)   (((nodeptr) (x))->type)
@@ -37,6 +38,7 @@ typedef struct _node {
 #define Mass(x)   (((nodeptr) (x))->mass)
 #define Pos(x)    (((nodeptr) (x))->pos)
 #define Next(x)   (((nodeptr) (x))->next)
+#define Cost(x)   (((nodeptr) (x))->cost)
 
 #define BODY 01                 /* type code for bodies */
 #define CELL 02                 /* type code for cells */
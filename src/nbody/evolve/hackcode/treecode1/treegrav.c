@@ -2,6 +2,7 @@
 /* TREEGRAV.C: routines to compute gravity. Public routines: gravcalc().    */
 /* Copyright (c) 2001 by Joshua E. Barnes, Honolulu, Hawai`i.               */
 /* 22-jun-01  adapted for NEMO                                              */
+/* 19-oct-26  reentrant walk state, OpenMP over cost-zone tasks             */
 /****************************************************************************/
 
 #include <stdinc.h>
@@ -9,16 +10,57 @@
 #include <vectmath.h>
 #include "treedefs.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/*
+ * WALKSTATE: active and interaction lists, plus counters, of one walk.
+ * Each thread owns one, so walks of different subtrees can run at once.
+ */
+
+typedef struct {
+    nodeptr *active;                            /* list of nodes tested     */
+    cellptr interact;                           /* list of interactions     */
+    int actmax;                                 /* max length of active     */
+    int nbbcalc;                                /* body-body interactions   */
+    int nbccalc;                                /* body-cell interactions   */
+} walkstate;
+
+/*
+ * WALKTASK: a subtree walk started with a copy of the lists its ancestors
+ * had built up; tasks are cut from the top of the tree by splittree().
+ */
+
+typedef struct {
+    nodeptr node;                               /* node to walk from        */
+    real psize;                                 /* size of node's cell      */
+    vector pmid;                                /* midpoint of node's cell  */
+    nodeptr *act;                               /* active list to test      */
+    int nact;
+    cellptr cells;                              /* accepted cells so far    */
+    int ncells;
+    cellptr bodies;                             /* accepted bodies so far   */
+    int nbodies;
+    int cost;                                   /* estimated cost of walk   */
+} walktask;
+
 /* Local routines to perform force calculations. */
 
-local void walktree(nodeptr *, nodeptr *, cellptr, cellptr,
+local void walktree(walkstate *, nodeptr *, nodeptr *, cellptr, cellptr,
                     nodeptr, real, vector);
 local bool accept(nodeptr, real, vector);
-local void walksub(nodeptr *, nodeptr *, cellptr, cellptr,
+local void walksub(walkstate *, nodeptr *, nodeptr *, cellptr, cellptr,
                    nodeptr, real, vector);
-local void gravsum(bodyptr, cellptr, cellptr);
+local void gravsum(walkstate *, bodyptr, cellptr, cellptr);
 local void sumnode(cellptr, cellptr, vector, real *, vector);
 local void sumcell(cellptr, cellptr, vector, real *, vector);
+local int  sumcost(nodeptr);
+local void splittree(walkstate *, nodeptr *, nodeptr *, cellptr, cellptr,
+                     nodeptr, real, vector);
+local void newtask(walkstate *, nodeptr *, nodeptr *, cellptr, cellptr,
+                   nodeptr, real, vector);
+local void runtask(walkstate *, walktask *);
 
 /* Lists of active nodes and interactions. */
 
@@ -26,36 +68,98 @@ local void sumcell(cellptr, cellptr, vector, real *, vector);
 #  define FACTIVE  0.75                         /* active list fudge factor */
 #endif
 
+#if !defined(NTASKFAC)
+#  define NTASKFAC  16                          /* tasks per thread target  */
+#endif
+
 local int actlen;                               /* length as allocated      */
 
-local nodeptr *active;                          /* list of nodes tested     */
+local int nthread;                              /* threads to walk with     */
 
-local cellptr interact;                         /* list of interactions     */
+local walktask *tasktab;                        /* tasks cut from the tree  */
+local int ntask;                                /* number of tasks in use   */
+local int maxtask;                              /* length as allocated      */
+local int taskcost;                             /* split nodes costing more */
 
 /*
- * GRAVCALC: perform force calculation on all particles.
+ * GRAVCALC: perform force calculation on all particles.  With more than
+ * one thread the top of the tree is cut into tasks, which are then dealt
+ * out in tree order as contiguous zones of equal cost, using the number
+ * of interactions each body needed in the previous force calculation.
  */
 
 void gravcalc(void)
 {
     double cpustart;
     vector rmid;
+    walkstate *wtab, *ws;
+    int i, t, totcost, zcost;
 
     actlen = FACTIVE * 216 * tdepth;            /* estimate list length     */
 #if !defined(QUICKSCAN)
     actlen = actlen * rpow(theta, -2.5);        /* allow for opening angle  */
 #endif
-    active = (nodeptr *) allocate(actlen * sizeof(nodeptr));
-    interact = (cellptr) allocate(actlen * sizeof(cell));
+#if defined(_OPENMP)
+    nthread = omp_get_max_threads();
+#else
+    nthread = 1;
+#endif
+    wtab = (walkstate *) allocate(nthread * sizeof(walkstate));
+    for (t = 0; t < nthread; t++) {
+        wtab[t].active = (nodeptr *) allocate(actlen * sizeof(nodeptr));
+        wtab[t].interact = (cellptr) allocate(actlen * sizeof(cell));
+    }
     cpustart = cputime();                       /* record time, less alloc  */
-    actmax = nbbcalc = nbccalc = 0;             /* zero cumulative counters */
-    active[0] = (nodeptr) root;                 /* initialize active list   */
+    ws = &wtab[0];
     CLRV(rmid);                                 /* set center of root cell  */
-    walktree(active, active + 1, interact, interact + actlen,
-             (nodeptr) root, rsize, rmid);      /* scan tree, update forces */
+    ws->active[0] = (nodeptr) root;             /* initialize active list   */
+    ntask = 0;
+    if (nthread == 1)                           /* serial: single walk      */
+        walktree(ws, ws->active, ws->active + 1, ws->interact,
+                 ws->interact + actlen, (nodeptr) root, rsize, rmid);
+    else {                                      /* parallel: cut tasks      */
+        totcost = sumcost((nodeptr) root);      /* cost of all updates      */
+        taskcost = totcost / (NTASKFAC * nthread);
+        maxtask = NTASKFAC * nthread;
+        tasktab = (walktask *) allocate(maxtask * sizeof(walktask));
+        splittree(ws, ws->active, ws->active + 1, ws->interact,
+                  ws->interact + actlen, (nodeptr) root, rsize, rmid);
+        zcost = 0;                              /* assign cost zones        */
+        for (i = 0; i < ntask; i++) {
+            t = ((double) zcost * nthread) / MAX(totcost, 1);
+            zcost += tasktab[i].cost;
+            tasktab[i].cost = MIN(t, nthread - 1);  /* reuse as zone index  */
+        }
+#pragma omp parallel private(i, t)
+        {
+#if defined(_OPENMP)
+            t = omp_get_thread_num();
+#else
+            t = 0;
+#endif
+            for (i = 0; i < ntask; i++)         /* walk tasks in my zone    */
+                if (tasktab[i].cost == t)
+                    runtask(&wtab[t], &tasktab[i]);
+        }
+        for (i = 0; i < ntask; i++) {
+            free(tasktab[i].act);
+            free(tasktab[i].cells);
+        }
+        free(tasktab);
+        dprintf(1, "gravcalc: %d tasks in %d cost zones\n", ntask, nthread);
+    }
+    actmax = nbbcalc = nbccalc = 0;             /* sum cumulative counters  */
+    for (t = 0; t < nthread; t++) {
+        actmax = MAX(actmax, wtab[t].actmax);
+        nbbcalc += wtab[t].nbbcalc;
+        nbccalc += wtab[t].nbccalc;
+    }
     cpuforce = cputime() - cpustart;            /* store CPU time w/o alloc */
-    free(active);
-    free(interact);
+    for (t = 0; t < nthread; t++) {
+        free(wtab[t].active);
+        free(wtab[t].interact);
+    }
+    free(wtab);
 }
 
 /*
@@ -63,8 +167,9 @@ void gravcalc(void)
  * list level-by-level and computing the resulting force on each body.
  */
 
-local void walktree(nodeptr *aptr, nodeptr *nptr, cellptr cptr, cellptr bptr,
-                    nodeptr p, real psize, vector pmid)
+local void walktree(walkstate *ws, nodeptr *aptr, nodeptr *nptr,
+                    cellptr cptr, cellptr bptr, nodeptr p, real psize,
+                    vector pmid)
 {
     nodeptr *np, *ap, q;
     int actsafe;
@@ -80,7 +185,7 @@ local void walktree(nodeptr *aptr, nodeptr *nptr, cellptr cptr, cellptr bptr,
                     SETM(Quad(cptr), Quad(*ap));
                     cptr++;                     /* and bump cell array ptr  */
                 } else {                        /* else it fails the test   */
-                    if (np - active >= actsafe) /* check list has room      */
+                    if (np - ws->active >= actsafe)
                         error("walktree: active list overflow\n");
                     for (q = More(*ap); q != Next(*ap); q = Next(q))
                                                 /* loop over all subcells   */
@@ -92,14 +197,16 @@ local void walktree(nodeptr *aptr, nodeptr *nptr, cellptr cptr, cellptr bptr,
                     Mass(bptr) = Mass(*ap);     /* and copy data to array   */
                     SETV(Pos(bptr), Pos(*ap));
                 }
-        actmax = MAX(actmax, np - active);      /* keep track of max active */
+        ws->actmax = MAX(ws->actmax, np - ws->active);
+                                                /* keep track of max active */
         if (np != nptr)                         /* if new actives listed    */
-            walksub(nptr, np, cptr, bptr, p, psize, pmid);
+            walksub(ws, nptr, np, cptr, bptr, p, psize, pmid);
                                                 /* then visit next level    */
         else {                                  /* else no actives left, so */
             if (Type(p) != BODY)                /* must have found a body   */
                 error("walktree: recursion terminated with cell\n");
-            gravsum((bodyptr) p, cptr, bptr);   /* sum force on the body    */
+            gravsum(ws, (bodyptr) p, cptr, bptr);
+                                                /* sum force on the body    */
         }
     }
 }
@@ -161,8 +268,9 @@ local bool accept(nodeptr c, real psize, vector pmid)
  * WALKSUB: test next level's active list against subnodes of p.
  */
 
-local void walksub(nodeptr *nptr, nodeptr *np, cellptr cptr, cellptr bptr,
-                   nodeptr p, real psize, vector pmid)
+local void walksub(walkstate *ws, nodeptr *nptr, nodeptr *np,
+                   cellptr cptr, cellptr bptr, nodeptr p, real psize,
+                   vector pmid)
 {
     real poff;
     nodeptr q;
@@ -175,13 +283,13 @@ local void walksub(nodeptr *nptr, nodeptr *np, cellptr cptr, cellptr bptr,
                                                 /* loop over all subcells   */
             for (k = 0; k < NDIM; k++)          /* locate each's midpoint   */
                 nmid[k] = pmid[k] + (Pos(q)[k] < pmid[k] ? - poff : poff);
-            walktree(nptr, np, cptr, bptr, q, psize / 2, nmid);
+            walktree(ws, nptr, np, cptr, bptr, q, psize / 2, nmid);
                                                 /* recurse on subcell       */
         }
     } else {                                    /* extend virtual tree      */
         for (k = 0; k < NDIM; k++)              /* locate next midpoint     */
             nmid[k] = pmid[k] + (Pos(p)[k] < pmid[k] ? - poff : poff);
-        walktree(nptr, np, cptr, bptr, p, psize / 2, nmid);
+        walktree(ws, nptr, np, cptr, bptr, p, psize / 2, nmid);
                                                 /* and search next level    */
     }
 }
@@ -190,7 +298,7 @@ local void walksub(nodeptr *nptr, nodeptr *np, cellptr cptr, cellptr bptr,
  * GRAVSUM: compute gravitational field at body p0.
  */
 
-local void gravsum(bodyptr p0, cellptr cptr, cellptr bptr)
+local void gravsum(walkstate *ws, bodyptr p0, cellptr cptr, cellptr bptr)
 {
     vector pos0, acc0;
     real phi0;
@@ -199,17 +307,19 @@ local void gravsum(bodyptr p0, cellptr cptr, cellptr bptr)
     phi0 = 0.0;                                 /* init total potential     */
     CLRV(acc0);                                 /* and total acceleration   */
     if (usequad)                                /* if using quad moments    */
-        sumcell(interact, cptr, pos0, &phi0, acc0);
+        sumcell(ws->interact, cptr, pos0, &phi0, acc0);
                                                 /* sum cell forces w quads  */
     else                                        /* not using quad moments   */
-        sumnode(interact, cptr, pos0, &phi0, acc0);
+        sumnode(ws->interact, cptr, pos0, &phi0, acc0);
                                                 /* sum cell forces wo quads */
-    sumnode(bptr, interact + actlen, pos0, &phi0, acc0);
+    sumnode(bptr, ws->interact + actlen, pos0, &phi0, acc0);
                                                 /* sum forces from bodies   */
     Phi(p0) = phi0;                             /* store total potential    */
     SETV(Acc(p0), acc0);                        /* and total acceleration   */
-    nbbcalc += interact + actlen - bptr;        /* count body-body forces   */
-    nbccalc += cptr - interact;                 /* count body-cell forces   */
+    Cost(p0) = (ws->interact + actlen - bptr) + (cptr - ws->interact);
+                                                /* remember work for zones  */
+    ws->nbbcalc += ws->interact + actlen - bptr;/* count body-body forces   */
+    ws->nbccalc += cptr - ws->interact;         /* count body-cell forces   */
 }
 
 /*
@@ -262,3 +372,117 @@ local void sumcell(cellptr start, cellptr finish,
         ADDMULVS2(acc0, dr, mr3i, qdr, -dr5i);  /* add mono and quad acc    */
     }
 }
+
+/*
+ * SUMCOST: sum the previous cost of updated bodies below node p into
+ * the Cost() of each cell; bodies never computed count as one.
+ */
+
+local int sumcost(nodeptr p)
+{
+    nodeptr q;
+    int cost;
+
+    if (Type(p) == BODY)
+        return (Update(p) ? MAX(Cost(p), 1) : 0);
+    cost = 0;
+    for (q = More(p); q != Next(p); q = Next(q))
+        cost += sumcost(q);
+    Cost(p) = cost;
+    return (cost);
+}
+
+/*
+ * SPLITTREE: same descent as walktree, but nodes which are cheap enough
+ * are not walked; a task with a copy of the current lists is made instead.
+ */
+
+local void splittree(walkstate *ws, nodeptr *aptr, nodeptr *nptr,
+                     cellptr cptr, cellptr bptr, nodeptr p, real psize,
+                     vector pmid)
+{
+    nodeptr *np, *ap, q;
+    real poff;
+    vector nmid;
+    int k;
+
+    if (! Update(p))                            /* nothing to do here       */
+        return;
+    if (Type(p) == BODY || Cost(p) <= taskcost) {
+        newtask(ws, aptr, nptr, cptr, bptr, p, psize, pmid);
+        return;
+    }
+    np = nptr;                                  /* as in walktree           */
+    for (ap = aptr; ap < nptr; ap++)
+        if (Type(*ap) == CELL) {
+            if (accept(*ap, psize, pmid)) {
+                Mass(cptr) = Mass(*ap);
+                SETV(Pos(cptr), Pos(*ap));
+                SETM(Quad(cptr), Quad(*ap));
+                cptr++;
+            } else {
+                if (np - ws->active >= actlen - NSUB)
+                    error("splittree: active list overflow\n");
+                for (q = More(*ap); q != Next(*ap); q = Next(q))
+                    *np++= q;
+            }
+        } else if (*ap != p) {
+            --bptr;
+            Mass(bptr) = Mass(*ap);
+            SETV(Pos(bptr), Pos(*ap));
+        }
+    poff = psize / 4;                           /* p is a cell, so fanout   */
+    for (q = More(p); q != Next(p); q = Next(q)) {
+        for (k = 0; k < NDIM; k++)
+            nmid[k] = pmid[k] + (Pos(q)[k] < pmid[k] ? - poff : poff);
+        splittree(ws, nptr, np, cptr, bptr, q, psize / 2, nmid);
+    }
+}
+
+/*
+ * NEWTASK: append a task for node p with the lists as they stand.
+ */
+
+local void newtask(walkstate *ws, nodeptr *aptr, nodeptr *nptr,
+                   cellptr cptr, cellptr bptr, nodeptr p, real psize,
+                   vector pmid)
+{
+    walktask *wt;
+
+    if (ntask == maxtask) {
+        maxtask *= 2;
+        tasktab = (walktask *) reallocate(tasktab, maxtask * sizeof(walktask));
+    }
+    wt = &tasktab[ntask++];
+    wt->node = p;
+    wt->psize = psize;
+    SETV(wt->pmid, pmid);
+    wt->nact = nptr - aptr;
+    wt->act = (nodeptr *) allocate(wt->nact * sizeof(nodeptr));
+    memcpy(wt->act, aptr, wt->nact * sizeof(nodeptr));
+    wt->ncells = cptr - ws->interact;
+    wt->nbodies = ws->interact + actlen - bptr;
+    wt->cells = (cellptr) allocate((wt->ncells + wt->nbodies) * sizeof(cell));
+    wt->bodies = wt->cells + wt->ncells;
+    memcpy(wt->cells, ws->interact, wt->ncells * sizeof(cell));
+    memcpy(wt->bodies, bptr, wt->nbodies * sizeof(cell));
+    wt->cost = Type(p) == BODY ? MAX(Cost(p), 1) : Cost(p);
+}
+
+/*
+ * RUNTASK: restore a task's lists into walk state ws and finish its walk;
+ * the lists keep their order, so forces equal those of the serial walk.
+ */
+
+local void runtask(walkstate *ws, walktask *wt)
+{
+    cellptr cptr, bptr;
+
+    memcpy(ws->active, wt->act, wt->nact * sizeof(nodeptr));
+    memcpy(ws->interact, wt->cells, wt->ncells * sizeof(cell));
+    cptr = ws->interact + wt->ncells;
+    bptr = ws->interact + actlen - wt->nbodies;
+    memcpy(bptr, wt->bodies, wt->nbodies * sizeof(cell));
+    walktree(ws, ws->active, ws->active + wt->nact, cptr, bptr,
+             wt->node, wt->psize, wt->pmid);
+}
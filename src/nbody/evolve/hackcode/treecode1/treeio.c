@@ -5,6 +5,7 @@
 /* 22-jun-01  adapted for NEMO                                              */
 /* 22-feb-04  dtime->dtimes                                                 */
 /* 25-apr-04  USE_NEMO_IO option
+/* 19-oct-26  state file is one mappable block, replaced by rename          */
 /****************************************************************************/
 
 #include <stdinc.h>
@@ -16,6 +17,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
 
 #if defined(USE_NEMO_IO)
 #include <filestruct.h>
@@ -47,6 +54,8 @@ local vector cmpos;                             /* center of mass position  */
 local vector cmvel;                             /* center of mass velocity  */
 local vector amvec;                             /* angular momentum vector  */
 
+local time_t lastsave = 0;                      /* wall-clock of last save  */
+
 /*
  * INPUTDATA: read initial conditions from input file.
  */
@@ -419,109 +428,173 @@ local void out_vector(stream str, vector vec)
 #endif
 }
 
+/*
+ * STATEHEAD: header of a state file.  It is followed by the program,
+ * version and options strings and, at offset bodyoff, by the body table,
+ * all in the native binary format.  The file is written in one pass to
+ * a scratch file, which is then renamed over the previous one, so there
+ * is always one complete state file on disk; restorestate maps the file
+ * and uses the body table in place.
+ */
+
+#define STATEMAGIC  "TREECKPT"
+#define STATEALIGN  64
+#define STATEROUND(n)  ((((n) + STATEALIGN - 1) / STATEALIGN) * STATEALIGN)
+
+typedef struct {
+    char magic[8];                              /* STATEMAGIC, no null      */
+    int headsize;                               /* sizeof(statehead)        */
+    int bodysize;                               /* sizeof(body)             */
+    int ndim;                                   /* NDIM                     */
+    int nbody;                                  /* number of bodies         */
+    int nstep;                                  /* number of time-steps     */
+    bool usequad;                               /* use quad moments         */
+#if defined(USEFREQ)
+    real freq, freqout;                         /* step and output freqs    */
+#else
+    real dtimes, dtout;                         /* step and output times    */
+#endif
+#if !defined(QUICKSCAN)
+    real theta;                                 /* force accuracy parameter */
+#endif
+    real eps, tstop, tnow, tout, rsize;
+    long strsize;                               /* bytes of strings         */
+    long bodyoff;                               /* offset of body table     */
+    long filesize;                              /* catches truncated files  */
+} statehead;
+
 /*
  * SAVESTATE: write current state to disk file.
  */
 
-#define safewrite(ptr,len,str)                  \
-    if (fwrite((void *) ptr, len, 1, str) != 1) \
+#define safewrite(ptr,len,str)                                  \
+    if ((len) > 0 && fwrite((void *) (ptr), (len), 1, str) != 1) \
         error("savestate: fwrite failed\n")
 
 void savestate(string pattern)
 {
-    char namebuf[256];
+    static char pad[STATEALIGN];
+    char namebuf[256], tmpbuf[256];
+    statehead hd;
+    string strs[3];
     stream str;
-    int nchars;
-
-    sprintf(namebuf, pattern, nstep & 1);       /* construct alternate name */
-    str = stropen(namebuf, "w!");
-    nchars = strlen(getargv0()) + 1;
-    safewrite(&nchars, sizeof(int), str);
-    safewrite(getargv0(), nchars * sizeof(char), str);
-    nchars = strlen(getversion()) + 1;
-    safewrite(&nchars, sizeof(int), str);
-    safewrite(getversion(), nchars * sizeof(char), str);
+    int i;
+
+    if (savetime > 0.0 && lastsave != 0 &&      /* not every step, and not  */
 #if defined(USEFREQ)
-    safewrite(&freq, sizeof(real), str);
+          tstop - tnow > 0.01/freq &&           /* the last one of the run? */
 #else
-    safewrite(&dtimes, sizeof(real), str);
-#endif
-#if !defined(QUICKSCAN)
-    safewrite(&theta, sizeof(real), str);
+          tstop - tnow > 0.01 * dtimes &&
 #endif
-    safewrite(&usequad, sizeof(bool), str);
-    safewrite(&eps, sizeof(real), str);
-    nchars = strlen(options) + 1;
-    safewrite(&nchars, sizeof(int), str);
-    safewrite(options, nchars * sizeof(char), str);
-    safewrite(&tstop, sizeof(real), str);
+          difftime(time(NULL), lastsave) < 60.0 * savetime)
+        return;
+    lastsave = time(NULL);
+    strs[0] = getargv0();
+    strs[1] = getversion();
+    strs[2] = options;
+    memset(&hd, 0, sizeof(hd));
+    memcpy(hd.magic, STATEMAGIC, sizeof(hd.magic));
+    hd.headsize = sizeof(statehead);
+    hd.bodysize = sizeof(body);
+    hd.ndim = NDIM;
+    hd.nbody = nbody;
+    hd.nstep = nstep;
+    hd.usequad = usequad;
 #if defined(USEFREQ)
-    safewrite(&freqout, sizeof(real), str);
+    hd.freq = freq;
+    hd.freqout = freqout;
 #else
-    safewrite(&dtout, sizeof(real), str);
+    hd.dtimes = dtimes;
+    hd.dtout = dtout;
 #endif
-    safewrite(&tnow, sizeof(real), str);
-    safewrite(&tout, sizeof(real), str);
-    safewrite(&nstep, sizeof(int), str);
-    safewrite(&rsize, sizeof(real), str);
-    safewrite(&nbody, sizeof(int), str);
+#if !defined(QUICKSCAN)
+    hd.theta = theta;
+#endif
+    hd.eps = eps;
+    hd.tstop = tstop;
+    hd.tnow = tnow;
+    hd.tout = tout;
+    hd.rsize = rsize;
+    for (i = 0; i < 3; i++)
+        hd.strsize += strlen(strs[i]) + 1;
+    hd.bodyoff = STATEROUND(sizeof(statehead) + hd.strsize);
+    hd.filesize = hd.bodyoff + nbody * sizeof(body);
+    if (snprintf(namebuf, sizeof(namebuf), pattern, nstep & 1)
+          >= sizeof(namebuf))                   /* construct alternate name */
+        error("savestate: name from %s too long\n", pattern);
+    if (snprintf(tmpbuf, sizeof(tmpbuf), "%s.tmp", namebuf) >= sizeof(tmpbuf))
+        error("savestate: name %s.tmp too long\n", namebuf);
+    str = stropen(tmpbuf, "w!");
+    safewrite(&hd, sizeof(statehead), str);
+    for (i = 0; i < 3; i++)
+        safewrite(strs[i], strlen(strs[i]) + 1, str);
+    safewrite(pad, hd.bodyoff - sizeof(statehead) - hd.strsize, str);
     safewrite(bodytab, nbody * sizeof(body), str);
-    fclose(str);
+    if (fflush(str) != 0 || fsync(fileno(str)) != 0)
+        error("savestate: cannot flush %s\n", tmpbuf);
+    strclose(str);
+    if (rename(tmpbuf, namebuf) != 0)           /* replace old state file   */
+        error("savestate: cannot rename %s to %s\n", tmpbuf, namebuf);
 }
 
 /*
  * RESTORESTATE: restore state from disk file.
  */
 
-#define saferead(ptr,len,str)                  \
-    if (fread((void *) ptr, len, 1, str) != 1) \
-        error("restorestate: fread failed\n")
-
 void restorestate(string file)
 {
-    stream str;
-    int nchars;
+    struct stat st;
+    char *base;
+    statehead *hd;
     string program, version;
-
-    str = stropen(file, "r");
-    saferead(&nchars, sizeof(int), str);
-    program = (string) allocate(nchars * sizeof(char));
-    saferead(program, nchars * sizeof(char), str);
-    saferead(&nchars, sizeof(int), str);
-    version = (string) allocate(nchars * sizeof(char));
-    saferead(version, nchars * sizeof(char), str);
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+        error("restorestate: cannot open %s\n", file);
+    if (st.st_size < sizeof(statehead))
+        error("restorestate: %s is truncated\n", file);
+#if defined(HAVE_MMAP)
+    base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+        error("restorestate: cannot map %s\n", file);
+#else
+    base = (char *) allocate(st.st_size);
+    if (read(fd, base, st.st_size) != st.st_size)
+        error("restorestate: cannot read %s\n", file);
+#endif
+    close(fd);
+    hd = (statehead *) base;
+    if (memcmp(hd->magic, STATEMAGIC, sizeof(hd->magic)) != 0)
+        error("restorestate: %s is not a state file\n", file);
+    if (hd->headsize != sizeof(statehead) || hd->bodysize != sizeof(body) ||
+          hd->ndim != NDIM)
+        error("restorestate: %s was written by a different build\n", file);
+    if (hd->filesize != st.st_size)
+        error("restorestate: %s is truncated\n", file);
+    program = base + sizeof(statehead);
+    version = program + strlen(program) + 1;
     if (! streq(program, getargv0()) ||         /* check program, version   */
           ! streq(version, getversion()))
         printf("warning: state file may be outdated\n\n");
+    options = version + strlen(version) + 1;    /* string stays in the map  */
+    usequad = hd->usequad;
 #if defined(USEFREQ)
-    saferead(&freq, sizeof(real), str);
+    freq = hd->freq;
+    freqout = hd->freqout;
 #else
-    saferead(&dtimes, sizeof(real), str);
+    dtimes = hd->dtimes;
+    dtout = hd->dtout;
 #endif
 #if !defined(QUICKSCAN)
-    saferead(&theta, sizeof(real), str);
+    theta = hd->theta;
 #endif
-    saferead(&usequad, sizeof(bool), str);
-    saferead(&eps, sizeof(real), str);
-    saferead(&nchars, sizeof(int), str);
-    options = (string) allocate(nchars * sizeof(char));
-    saferead(options, nchars * sizeof(char), str);
-    saferead(&tstop, sizeof(real), str);
-#if defined(USEFREQ)
-    saferead(&freqout, sizeof(real), str);
-#else
-    saferead(&dtout, sizeof(real), str);
-#endif
-    saferead(&tnow, sizeof(real), str);
-    saferead(&tout, sizeof(real), str);
-    saferead(&nstep, sizeof(int), str);
-    saferead(&rsize, sizeof(real), str);
-    saferead(&nbody, sizeof(int), str);
-    bodytab = (bodyptr) allocate(nbody * sizeof(body));
-    saferead(bodytab, nbody * sizeof(body), str);
-    fclose(str);
+    eps = hd->eps;
+    tstop = hd->tstop;
+    tnow = hd->tnow;
+    tout = hd->tout;
+    nstep = hd->nstep;
+    rsize = hd->rsize;
+    nbody = hd->nbody;
+    bodytab = (bodyptr) (base + hd->bodyoff);   /* use bodies in place      */
 }
-
-
-
-
@@ -1,16 +1,21 @@
 /* differentiate.c - BIGNUMBER, d_system, deriv_system, 
-                     init_deriv_system, n_square_interaction, 
+                     init_deriv_system, n_square_interaction, n_row_interaction,
                      push_system, reg_interaction, tree_interaction */
 
 /*
  *  differentiate.c:  contains helper functions for  integrate.c 
  *
  *      June 1987  -  Piet Hut  @ Inst. f. Adv. Study, Princeton, NJ 08540, USA
+ *      Oct  2026  -  force=direct|tree at runtime, rows in parallel     PJT
  */
 
 #include  "newton0.h"
+#if defined(_OPENMP)
+#include  <omp.h>
+#endif
 
 static void n_square_interaction(systptr sys, specptr specs);
+static void n_row_interaction(systptr sys, specptr specs);
 static void tree_interaction(systptr sys, specptr specs);
 static void reg_interaction(systptr sys, specptr specs);
 
@@ -98,7 +103,10 @@ specptr specs;
 # endif
 #endif
 #ifdef TREE
-    tree_interaction(sys, specs);
+    if (streq("tree", Forcemethod(specs)))
+        tree_interaction(sys, specs);
+    else
+        n_square_interaction(sys, specs);
 #endif
 #ifdef REGULARIZATION                      /* the following line is the only */
     n_square_interaction(sys, specs);      /* difference with deriv_system() */
@@ -135,7 +143,10 @@ specptr specs;
 # endif
 #endif
 #ifdef TREE
-    tree_interaction(sys, specs);
+    if (streq("tree", Forcemethod(specs)))
+        tree_interaction(sys, specs);
+    else
+        n_square_interaction(sys, specs);
 #endif
 #ifdef REGULARIZATION
     reg_interaction(sys, specs);
@@ -143,11 +154,15 @@ specptr specs;
     }
 
 #define  BIGNUMBER  1.0e20
+#define  NROWMIN    128          /* fewer bodies are not worth the threads   */
 
 /*-----------------------------------------------------------------------------
  *  n_square_interaction  --  calculate a system derivative by explicitly
  *                            evaluating all interactions between all particles
  *                            see  deriv_system()  above.
+ *                            note: with more than one thread, and at least
+ *                                  NROWMIN bodies, n_row_interaction() is
+ *                                  used instead.
  *-----------------------------------------------------------------------------
  */
 local void  n_square_interaction(sys, specs)
@@ -176,6 +191,14 @@ specptr specs;
     npart = Nbody(sys);
     bodies = Bodies(sys);
 
+#if defined(_OPENMP)
+    if (npart >= NROWMIN && omp_get_max_threads() > 1)
+        {
+        n_row_interaction(sys, specs);
+        return;
+        }
+#endif
+
     r0_soft = Softparam(specs);
     soften_potential = softener(Softfocus(specs));
 
@@ -206,6 +229,63 @@ specptr specs;
 
     SPECmin_pair(specs) = MIN(SPECmin_pair(specs), 1.0/inv_soft_pair_min);
     }
+
+/*-----------------------------------------------------------------------------
+ *  n_row_interaction  --  as  n_square_interaction() , but each body sums the
+ *                         interactions with all other bodies by itself, so
+ *                         that different bodies can be done by different
+ *                         threads. This costs twice the number of pair
+ *                         evaluations, and the sums are accumulated in a
+ *                         different order.
+ *-----------------------------------------------------------------------------
+ */
+local void  n_row_interaction(sys, specs)
+systptr  sys;
+specptr specs;
+    {
+    int  npart;                  /* number of bodies                         */
+    int  i;                      /* index of body_i                          */
+    real  r0_soft;               /* softening length                         */
+    real  inv_soft_pair_min;     /* minimum pair separation                  */
+    bodyptr  bodies;             /* pointer to first body                    */
+    proc  soften_potential;      /* computes softened potential and M/R^3    */
+
+    npart = Nbody(sys);
+    bodies = Bodies(sys);
+
+    r0_soft = Softparam(specs);
+    soften_potential = softener(Softfocus(specs));
+
+    inv_soft_pair_min = 1.0 / BIGNUMBER;
+
+#pragma omp parallel for schedule(static) reduction(max:inv_soft_pair_min)
+    for (i = 0; i < npart; i++)
+        {
+        bodyptr  body_i, body_j;
+        real  separ_ji[NDIM];
+        real  pot_helper, acc_helper, acc_i_helper;
+        real  acc_ji[NDIM];
+
+        body_i = bodies + i;
+        CLRV(Acc(body_i));
+        Pot(body_i) = 0.0;
+        for (body_j = bodies; body_j - bodies < npart; body_j++)
+            {
+            if (body_j == body_i)
+                continue;
+	    SUBV(separ_ji, Pos(body_j), Pos(body_i));
+            (*soften_potential)(separ_ji, r0_soft, &pot_helper, &acc_helper);
+            Pot(body_i) -= Mass(body_j) * pot_helper;
+            acc_i_helper = Mass(body_j) * acc_helper;
+	    MULVS(acc_ji, separ_ji, acc_i_helper);
+	    INCADDV(Acc(body_i), acc_ji);
+
+	    inv_soft_pair_min = MAX(inv_soft_pair_min, pot_helper);
+            }
+        }
+
+    SPECmin_pair(specs) = MIN(SPECmin_pair(specs), 1.0/inv_soft_pair_min);
+    }
 
 #ifdef TREE
 
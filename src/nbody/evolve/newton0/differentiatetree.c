@@ -1,6 +1,6 @@
 /* differentiatetree.c - body_node_interaction, body_tree_interaction, 
-                         celldivider, constant_opening_angle, 
-                         tree_tree_interaction, treewalk */
+                         celldivider, constant_opening_angle, init_walk,
+                         tree_tree_interaction, treewalk, walk */
 
 /*
  *  differentiatetree.c: routines to compute gravity. 
@@ -9,33 +9,77 @@
  *
  *        adapted from hackcode versions by Josh Barnes, 1985-7,
  *        with the quadrupole extension by Lars Hernquist, 1986.
+ *      Oct  2026  -  methods are looked up once per force calculation
+ *                    instead of once per node, and the bodies are done in
+ *                    parallel when compiled with OpenMP.               PJT
  *      
- *      This code needs -DTREE to compile, and optionally -DQUADPOLE
+ *      This code is compiled in unless -DREGULARIZATION or -DEXTRAPOLATION
+ *      is used (see newton0.h), and optionally with -DQUADPOLE
  */
 
 #include "newton0.h"
 
 typedef bool (*bproc)();
 
-static void treewalk(bodyptr bp, nodeptr np, specptr specs, proc workptr);
+/*-----------------------------------------------------------------------------
+ *  walk  --  everything a tree walk needs, looked up once from the specs;
+ *            each thread carries its own, so the interaction counters can
+ *            be summed afterwards.
+ *-----------------------------------------------------------------------------
+ */
+typedef struct
+    {
+    bproc  celldivision_method;  /* one particular celldivision method       */
+    proc  softening_method;      /* computes softened potential and M/R^3    */
+    real  tolsq;                 /* tolerance parameter squared              */
+    real  r0_soft;               /* softening length                         */
+    int  n2b;                    /* number of body-body interactions         */
+    int  nbc;                    /* number of body-cell interactions         */
+    } walk, *walkptr;
+
+static void init_walk(walkptr wp, specptr specs);
+static void treewalk(bodyptr bp, nodeptr np, walkptr wp);
 static void body_node_interaction(register bodyptr bp, register nodeptr np, real r0_soft, proc softening_method);
 static bproc celldivider(string type_of_celldivision);
 static bool constant_opening_angle(register bodyptr bp, register nodeptr np, real tolsq);
 
 /*-----------------------------------------------------------------------------
  *  tree_tree_interaction  --  evaluate grav field for each particle in "sys".
+ *                             the bodies are independent, and are shared
+ *                             among the threads, if any.
  *-----------------------------------------------------------------------------
  */
 void  tree_tree_interaction(sys, specs)
 systptr  sys;
 specptr  specs;
     {
-    bodyptr  body_i;
-
-    for (body_i = Bodies(sys); body_i - Bodies(sys) < Nbody(sys); body_i++)
-	body_tree_interaction(body_i, Root(sys), specs);
+    int  i;
+    int  n2b, nbc;               /* interaction counts summed over threads   */
+    walk  proto;                 /* methods and parameters for all walks     */
+    bodyptr  bodies;
+    nodeptr  root;
+
+    init_walk(&proto, specs);
+    bodies = Bodies(sys);
+    root = Root(sys);
+    n2b = nbc = 0;
+
+#pragma omp parallel for schedule(dynamic,16) reduction(+:n2b,nbc)
+    for (i = 0; i < Nbody(sys); i++)
+	{
+	walk  w;
+
+	w = proto;
+	Pot(bodies + i) = 0.0;                       /* clear potential      */
+	CLRV(Acc(bodies + i));                       /* clear acceleration   */
+	treewalk(bodies + i, root, &w);              /* recursively compute  */
+	n2b += w.n2b;
+	nbc += w.nbc;
+	}
 
     Nfcalc(specs) += Nbody(sys);             /* number of n-on-1 force calc. */
+    N2bcalc(specs) += n2b;
+    Nbccalc(specs) += nbc;
     }
 
 /*-----------------------------------------------------------------------------
@@ -47,50 +91,63 @@ bodyptr  bp;
 nodeptr  root;
 specptr  specs;
     {
+    walk  w;
 
+    init_walk(&w, specs);
     Pot(bp) = 0.0;				       /* clear potential    */
     CLRV(Acc(bp));	   			       /* clear acceleration */
-    treewalk(bp, root, specs, body_node_interaction); /* recursively compute */
+    treewalk(bp, root, &w);                           /* recursively compute */
+    N2bcalc(specs) += w.n2b;
+    Nbccalc(specs) += w.nbc;
     }
-
+
 /*-----------------------------------------------------------------------------
- *  treewalk  --   walk the tree opening cells too close to a given point.
+ *  init_walk  --  look up the methods and parameters of a tree walk.
  *-----------------------------------------------------------------------------
  */
-local void  treewalk(bp, np, specs, workptr)
-bodyptr  bp;
-nodeptr np;                     /* pointer into body-tree */
+local void  init_walk(wp, specs)
+walkptr  wp;
 specptr  specs;
-proc workptr;				/* routine to do calculation */
     {
-    register nodeptr *npp;         /* npp for  node-pointer-pointer          */
-    bproc  celldivision_method;    /* one particular celldivision method     */
-    proc  softening_method;        /* computes softened potential and M/R^3. */
-
-    celldivision_method = celldivider(Celldivisionmethod(specs));
-    softening_method = softener(Softfocus(specs));
+    wp->celldivision_method = celldivider(Celldivisionmethod(specs));
+    wp->softening_method = softener(Softfocus(specs));
 #ifdef QUADPOLE
     if (! streq("plummer", Softfocus(specs)))
 	error("treewalk: quadrupole softening of \"%s\" not implemented\n",
               Softfocus(specs));
 #endif
+    wp->tolsq = Tolsqparam(specs);
+    wp->r0_soft = Softparam(specs);
+    wp->n2b = wp->nbc = 0;
+    }
+
+/*-----------------------------------------------------------------------------
+ *  treewalk  --   walk the tree opening cells too close to a given point.
+ *-----------------------------------------------------------------------------
+ */
+local void  treewalk(bp, np, wp)
+bodyptr  bp;
+nodeptr np;                     /* pointer into body-tree */
+walkptr  wp;				/* methods, parameters and counters */
+    {
+    register nodeptr *npp;         /* npp for  node-pointer-pointer          */
 
-    if ((*celldivision_method)(bp, np, Tolsqparam(specs)))       /* open np? */
+    if ((*wp->celldivision_method)(bp, np, wp->tolsq))           /* open np? */
         {                                            /* loop over sub-cells  */
         for (npp = Subptr(np); npp - Subptr(np) < NSUB; npp++)
             if (*npp != NULL)                        /* does this one exist? */
-                treewalk(bp, *npp, specs, workptr);          /*  then use it */
+                treewalk(bp, *npp, wp);                      /*  then use it */
         } 
     else if (np != (nodeptr)bp)                      /* not to be skipped?   */
         {                                                    /*  then use it */
-        (*workptr)(bp, np, Softparam(specs), softening_method);
+        body_node_interaction(bp, np, wp->r0_soft, wp->softening_method);
 	if (PartType(np) == BODY)
-	    (N2bcalc(specs))++;			     /* count body-body int. */
+	    wp->n2b++;				     /* count body-body int. */
 	else
-	    (Nbccalc(specs))++;			     /* count body-cell int. */
+	    wp->nbc++;				     /* count body-cell int. */
         }
     }
-
+
 /*-----------------------------------------------------------------------------
  *  body_node_interaction  --  compute a single 2-body interaction.
  *-----------------------------------------------------------------------------
@@ -102,8 +159,11 @@ real  r0_soft;                              /* softening parameter           */
 proc  softening_method;             /* computes softened potential and M/R^3 */
     {
     real  mor3;
-    real  acc_body_node[NDIM], quaddr[NDIM];
+    real  acc_body_node[NDIM];
+#ifdef QUADPOLE
+    real  quaddr[NDIM];
     real  dr5inv, phiquad, drquaddr;
+#endif
     real  pot_helper;            /* auxiliary variable to store soft 1/R     */
     real  acc_helper;            /* auxiliary variable to store soft 1/R^3   */
     real  separ[NDIM];  	 /* separation vector  body --> node .       */
@@ -145,6 +205,7 @@ string  type_of_celldivision;
     else
 	error("celldivider: %s not implemented as a type of cell division\n",
                                                          type_of_celldivision);
+    return(NULL);                                /* not reached */
     }
 
 /*-----------------------------------------------------------------------------
@@ -732,8 +732,7 @@ real  ds;
     rm_csystem(a_new);
     dv = mul_csystem(dv_helper, 0.5*ds); /* dv = (a_old + a_new)*dt/2 */
     rm_csystem(dv_helper);
-    annex_vel(sys, dv);                  /* v_new = v_old + dr        */
-    rm_csystem(dr);
+    annex_vel(sys, dv);                  /* v_new = v_old + dv        */
     rm_csystem(dv);
     Tnow(sys) += ds;                     /* t_new = t_old + dt        */
     }
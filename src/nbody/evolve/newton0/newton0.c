@@ -8,6 +8,7 @@
  *      June 1987  -  Piet Hut  @ Inst. f. Adv. Study, Princeton, NJ 08540, USA
  *      Feb  2001  - resurrected for the current NEMO release
  *      Feb  2004  - added to NEMO's official release
+ *      Oct  2026  - force=direct|tree at runtime, parallel force calculation
  */
    
 #include  "newton0.h"
@@ -35,6 +36,8 @@ static void set_controls(ctrlptr ctr, real initial_time);
  *               number of selected nodes in an Eulerian tree; a node is a 
  *               either an individual particle or a cell which represents a
  *               cluster of particles.
+ *               In newton0 the same is selected with  force=tree ;
+ *               newton0tree only has a different default.
  *  newton0reg: as newton0, but using four-dimensional regularization for each
  *              particle pair simultaneously.
  *
@@ -86,19 +89,25 @@ string  defv[] =            /* DEFAULT INPUT PARAMETERS                      */
     "soft_focus=plummer\n    type of softening used",
     "timestep=constant\n     timestep criterion",
     "diagnostics=standard\n  set of diagnostics provided at output times",
-#ifndef TREE
+#ifndef TREE_DEFAULT
     "scheme=runge_kutta_4\n  integration scheme",
+#else
+    "scheme=leapfrog\n       integration scheme",
 #endif
 #ifdef TREE
+# ifndef TREE_DEFAULT
+    "force=direct\n          force calculation: direct or tree",
+# else
+    "force=tree\n            force calculation: direct or tree",
+# endif
     "celldivision=constant_theta\n       cell subdivision criterion",
-    "scheme=leapfrog\n       integration scheme",
     "tol=1.0\n               cell subdivision tolerance",
 #endif
 #ifdef REGULARIZATION
     "niter=3\n               number of iterations in arriving at the correct output times",
 #endif
     "headline=\n             verbiage for output",
-    "VERSION=2.0a\n          20-feb-04 PJT",
+    "VERSION=2.1\n           19-oct-26 PJT",
     NULL,
     };
 
@@ -372,6 +381,11 @@ specptr  specs;
 	error("set_specs: newton0_ext: not yet non-zero softening length\n");
 #endif
 #ifdef TREE
+    Forcemethod(specs) = getparam("force");
+    if (! streq("direct", Forcemethod(specs)) &&
+        ! streq("tree", Forcemethod(specs)))
+	error("set_specs: force=%s not implemented; use direct or tree\n",
+              Forcemethod(specs));
     Celldivisionmethod(specs) = getparam("celldivision");
     tol = getdparam("tol");
     Tolsqparam(specs) = tol * tol;
@@ -393,21 +407,8 @@ ctrlptr  ctr;
 real  initial_time;
     {
     string  headline_helper;
-#ifndef TREE
-#  ifndef REGULARIZATION
-#    ifndef EXTRAPOLATION
-    string  headline_default = "Newton0 code: equal time steps";
-#    endif
-#  endif
-#endif
 #ifdef TREE
-#  ifndef QUADPOLE
-    string  headline_default = 
-            "Newton0 code: equal time steps & tree forces, monopoles only";
-#   else
-    string  headline_default = 
-            "Newton0 code: equal time steps & tree forces, up to quadrupoles";
-#  endif
+    string  headline_default;
 #endif
 #ifdef REGULARIZATION
     string  headline_default =
@@ -418,6 +419,19 @@ real  initial_time;
          "Newton0 code: individual time steps: polynomial orbit extrapolation";
 #endif
 
+#ifdef TREE
+    if (streq("direct", getparam("force")))
+        headline_default = "Newton0 code: equal time steps";
+    else
+#  ifndef QUADPOLE
+        headline_default =
+            "Newton0 code: equal time steps & tree forces, monopoles only";
+#  else
+        headline_default =
+            "Newton0 code: equal time steps & tree forces, up to quadrupoles";
+#  endif
+#endif
+
 /*
  * determine the temporal relation between begin and end point of integration:
  *   Note: the control variable "Forwards()" is an essential ingredient
@@ -11,6 +11,19 @@
 #  define  NDIM  4
 #endif
 
+/*-----------------------------------------------------------------------------
+ *  TREE  --  tree forces are compiled in, except in the regularized and the
+ *            extrapolation versions, and are selected at runtime with the
+ *            force= parameter; compiling with -DTREE (newton0tree) only
+ *            makes tree forces the default.
+ *-----------------------------------------------------------------------------
+ */
+#if defined(TREE)
+#  define  TREE_DEFAULT
+#elif !defined(REGULARIZATION) && !defined(EXTRAPOLATION)
+#  define  TREE
+#endif
+
 #include  <math.h>
 #include  <stdinc.h>
 #include  <stdlib.h>
@@ -226,7 +226,8 @@ stateptr  new_state;
     printf("\n\tnbody = %d    eta_acc = %.2g    r0_soft = %.2g",
                                Nbody(sys), Stepparam(specs), Softparam(specs));
 #ifdef TREE
-    printf("    tol = %.2g", sqrt(Tolsqparam(specs)));
+    if (streq("tree", Forcemethod(specs)))
+        printf("    tol = %.2g", sqrt(Tolsqparam(specs)));
 #endif
 #ifdef REGULARIZATION
     printf("    niter = %d", Ntimingiter(ctr));
@@ -259,20 +260,31 @@ stateptr  the_state;
     specs = Specs(the_state);
     diags = Diags(the_state);
 
+/*
+ * diagnostics on the standard output:
+ */
 #ifdef TREE
-    nbavg = ((real) N2bcalc(specs) / (real) Nfcalc(specs));
-    ncavg = ((real) Nbccalc(specs) / (real) Nfcalc(specs));
-    fcell = ((real) Ncell(sys) / (real) Nbody(sys));
+    if (streq("tree", Forcemethod(specs)))
+	{
+	nbavg = ((real) N2bcalc(specs) / (real) Nfcalc(specs));
+	ncavg = ((real) Nbccalc(specs) / (real) Nfcalc(specs));
+	fcell = ((real) Ncell(sys) / (real) Nbody(sys));
 /*
  * reset to start measuring till next major or minor output:
  */
-    Nfcalc(specs) = N2bcalc(specs) = Nbccalc(specs) = 0;
-#endif
+	Nfcalc(specs) = N2bcalc(specs) = Nbccalc(specs) = 0;
 
-/*
- * diagnostics on the standard output:
- */
-#ifndef TREE
+	printf("\n  %8s%7s%7s%12s%7s%8s%7s%7s%6s%8s\n", "t_now",
+	       "T+U", "T/U", "(E-E0)/E0", "dE/E0", "nsteps",
+	                                   "<bb>", "<bc>", "fcell", "cputime");
+	printf("  %8.3f%8.4f%8.4f%9.2g%9.2g%7d%7.3g%7.3g%6.2g%8.2g\n",
+	       DIAGtime(diags)[CURRENT], DIAGetot(diags)[CURRENT],
+	       DIAGekin(diags)[CURRENT] / DIAGepot(diags)[CURRENT], 
+	       RELDRIFT(DIAGetot(diags)), RELINCREMENT(DIAGetot(diags)), 
+	       DIAGnsteps(diags), nbavg, ncavg, fcell, cputime());
+	return;
+	}
+#endif
     printf("\n  %8s%7s%7s%12s%7s%8s%10s%9s\n", "t_now",
 	   "T+U", "T/U", "(E-E0)/E0", "dE/E0", "nsteps", "pair_min","cputime");
     printf("  %8.3f%8.4f%8.4f%9.2g%9.2g%7d%9.2g%10.2g\n",
@@ -280,17 +292,6 @@ stateptr  the_state;
            DIAGekin(diags)[CURRENT] / DIAGepot(diags)[CURRENT], 
            RELDRIFT(DIAGetot(diags)), RELINCREMENT(DIAGetot(diags)), 
            DIAGnsteps(diags), SPECmin_pair(specs), cputime());
-#endif
-#ifdef TREE
-    printf("\n  %8s%7s%7s%12s%7s%8s%7s%7s%6s%8s\n", "t_now",
-	      "T+U", "T/U", "(E-E0)/E0", "dE/E0", "nsteps",
-                                           "<bb>", "<bc>", "fcell", "cputime");
-    printf("  %8.3f%8.4f%8.4f%9.2g%9.2g%7d%7.3g%7.3g%6.2g%8.2g\n",
-           DIAGtime(diags)[CURRENT], DIAGetot(diags)[CURRENT],
-           DIAGekin(diags)[CURRENT] / DIAGepot(diags)[CURRENT], 
-           RELDRIFT(DIAGetot(diags)), RELINCREMENT(DIAGetot(diags)), 
-           DIAGnsteps(diags), nbavg, ncavg, fcell, cputime());
-#endif
     }
 
 
@@ -7,6 +7,7 @@
  *
  *      June 1987  -  Piet Hut  @ Inst. f. Adv. Study, Princeton, NJ 08540, USA
  *      Feb  2001  -  PJT  fixed specsptr->diagptr in definition of restore_diag
+ *      Oct  2026  -  PJT  save the tree box; the tree itself is rebuilt
  */
    
 #include  "newton0.h"
@@ -148,8 +149,8 @@ stream  savestr;
     put_data(savestr, "bodies", AnyType, Bodies(sys), Nbody(sys),
                                                               sizeof(body), 0);
 #ifdef TREE
-    put_data(savestr, "ncell", IntType, &Ncell(sys), 0);
-    error("TREE saving not yet implemented, sorry\n");
+    put_data(savestr, "potmincorner", RealType, Potmincorner(sys), NDIM, 0);
+    put_data(savestr, "potsizesq", RealType, &Potsizesq(sys), 0);
 #endif
     }
 
@@ -250,6 +251,11 @@ stream  restorestr;
     get_data(restorestr, "t_now", RealType, &Tnow(old_sys), 0);
     get_data(restorestr, "bodies", AnyType, Bodies(old_sys), nbody,
              sizeof(body), 0);
+#ifdef TREE
+    get_data(restorestr, "potmincorner", RealType, Potmincorner(old_sys),
+             NDIM, 0);
+    get_data(restorestr, "potsizesq", RealType, &Potsizesq(old_sys), 0);
+#endif
 
     return(old_sys);
     }
@@ -1,5 +1,5 @@
-/* spec.h - Celldivisionmethod, Diagnostics, Dynparam, Integrationscheme,
-            Methods, N2bcalc, Nbccalc, Nfcalc, Nstep_de,
+/* spec.h - Celldivisionmethod, Diagnostics, Dynparam, Forcemethod,
+            Integrationscheme, Methods, N2bcalc, Nbccalc, Nfcalc, Nstep_de,
             Number_of_dynparam, Number_of_methods, Number_of_specidiag, 
             Number_of_specrdiag, Softfocus, SPECmin_pair, 
             Softparam, Specidiag, Specrdiag, Stepparam, Timestepmethod, 
@@ -44,7 +44,7 @@
 #  define  Number_of_specidiag    1
 #endif
 #ifdef TREE
-#  define  Number_of_methods	  5
+#  define  Number_of_methods	  6
 #  define  Number_of_dynparam	  3
 #  define  Number_of_specidiag    4
 #endif
@@ -80,6 +80,7 @@ typedef struct
 #define  Diagnostics(ptr)           ((ptr)->methods[3])    /* type: string   */
 #ifdef TREE
 #  define  Celldivisionmethod(ptr)  ((ptr)->methods[4])    /* type: string   */
+#  define  Forcemethod(ptr)         ((ptr)->methods[5])    /* type: string   */
 #endif
 
 #define  Stepparam(ptr)             ((ptr)->dynparam[0])   /* type: real     */
@@ -103,6 +104,7 @@ typedef struct
  *      Integrationscheme()  choice of integration scheme.
  *      Diagnostics()        choice of set of diagnostics.
  *      Celldivisionmethod() choice of cell division criterion.
+ *      Forcemethod()        choice of force calculation: direct or tree.
  *      Stepparam()          dimensionless integration accuracy parameter,
  *			     used in determining the size of the time steps
  *      Softparam()          potential softening length
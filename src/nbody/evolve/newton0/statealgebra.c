@@ -49,7 +49,7 @@ stateptr  mk_state()
     {
     stateptr  new_state;
 
-    new_state = (stateptr) malloc(sizeof(state));
+    new_state = (stateptr) calloc(1, sizeof(state));
     if (new_state == NULL)
 	error("mk_state: not enough memory left for a new state\n");
 
@@ -93,7 +93,7 @@ specptr  mk_specs()
     {
     specptr  new_specs;
 
-    new_specs = (specptr) malloc(sizeof(spec));
+    new_specs = (specptr) calloc(1, sizeof(spec));
     if (new_specs == NULL)
 	error("mk_specs: not enough memory left for a new spec\n");
 
@@ -127,7 +127,7 @@ ctrlptr  mk_ctrls()
     {
     ctrlptr  new_ctrls;
 
-    new_ctrls = (ctrlptr) malloc(sizeof(ctrl));
+    new_ctrls = (ctrlptr) calloc(1, sizeof(ctrl));
     if (new_ctrls == NULL)
 	error("mk_ctrls: not enough memory left for a new control\n");
 
@@ -162,7 +162,7 @@ diagptr  mk_diags()
     {
     diagptr  new_diags;
 
-    new_diags = (diagptr) malloc(sizeof(diag));
+    new_diags = (diagptr) calloc(1, sizeof(diag));
     if (new_diags == NULL)
 	error("mk_diags: not enough memory left for a new diag\n");
 
@@ -32,7 +32,9 @@ static nodeptr *stem_of_new_leaf(bodyptr bp, nodeptr *rootptr);
 static nodeptr replace_body_by_cell(nodeptr np, int level);
 static void compute_multipoles(register nodeptr upper);
 static void report_monopoles(nodeptr upper, nodeptr lower);
+#ifdef QUADPOLE
 static void report_quadrupoles(nodeptr upper, nodeptr lower);
+#endif
 static bool intcoord(int xp[3 ], real rp[3 ]);
 static int subindex(int x[3 ], int level);
 static cellptr mk_cells(int npart);
@@ -175,7 +177,7 @@ local nodeptr *stem_of_new_leaf(bp, rootptr)
 bodyptr  bp;			/* body to load into tree */
 nodeptr *rootptr;
     {
-    int  level, xp[NDIM], xq[NDIM];
+    int  level, xp[NDIM];
     nodeptr *npp;                            /* npp for node-pointer-pointer */
  
     intcoord(xp, Pos(bp));       		/* form integer coords */
@@ -190,6 +192,7 @@ nodeptr *rootptr;
 	npp = &Subptr(*npp)[subindex(xp, level)]; /* move down 1 level */
         }
     error("stem_of_new_leaf: ran out of bits ( level = 0 ) ...\n");
+    return(NULL);                                /* not reached */
     }
 
 /*-----------------------------------------------------------------------------
@@ -7,6 +7,7 @@
  *              as was done in hackcode1 ages ago                       PJT
  *   10-apr-01  gcc warnings
  *   29-sep-05  gcc4 fix for prototypes
+ *   19-oct-26  bodytab allocated by get_snap, no more MBODY limit
  */
 
 #include "defs.h"
@@ -36,10 +37,10 @@ inputdata()
 
     instr = stropen(infile, "r");		/* open input stream        */
     get_history(instr);				/* read history */
-    btab = &bodytab[0];				/* prepare input pointer    */
-    nbody = MBODY;				/* set maximum size         */
+    btab = NULL;				/* let get_snap allocate    */
     get_snap(instr, &btab, &nbody, &tnow, &bits);
     						/* invoke generic input     */
+    bodytab = btab;
     if ((bits & PhaseSpaceBit) == 0)
 	error("inputdata: essential data missing\tbits = %o", bits);
 
@@ -146,7 +147,7 @@ output()
 	    bits |= AccelerationBit;
     }
     if (bits != 0 && outstr != NULL) {
-	btab = &bodytab[0];
+	btab = bodytab;
 	put_snap(outstr, &btab, &nbody, &tnow, &bits);
 	if (bits & PhaseSpaceBit)
 	    printf("\n\tparticle data written\n");
@@ -281,6 +282,7 @@ void restorestate(string file)
     get_data(str, "minor_tout", RealType, &minor_tout, 0);
     get_data(str, "tout", RealType, &tout, 0);
     get_data(str, "nbody", IntType, &nbody, 0);
+    bodytab = (bodyptr) allocate(nbody * sizeof(body));
     get_data(str, "bodytab", AnyType, bodytab, nbody, sizeof(body), 0);
     strclose(str);
 }
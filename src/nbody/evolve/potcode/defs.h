@@ -70,10 +70,23 @@ typedef struct {
 #define Phi(p)   ((p)->phi)
 #define Key(p)   ((p)->key)
 
-#ifndef MBODY
-#  define MBODY 250000
+global int nbody;		/* number of bodies simulated */
+
+global bodyptr bodytab;		/* array representing state */
+
+/*
+ * CHUNKVEC: structure-of-arrays block of body vectors, used by the
+ *           ensemble stepper (ensemble.c) to advance NCHUNK bodies at once.
+ */
+
+#ifndef NCHUNK
+#  define NCHUNK 256
 #endif
 
-global int nbody;		/* number of bodies simulated */
+typedef real chunkvec[NDIM][NCHUNK];
+
+global bool Qensemble;		/* advance bodies as an ensemble ? */
 
-global body bodytab[MBODY];	/* array representing state */
+void forcechunk(int n, chunkvec x, chunkvec v, chunkvec a, real *phi, real time);
+void ensinit(bodyptr btab, int nb, real *tptr);
+void ensstep(bodyptr btab, int nb, real *tptr, real dt, int mode);
@@ -0,0 +1,265 @@
+/*
+ * ENSEMBLE.C: orbit integration of all bodies as an ensemble.
+ * Defines: ensinit(), ensstep().
+ *
+ *	Bodies are gathered in chunks of NCHUNK into structure-of-arrays
+ *	blocks, the whole time-step is taken on a chunk with one batched
+ *	potential call per force evaluation (forcechunk), and the result is
+ *	scattered back into bodytab.  Chunks are independent, and are done in
+ *	parallel if compiled with OpenMP, so the potential must be reentrant.
+ *	The arithmetic follows orbstep.c, so results are identical.
+ *
+ * oct-2026    created, for all modes of orbstep() except the epicycles
+ */
+
+#include "defs.h"
+
+/*
+ * CHUNK: working storage of one chunk, one per thread.
+ */
+
+typedef struct {
+    int n;			/* bodies in this chunk */
+    chunkvec x, v, a;		/* body position, velocity, acceleration */
+    real phi[NCHUNK];		/* body potential */
+    chunkvec xt, vt, at;	/* trial position, velocity, acceleration */
+    real phit[NCHUNK];		/* trial potential */
+    chunkvec d1, d2, e1, e2;	/* saved derivatives (rk4) or accels (rk) */
+} chunk, *chunkptr;
+
+/*
+ * ABAK: saved accelerations, latest to oldest, by coordinate; the slots
+ *	 rotate after each step instead of being copied (see moveaccel).
+ */
+
+local real *abak[4][NDIM];
+local int ibak = 0;		/* slot of abak0 */
+local int nstep = 0;		/* integration step counter */
+
+#define ABAK(h,k)  abak[(ibak + (h)) % 4][k]
+
+local void loadchunk(chunkptr c, bodyptr btab, int nb, int i0);
+local void savechunk(chunkptr c, bodyptr btab, int i0);
+local void stepchunk(chunkptr c, int i0, real t, real dt, int mode);
+
+/*
+ * ENSINIT: initialize the ensemble integrator.
+ */
+
+void ensinit(bodyptr btab, int nb, real *tptr)
+{
+    chunk c;
+    int h, k, i0;
+
+    nstep = 0;
+    ibak = 0;
+    for (h = 0; h < 4; h++)
+	for (k = 0; k < NDIM; k++)
+	    abak[h][k] = (real *) allocate(nb * sizeof(real));
+#pragma omp parallel for private(c, k) schedule(dynamic)
+    for (i0 = 0; i0 < nb; i0 += NCHUNK) {
+	loadchunk(&c, btab, nb, i0);
+	forcechunk(c.n, c.x, c.v, c.a, c.phi, *tptr);
+	for (k = 0; k < NDIM; k++)		/* save resulting accel */
+	    memcpy(ABAK(0,k) + i0, c.a[k], c.n * sizeof(real));
+	savechunk(&c, btab, i0);
+    }
+}
+
+/*
+ * ENSSTEP: advance the ensemble by one time-step, like orbstep().
+ */
+
+void ensstep(bodyptr btab, int nb, real *tptr, real dt, int mode)
+{
+    chunk c;
+    int i0;
+
+    if (mode < 0 || mode > 6)
+	error("ensstep: mode=%d not supported in ensemble mode", mode);
+#pragma omp parallel for private(c) schedule(dynamic)
+    for (i0 = 0; i0 < nb; i0 += NCHUNK) {
+	loadchunk(&c, btab, nb, i0);
+	stepchunk(&c, i0, *tptr, dt, mode);
+	savechunk(&c, btab, i0);
+    }
+    ibak = (ibak + 3) % 4;			/* oldest slot is now abak0 */
+    *tptr += dt;
+    nstep++;
+}
+
+/*
+ * LOADCHUNK, SAVECHUNK: gather bodies into a chunk, and scatter back.
+ */
+
+local void loadchunk(chunkptr c, bodyptr btab, int nb, int i0)
+{
+    bodyptr p;
+    int i, k;
+
+    c->n = MIN(NCHUNK, nb - i0);
+    for (i = 0, p = btab + i0; i < c->n; i++, p++) {
+	for (k = 0; k < NDIM; k++) {
+	    c->x[k][i] = Pos(p)[k];
+	    c->v[k][i] = Vel(p)[k];
+	    c->a[k][i] = Acc(p)[k];
+	}
+	c->phi[i] = Phi(p);
+    }
+}
+
+local void savechunk(chunkptr c, bodyptr btab, int i0)
+{
+    bodyptr p;
+    int i, k;
+
+    for (i = 0, p = btab + i0; i < c->n; i++, p++) {
+	for (k = 0; k < NDIM; k++) {
+	    Pos(p)[k] = c->x[k][i];
+	    Vel(p)[k] = c->v[k][i];
+	    Acc(p)[k] = c->a[k][i];
+	}
+	Phi(p) = c->phi[i];
+    }
+}
+
+/*
+ * STEPCHUNK: take a complete time-step on one chunk; see orbstep() for
+ *	      the meaning of mode.  The final accelerations are stored
+ *	      in the oldest history slot, which becomes abak0.
+ */
+
+local void stepchunk(chunkptr c, int i0, real t, real dt, int mode)
+{
+    int i, k, n = c->n;
+    real dt2, dts4, dt6, dts6, dt360, dts32, dt720, app, acp, acv;
+    real *a0, *a1, *a2, *a3;
+
+    if (mode == 0) {				/* Euler */
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->x[k][i] += dt * c->v[k][i];
+		c->v[k][i] += dt * c->a[k][i];
+	    }
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+    } else if (mode == 6) {			/* modified Euler */
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt * c->v[k][i];
+	forcechunk(n, c->x, c->v, c->a, c->phi, t);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->v[k][i] += dt * c->a[k][i];
+    } else if (mode == 5) {			/* leapfrog */
+	dt2 = 0.5*dt;
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt2 * c->v[k][i];
+	forcechunk(n, c->x, c->v, c->a, c->phi, t);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->v[k][i] += dt * c->a[k][i];
+		c->x[k][i] += dt2 * c->v[k][i];
+	    }
+    } else if (mode == 4) {			/* RK4 */
+	dt2 = 0.5*dt;
+	dt6 = dt/6.0;
+	forcechunk(n, c->x, c->v, c->a, c->phi, t);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->xt[k][i] = c->x[k][i] + dt2*c->v[k][i];
+		c->vt[k][i] = c->v[k][i] + dt2*c->a[k][i];
+	    }
+	forcechunk(n, c->xt, c->vt, c->at, c->phit, t + dt2);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->d1[k][i] = c->vt[k][i];		/* save 'dyt' */
+		c->e1[k][i] = c->at[k][i];
+		c->xt[k][i] = c->x[k][i] + dt2*c->vt[k][i];
+		c->vt[k][i] = c->v[k][i] + dt2*c->at[k][i];
+	    }
+	forcechunk(n, c->xt, c->vt, c->at, c->phit, t + dt2);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->d2[k][i] = c->vt[k][i];		/* save 'dym' */
+		c->e2[k][i] = c->at[k][i];
+		c->xt[k][i] = c->x[k][i] + dt*c->vt[k][i];
+		c->vt[k][i] = c->v[k][i] + dt*c->at[k][i];
+		c->d2[k][i] = c->d2[k][i] + c->d1[k][i];
+		c->e2[k][i] = c->e2[k][i] + c->e1[k][i];
+	    }
+	forcechunk(n, c->xt, c->vt, c->at, c->phit, t + dt);
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++) {
+		c->x[k][i] += dt6*(c->v[k][i]+c->vt[k][i]+2*c->d2[k][i]);
+		c->v[k][i] += dt6*(c->a[k][i]+c->at[k][i]+2*c->e2[k][i]);
+	    }
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+    } else if (mode == 1 || nstep < 3) {	/* RK */
+	dt2 = dt / 2;
+	dts4 = dt2 * dt2;
+	dt6 = dt / 6;
+	dts6 = dt * dt6;
+	for (k = 0; k < NDIM; k++)
+	    for (i = 0; i < n; i++)
+		c->x[k][i] += dt2 * c->v[k][i];		/* set position x_1 */
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt2);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    for (i = 0; i < n; i++) {
+		c->x[k][i] += dts4 * a0[i];		/* set position x_2 */
+		c->e1[k][i] = c->a[k][i];		/* save accel a_1 */
+	    }
+	}
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt2);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    for (i = 0; i < n; i++) {
+		c->x[k][i] += dt2 * c->v[k][i] + dts4 * (2*c->e1[k][i] - a0[i]);
+		c->e2[k][i] = c->a[k][i];		/* save accel a_2 */
+	    }
+	}
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    for (i = 0; i < n; i++) {
+		c->v[k][i] += dt6 * (a0[i] + 2*c->e1[k][i] + 2*c->e2[k][i] + c->a[k][i]);
+		c->x[k][i] += dts6 * (a0[i] - 2*c->e1[k][i] + c->e2[k][i]);
+	    }
+	}
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+    } else {					/* PC and PC1 */
+	dt360 = dt / 360;
+	dts32 = dt*dt / 32;
+	dt720 = dt / 720;
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    a1 = ABAK(1,k) + i0;
+	    a2 = ABAK(2,k) + i0;
+	    a3 = ABAK(3,k) + i0;
+	    for (i = 0; i < n; i++) {
+		app = 323 * a0[i] - 264 * a1[i] + 159 * a2[i] -  38 * a3[i];
+		c->x[k][i] += dt * (c->v[k][i] + dt360 * app);
+	    }
+	}
+	forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+	for (k = 0; k < NDIM; k++) {
+	    a0 = ABAK(0,k) + i0;
+	    a1 = ABAK(1,k) + i0;
+	    a2 = ABAK(2,k) + i0;
+	    a3 = ABAK(3,k) + i0;
+	    for (i = 0; i < n; i++) {
+		acp = 3 * c->a[k][i] - 12 * a0[i] +
+		    18 * a1[i] - 12 * a2[i] + 3 * a3[i];
+		c->x[k][i] += dts32 * acp;		/* correct position */
+		acv = 251 * c->a[k][i] + 646 * a0[i] -
+		    264 * a1[i] + 106 * a2[i] - 19 * a3[i];
+		c->v[k][i] += dt720 * acv;		/* advance velocity */
+	    }
+	}
+	if (mode == 2)
+	    forcechunk(n, c->x, c->v, c->a, c->phi, t + dt);
+    }
+    for (k = 0; k < NDIM; k++)			/* moveaccel: oldest slot */
+	memcpy(ABAK(3,k) + i0, c->a[k], n * sizeof(real));
+}
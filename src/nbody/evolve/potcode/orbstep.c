@@ -1,7 +1,7 @@
 /*
  * ORBSTEP.C: general-purpose orbit-integration routines.
  * Defines: initstep(), orbstep().
- * Requires: MBODY, body, bodyptr, Pos(), Vel(), Acc().
+ * Requires: body, bodyptr, Pos(), Vel(), Acc().
  *
  *  10-jun-92  Added the 'rk4' method, but this
  *             now uses VECTMATH and assumes particles are
@@ -11,6 +11,7 @@
  * march-2003  added epistep() for epicycle orbits
  *
  * aug-2009    added modified Euler and finally implemented leapfrog
+ * oct-2026    history arrays allocated, no more MBODY
  */
 
 #include "defs.h"
@@ -19,12 +20,11 @@
  * ABAK0, ..., ABAK3: saved accelerations, latest to oldest.
  */
 
-#define MCOR  (NDIM * MBODY)
-
-local real abak0[MCOR];
-local real abak1[MCOR];
-local real abak2[MCOR];
-local real abak3[MCOR];
+local real *abak0 = NULL;
+local real *abak1 = NULL;
+local real *abak2 = NULL;
+local real *abak3 = NULL;
+local real *atmp2 = NULL;		/* scratch for rkstep */
 
 /* 
  * MOVEACCEL: local helper utility to stack back old values of the
@@ -63,6 +63,13 @@ real *tptr;		/* initial time */
 proc force;		/* acceleration calculation */
 {
     nstep = 0;					/* start counting steps */
+    if (abak0 == NULL) {			/* allocate accel history */
+	abak0 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak1 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak2 = (real *) allocate(NDIM * nb * sizeof(real));
+	abak3 = (real *) allocate(NDIM * nb * sizeof(real));
+	atmp2 = (real *) allocate(NDIM * nb * sizeof(real));
+    }
     (*force)(btab, nb, *tptr);			/* compute (t-dep) force */
     moveaccel(btab, nb);			/* save resulting accel */
 }
@@ -120,7 +127,6 @@ real atmp1[];		/* scratch accelerations */
     int i, k;
     register real *pptr, *vptr, *aptr;
     real dt2, dts4, dt6, dts6;
-    static real atmp2[MCOR];			/* dont alloc on stack */
 
     dt2 = dt / 2;
     for (p = btab; p < btab+nb; p++) {		/* loop over bodies */
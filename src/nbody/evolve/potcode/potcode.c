@@ -19,8 +19,7 @@
  *      6-jul-03     b  computed the guiding center             PJT/RPO
  *     29-sep-05     c  variuos gcc4 fixes in other routines    PJT
  *     12-aug-09 V5.1  modified Euler and Leapfrog implemented  PJT
- *
- * To improve:  use allocate() for number of particles; not static
+ *     19-oct-26 V5.2  allocate bodies, added ensemble= mode
  */
 
 #define global
@@ -45,7 +44,8 @@ string defv[] = {
     "sigma=0\n            diffusion angle (degrees) per timestep",
     "seed=0\n		  random seed",
     "headline=PotCode\n   random mumble for humans",
-    "VERSION=5.1a\n       5-sep-09 PJT",
+    "ensemble=f\n         Advance bodies as an ensemble in chunks (threads via np=)",
+    "VERSION=5.2\n        19-oct-26 PJT",
     NULL,
 };
 
@@ -67,11 +67,16 @@ void nemo_main()
     initoutput();
     if (mode < 0) 
       force1(bodytab, nbody, tnow);              /* epicycle "integration" constants */
+    else if (Qensemble)
+      ensinit(bodytab, nbody, &tnow);            /* chunked forces */
     else
       initstep(bodytab, nbody, &tnow, force);    /* forces from potential */
     output();
     while (tnow + 0.1/freq < tstop) {            /* integration loop */
-	orbstep(bodytab, nbody, &tnow, force, 1.0/freq, mode);
+        if (Qensemble)
+	    ensstep(bodytab, nbody, &tnow, 1.0/freq, mode);
+	else
+	    orbstep(bodytab, nbody, &tnow, force, 1.0/freq, mode);
 	dissipate(bodytab, nbody, NDIM, dr, eta, rmax);
 	diffuse(bodytab, nbody, NDIM, sigma);
 	output();
@@ -85,8 +90,6 @@ void setparams(void)
     outfile = getparam("out");
     savefile = getparam("save");
 
-    dprintf(1,"Compiled with MBODY=%d\n",MBODY);
-
     pot = get_potential (getparam("potname"),
        			 getparam("potpars"), 
 			 getparam("potfile"));
@@ -106,6 +109,11 @@ void setparams(void)
     dr[1] = dr[2] = dr[0];		/* square cells in dissipate */
     rmax = getdparam("rmax");
     headline = getparam("headline");
+    Qensemble = getbparam("ensemble");
+    if (Qensemble && mode < 0) {
+        warning("ensemble=t not used for epicycle orbits");
+        Qensemble = FALSE;
+    }
     set_xrandom(getiparam("seed"));
 }
 
@@ -138,6 +146,40 @@ void force(
     }
 }
 
+/*
+ * FORCECHUNK: force calculation on a chunk of bodies, by coordinate.
+ *	       Unlike force() this is called from parallel regions.
+ */
+
+void forcechunk(
+		int n,			/* number of bodies in chunk */
+		chunkvec x,		/* positions */
+		chunkvec v,		/* velocities */
+		chunkvec a,		/* returned accelerations */
+		real *phi,		/* returned potentials */
+		real time)		/* current time */
+{
+    vector lacc,lpos;
+    real   lphi, ltime = time;
+    int    i, k, ndim=NDIM;
+
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < NDIM; k++)
+	    lpos[k] = x[k][i];
+        (*pot)(&ndim,lpos,lacc,&lphi,&ltime);
+        for (k = 0; k < NDIM; k++)
+	    a[k][i] = lacc[k];
+        phi[i] = lphi;
+    }
+    if (ome != 0.0) {
+        for (i = 0; i < n; i++) {
+	    phi[i] -= half_ome2*(sqr(x[0][i])+sqr(x[1][i]));
+	    a[0][i] += ome2*x[0][i] + two_ome*v[1][i];
+	    a[1][i] += ome2*x[1][i] - two_ome*v[0][i];
+	}
+    }
+}
+
 /*
  * FORCE: 'force' calculation routine for epicyclic orbits
  *        where we assume that the particles are:
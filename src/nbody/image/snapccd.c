@@ -18,6 +18,7 @@
  *      16-mar-90  V4.4 made GCC happy, made helpvec  PJT
  *	13-nov-90  V4.5 new location of <snapshot.h>	PJT
  *       4-mar-97  V4.6 NEMO V2.x, fixes for SINGLEPREC pjt
+ *	19-oct-26  V4.7 parallel gridding (gridsum)		PJT
  */
 
 #include <stdinc.h>
@@ -26,6 +27,7 @@
 #include <filestruct.h>
 #include <snapshot/snapshot.h>
 #include <image.h>
+#include <gridsum.h>
 
 string defv[] = {
 	"in=???\n			input filename (a snapshot)",
@@ -35,7 +37,7 @@ string defv[] = {
 	"cell=0.0625\n			cellsize : 64 pixels if size=4",
 	"vrange=-infinity:infinity\n	range in velocity space",
 	"moment=0\n			velocity moment to weigh with",
-	"VERSION=4.6b\n			6-jun-08 PJT",
+	"VERSION=4.7\n			19-oct-26 PJT",
 	NULL,
 };
 
@@ -210,7 +212,8 @@ bin_data()
     real xsky, ysky, vrad;
     real m_min, m_max, brightness, inv_surden, total;
     int  i, k, ix, iy, nx, ny, cnt, noutside, noutvel, ndata;
-    real *pptr;
+    real *pptr, *grid;
+    gridsum *g;
     
 	/* (re)initialize CCD and some other local  variables */
     nx=Nx(iptr);
@@ -223,12 +226,17 @@ bin_data()
     inv_surden = 1.0 / (cell * cell);		/* scaling factor */
     noutside=noutvel=ndata=0;
     total=0.0;
+    g = gridsum_init(1, &Frame(iptr), (size_t)nx*ny, TRUE);
 		/* walk through all particles and accumulate ccd data */
-    for (i=0, pptr=phase; i<nobj; i++) {
-        xsky = *pptr++;			/* x */
-        ysky = *pptr++;			/* y */
-        pptr += NDIM;
-        vrad = -(*pptr++);		/* v_z */
+#pragma omp parallel num_threads(g->nthread) private(xsky,ysky,vrad,brightness,i,k,ix,iy,pptr,grid) reduction(+:noutside,noutvel)
+    {
+      grid = gridsum_grids(g)[0];
+#pragma omp for schedule(static)
+      for (i=0; i<nobj; i++) {
+        pptr = phase + 2*NDIM*i;
+        xsky = pptr[0];			/* x */
+        ysky = pptr[1];			/* y */
+        vrad = -pptr[NDIM+2];		/* v_z */
 	ix = floor((xsky-Xmin(iptr))/cell+0.5+EPS);	/* integer coords in CCD */
 	iy = floor((ysky-Ymin(iptr))/cell+0.5+EPS);
 	if (ix<0 || iy<0 || ix>=nx || iy>=ny) {
@@ -244,8 +252,11 @@ bin_data()
             brightness *= exp( -0.5*sqr((vrad-vmean)/vsig) );
 	for (k=0; k<moment; k++)
 	    brightness *= vrad;
-	MapValue(iptr,ix,iy) +=   brightness;
-     }  /*-- end particles loop --*/
+	grid[&MapValue(iptr,ix,iy) - Frame(iptr)] +=   brightness;
+      }  /*-- end particles loop --*/
+    }
+    gridsum_reduce(g);
+    gridsum_free(g);
 
 	/* determine maximum in picture */
     for (ix=0; ix<nx; ix++)
@@ -30,6 +30,8 @@
  *       2-mar-11   5.3 implemented h3,h4 as moment -3 and -4
  *      18-may-12   5.4 added smoothing in VZ (szvar)
  *     13-feb-2013  6.0 units changed on a cube (now density instead of surface brightness?)
+ *     19-oct-2026  6.1 parallel gridding (gridsum), batched bodytrans calls,
+ *                      Z-convolution only over planes within CUTOFF
  *
  * Todo: - mean=t may not be correct for nz>1 
  *       - hermite h3 and h4 for proper kinemetry
@@ -49,6 +51,7 @@
 #include <snapshot/get_snap.c>
 
 #include <image.h>              /* images */
+#include <gridsum.h>            /* threaded gridding */
 
 string defv[] = {		/* keywords/default values/help */
 	"in=???\n			  input filename (a snapshot)",
@@ -76,7 +79,7 @@ string defv[] = {		/* keywords/default values/help */
 	"stack=f\n			  Stack all selected snapshots?",
 	"integrate=f\n                    Sum or Integrate along 'dvar'?",
 	"proj=\n                          Sky projection (SIN, TAN, ARC, NCP, GLS, MER, AIT)",
-	"VERSION=6.0a\n			  27-jul-2019 PJT",
+	"VERSION=6.1\n			  19-oct-2026 PJT",
 	NULL,
 };
 
@@ -124,6 +127,10 @@ local bool   Qdepth;                    /* need dfunc/tfunc for depth integratio
 local bool   Qsmooth;                   /* (variable) smoothing */
 local bool   Qzsmooth;                  /* (variable) smoothing */
 
+local real   cell_factor, expfac, emax; /* gridding constants for deposit() */
+local real   *zplane = NULL;            /* Z of the planes */
+local int    mmax;                      /* max smoothing ring */
+
 local bool   Qwcs;                      /* use a real astronomical WCS in "fits" degrees */
 local string proj;         
 local double xref, yref, xrefpix, yrefpix, xinc, yinc, rot;
@@ -138,6 +145,8 @@ local int read_snap(void);
 local int allocate_image(void);
 local int clear_image(void);
 local int bin_data(int ivar);
+local void deposit(real **grid, int i, real x, real y, real z, real flux,
+		   real emtau, real depth, real twosqs, real *w, int *nout);
 local int free_snap(void);
 local void los_data(void);
 local int rescale_data(int ivar);
@@ -489,16 +498,20 @@ local Point **map =NULL;
 
 local int pcomp(Point **a, Point **b);
 
+#define CVO(ix,iy,iz)  (&CubeValue(iptr,ix,iy,iz) - Frame(iptr))
+
+/*
+ * BIN_DATA: grid all bodies; the bodytrans expressions are evaluated for
+ *	     a batch of bodies at a time, and deposited by deposit() into
+ *	     grid[0..5] (iptr, iptr0..iptr4).  With depth analysis the
+ *	     bodies are linked into map[] in order, so that is serial.
+ */
+
 bin_data(int ivar)
 {
-    real brightness, cell_factor, x, y, z, z0, t,sum;
-    real expfac, fac, sfac, flux, b, emtau, depth;
-    real e, emax, twosqs;
-    int    i, j, k, ix, iy, iz, n, nneg, ioff;
-    int    ix0, iy0, ix1, iy1, m, mmax;
-    Body   *bp;
-    Point  *pp, *pf,*pl, **ptab;
-    bool   done;
+    real   *out[6], z0;
+    int    ix, iy, iz, nout[3];
+    gridsum *g;
     
     if (Qdepth || Qint) {
       /* first time around allocate a map[] of pointers to Point's */
@@ -527,123 +540,191 @@ bin_data(int ivar)
     else
         mmax = 1;
     emax = 10.0;
+    if (zplane == NULL)
+        zplane = (real *) allocate(nz*sizeof(real));
+    for (iz=0, z0=Zmin(iptr); iz<nz; iz++, z0 += Dz(iptr))
+        zplane[iz] = z0;
+
+    out[0] = Frame(iptr);
+    out[1] = iptr0 ? Frame(iptr0) : NULL;
+    out[2] = iptr1 ? Frame(iptr1) : NULL;
+    out[3] = iptr2 ? Frame(iptr2) : NULL;
+    out[4] = iptr3 ? Frame(iptr3) : NULL;
+    out[5] = iptr4 ? Frame(iptr4) : NULL;
+    g = gridsum_init(6, out, (size_t)nx*ny*nz, !(Qdepth || Qint));
+    nout[0] = nout[1] = nout[2] = 0;
 
 		/* big loop: walk through all particles and accumulate ccd data */
-    for (i=0, bp=btab; i<nobj; i++, bp++) {
-        x = xfunc(bp,tnow,i);            /* transform */
-	y = yfunc(bp,tnow,i);
-	if (Qwcs) wcs(&x,&y);            /* convert to an astronomical WCS, if requested */
-        z = zfunc(bp,tnow,i);
-        flux = efunc[ivar](bp,tnow,i);
-        if (Qdepth || Qint) {
-            emtau = odepth( tfunc(bp,tnow,i) );
-            depth = dfunc(bp,tnow,i);
-	}
-        if (Qsmooth) {
-            twosqs = sfunc(bp,tnow,i);
-            twosqs = 2.0 * sqr(twosqs);
+#pragma omp parallel num_threads(g->nthread)
+    {
+        real **grid = gridsum_grids(g);
+        real *w = (real *) allocate(nz*sizeof(real));
+        real xv[NGCHUNK], yv[NGCHUNK], zv[NGCHUNK], fv[NGCHUNK];
+        real tv[NGCHUNK], dv[NGCHUNK], sv[NGCHUNK];
+        int  i0, j, n, nt[3];
+        Body *bp;
+
+        nt[0] = nt[1] = nt[2] = 0;
+#pragma omp for schedule(static)
+        for (i0=0; i0<nobj; i0 += NGCHUNK) {
+            n = MIN(NGCHUNK, nobj-i0);
+            bp = btab + i0;
+            for (j=0; j<n; j++)                 /* transform */
+                xv[j] = xfunc(bp+j,tnow,i0+j);
+            for (j=0; j<n; j++)
+                yv[j] = yfunc(bp+j,tnow,i0+j);
+            if (Qwcs)                   /* convert to an astronomical WCS */
+                for (j=0; j<n; j++)
+                    wcs(&xv[j],&yv[j]);
+            for (j=0; j<n; j++)
+                zv[j] = zfunc(bp+j,tnow,i0+j);
+            for (j=0; j<n; j++)
+                fv[j] = efunc[ivar](bp+j,tnow,i0+j);
+            for (j=0; j<n; j++)
+                if (Qdepth || Qint) {
+                    tv[j] = odepth( tfunc(bp+j,tnow,i0+j) );
+                    dv[j] = dfunc(bp+j,tnow,i0+j);
+                } else
+                    tv[j] = dv[j] = 0.0;
+            for (j=0; j<n; j++)
+                sv[j] = Qsmooth ? 2.0 * sqr(sfunc(bp+j,tnow,i0+j)) : 0.0;
+            for (j=0; j<n; j++)
+                deposit(grid, i0+j, xv[j], yv[j], zv[j], fv[j],
+                        tv[j], dv[j], sv[j], w, nt);
+        }
+        free(w);
+#pragma omp critical
+        {
+            nout[0] += nt[0];
+            nout[1] += nt[1];
+            nout[2] += nt[2];
         }
+    }
+    gridsum_reduce(g);
+    gridsum_free(g);
+    noutxy += nout[0];
+    noutz  += nout[1];
+    nzero  += nout[2];
+}
+
+/*
+ * DEPOSIT: add one body to the grids, nout[] counts the bodies outside
+ *	    in XY, in Z, and with zero flux; w[] is scratch of size nz.
+ */
 
-	ix0 = xbox(x);                  /* direct gridding in X and Y */
-	iy0 = ybox(y);
+local void deposit(real **grid, int i, real x, real y, real z, real flux,
+		   real emtau, real depth, real twosqs, real *w, int *nout)
+{
+    real brightness, b, e, sfac, fac;
+    int    j, k, ix, iy, iz, ioff, izlo, nw;
+    int    ix0, iy0, ix1, iy1, m;
+    long   off;
+    Point  *pp, *pf, *pl;
+    bool   done;
 
+    ix0 = xbox(x);                  /* direct gridding in X and Y */
+    iy0 = ybox(y);
 
-	if (ix0<0 || iy0<0) {           /* outside area (>= nx,ny never occurs */
-	    noutxy++;
-	    continue;
-	}
-        if (z<zmin || z>zmax) {         /* initial check in Z */
-            noutz++;
-            continue;
-        }
-        if (flux == 0.0) {              /* discard zero flux cases */
-            nzero++;
-            continue;
-        }
+    if (ix0<0 || iy0<0) {           /* outside area (>= nx,ny never occurs */
+        nout[0]++;
+        return;
+    }
+    if (z<zmin || z>zmax) {         /* initial check in Z */
+        nout[1]++;
+        return;
+    }
+    if (flux == 0.0) {              /* discard zero flux cases */
+        nout[2]++;
+        return;
+    }
 
-      	dprintf(4,"%d @ (%d,%d) from (%g,%g)\n",
-      	        i+1,ix0,iy0,x,y);
-
-        for (m=0; m<mmax; m++) {        /* loop over smoothing area */
-            done = TRUE;
-            for (iy1=-m; iy1<=m; iy1++)
-            for (ix1=-m; ix1<=m; ix1++) {       /* current smoothing edge */
-                ix = ix0 + ix1;
-                iy = iy0 + iy1;
-        	if (ix<0 || iy<0 || ix >= Nx(iptr) || iy >= Ny(iptr))
-        	    continue;
-
-                if (m>0 && ABS(ix1) != m && ABS(iy1) != m) continue;
-                if (m>0)
-                    if (twosqs > 0)
-                        e = (sqr(ix1*Dx(iptr))+sqr(iy1*Dy(iptr)))/twosqs;
-                    else 
-                        e = 2 * emax;
+    dprintf(4,"%d @ (%d,%d) from (%g,%g)\n",
+            i+1,ix0,iy0,x,y);
+
+    nw = 0;                         /* Z-kernel is the same for all cells */
+    if (zsig > 0.0 && !(Qdepth || Qint))
+        nw = gridsum_gauss(z, zsig, CUTOFF, expfac, zplane, nz, Dz(iptr),
+                           w, &izlo);
+
+    for (m=0; m<mmax; m++) {        /* loop over smoothing area */
+        done = TRUE;
+        for (iy1=-m; iy1<=m; iy1++)
+        for (ix1=-m; ix1<=m; ix1++) {       /* current smoothing edge */
+            ix = ix0 + ix1;
+            iy = iy0 + iy1;
+            if (ix<0 || iy<0 || ix >= Nx(iptr) || iy >= Ny(iptr))
+                continue;
+
+            if (m>0 && ABS(ix1) != m && ABS(iy1) != m) continue;
+            if (m>0)
+                if (twosqs > 0)
+                    e = (sqr(ix1*Dx(iptr))+sqr(iy1*Dy(iptr)))/twosqs;
                 else 
-                    e = 0.0;
-                if (e < emax) {
-                    sfac = exp(-e);
-                    done = FALSE;
-                } else
-                    sfac = 0.0;
-
-                brightness =   sfac * flux * cell_factor;	/* normalize */
-                b = brightness;
-        	for (k=0; k<ABS(moment); k++) brightness *= z;  /* moments in Z */
-                if (brightness == 0.0) continue;
-
-                if (Qdepth || Qint) {	   /* stack away relevant particle info */
-                    pp = (Point *) allocate(sizeof(Point));
-                    pp->em = brightness;
-                    pp->ab = emtau;
-                    pp->z  = z;
-		    pp->i  = i;
-		    pp->depth = depth;
-                    pp->next = NULL;
-                    ioff = ix + Nx(iptr)*iy; /* location in grid map[] */
-                    pf = map[ioff];
-                    if (pf==NULL) {
-                        map[ioff] = pp;
-                        pp->last = pp;
-                    } else {
-                        pl = pf->last;
-                        pl->next = pp;
-                        pf->last = pp;
-                    }
-
-                    continue;       /* goto next accumulation now    CHECK */
+                    e = 2 * emax;
+            else 
+                e = 0.0;
+            if (e < emax) {
+                sfac = exp(-e);
+                done = FALSE;
+            } else
+                sfac = 0.0;
+
+            brightness =   sfac * flux * cell_factor;	/* normalize */
+            b = brightness;
+            for (k=0; k<ABS(moment); k++) brightness *= z;  /* moments in Z */
+            if (brightness == 0.0) continue;
+
+            if (Qdepth || Qint) {	   /* stack away relevant particle info */
+                pp = (Point *) allocate(sizeof(Point));
+                pp->em = brightness;
+                pp->ab = emtau;
+                pp->z  = z;
+                pp->i  = i;
+                pp->depth = depth;
+                pp->next = NULL;
+                ioff = ix + Nx(iptr)*iy; /* location in grid map[] */
+                pf = map[ioff];
+                if (pf==NULL) {
+                    map[ioff] = pp;
+                    pp->last = pp;
+                } else {
+                    pl = pf->last;
+                    pl->next = pp;
+                    pf->last = pp;
                 }
 
+                continue;       /* goto next accumulation now    CHECK */
+            }
+
 
-                if (zsig > 0.0) {           /* with Gaussian convolution in Z */
-                    for (iz=0, z0=Zmin(iptr); iz<nz; iz++, z0 += Dz(iptr)) {
-        	        fac = (z-z0)/zsig;
-	        	if (ABS(fac)>CUTOFF)    /* if too far from gaussian center */
-		            continue;           /* no contribution added */
-        		fac = expfac*exp(-0.5*fac*fac);
-                        CV(iptr) += brightness*fac;     /* moment */
-			if(iptr0) CV(iptr0) += fac;     /* do we need that even here? */
-                        if(iptr1) CV(iptr1) += b*fac;   /* moment -1,-2 */
-                        if(iptr2) CV(iptr2) += b*z*fac; /* moment -2 */
-                        if(iptr3) CV(iptr3) += b*z*z*fac; /* moment -3 */
-                        if(iptr4) CV(iptr4) += b*z*z*z*fac; /* moment -4 */
-        	    }
-        	} else {
-                    iz = zbox(z);
-                    CV(iptr) +=   brightness;   /* moment */
-                    if(iptr0) CV(iptr0) += 1.0; /* for mean */
-                    if(iptr1) CV(iptr1) += b;   /* moment -1,-2 */
-                    if(iptr2) CV(iptr2) += b*z; /* moment -2 */
-                    if(iptr3) CV(iptr3) += b*z*z;   /* moment -3 */
-                    if(iptr4) CV(iptr4) += b*z*z*z; /* moment -4 */
+            if (zsig > 0.0) {           /* with Gaussian convolution in Z */
+                for (j=0; j<nw; j++) {
+                    fac = w[j];
+                    if (fac == 0.0)         /* beyond CUTOFF */
+                        continue;
+                    off = CVO(ix,iy,izlo+j);
+                    grid[0][off] += brightness*fac;     /* moment */
+                    if(grid[1]) grid[1][off] += fac;     /* do we need that even here? */
+                    if(grid[2]) grid[2][off] += b*fac;   /* moment -1,-2 */
+                    if(grid[3]) grid[3][off] += b*z*fac; /* moment -2 */
+                    if(grid[4]) grid[4][off] += b*z*z*fac; /* moment -3 */
+                    if(grid[5]) grid[5][off] += b*z*z*z*fac; /* moment -4 */
                 }
+            } else {
+                iz = zbox(z);
+                off = CVO(ix,iy,iz);
+                grid[0][off] +=   brightness;   /* moment */
+                if(grid[1]) grid[1][off] += 1.0; /* for mean */
+                if(grid[2]) grid[2][off] += b;   /* moment -1,-2 */
+                if(grid[3]) grid[3][off] += b*z; /* moment -2 */
+                if(grid[4]) grid[4][off] += b*z*z;   /* moment -3 */
+                if(grid[5]) grid[5][off] += b*z*z*z; /* moment -4 */
+            }
 
-            } /* for (iy1/ix1) */
-            if (done) break;
-        } /* m */
-    }  /*-- end particles loop --*/
+        } /* for (iy1/ix1) */
+        if (done) break;
+    } /* m */
 }
-
 
 void los_data(void)
 {
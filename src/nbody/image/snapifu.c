@@ -2,6 +2,9 @@
  *  SNAPIFU:   generate spectra at a grid of points
  *
  *	 8-apr-09  V1.0 - cloned off snapgrid             PJT
+ *	19-oct-26  V1.1 - parallel gridding (gridsum), batched bodytrans calls,
+ *			  Z-convolution only over planes within CUTOFF;
+ *			  the (single) row of spectra is now always iy=0   PJT
  *
  * Todo: - mean=t may not be correct for nz>1 
  *       - xgrid,ygrid should be from file?
@@ -19,6 +22,7 @@
 #include <snapshot/get_snap.c>
 
 #include <image.h>              /* images */
+#include <gridsum.h>            /* threaded gridding */
 
 string defv[] = {		/* keywords/default values/help */
   "in=???\n			  input filename (a snapshot)",
@@ -38,7 +42,7 @@ string defv[] = {		/* keywords/default values/help */
   "moment=0\n			  moment in zvar (-2,-1,0,1,2...)",
   "mean=f\n			  mean (moment=0) or sum per cell",
   "stack=f\n			  Stack all selected snapshots?",
-  "VERSION=1.0\n		  8-apr-09 PJT",
+  "VERSION=1.1\n		  19-oct-26 PJT",
   NULL,
 };
 
@@ -89,6 +93,9 @@ local bool   Qmean;			/* adding or taking mean for image ?? */
 local bool   Qstack;                    /* stacking snapshots ?? */
 local bool   Qdepth;                    /* need dfunc/tfunc for depth integration */
 
+local real   cell_factor, expfac, r2max;  /* gridding constants for deposit() */
+local real   *zplane = NULL;            /* Z of the planes */
+
 
 extern string  *burststring(string,string);
 extern rproc   btrtrans(string);
@@ -100,6 +107,8 @@ local int read_snap(void);
 local int allocate_image(void);
 local int clear_image(void);
 local int bin_data(int ivar);
+local void deposit(real **grid, int i, real x, real y, real z, real flux,
+		   real emtau, real depth, real *w, int *nout);
 local int free_snap(void);
 local void los_data(void);
 local int rescale_data(int ivar);
@@ -319,14 +328,19 @@ local Point **map =NULL;
 
 local int pcomp(Point **a, Point **b);
 
+#define CVO(ix,iy,iz)  (&CubeValue(iptr,ix,iy,iz) - Frame(iptr))
+
+/*
+ * BIN_DATA: grid all bodies, with the bodytrans expressions evaluated for
+ *	     a batch of bodies at a time; deposit() adds them to the grids
+ *	     (iptr, iptr0..iptr2).  Depth analysis is done serially.
+ */
+
 bin_data(int ivar)
 {
-    real brightness, cell_factor, x, y, z, z0, t,sum;
-    real expfac, fac, sfac, flux, b, emtau, depth;
-    real r2, r2max;
-    int    i, j, k, l, ix, iy, iz, n, nneg, ioff;
-    Body   *bp;
-    Point  *pp, *pf,*pl, **ptab;
+    real   *out[4], z0;
+    int    ix, iy, iz, nout[2];
+    gridsum *g;
 
     r2max = 0.25 * size * size;    /* size is the diameter, we need r^2 here */
     
@@ -347,28 +361,90 @@ bin_data(int ivar)
         cell_factor = 1.0 / (r2max*PI);
 
     nbody += nobj;
-    
-    for (i=0, bp=btab; i<nobj; i++, bp++) {    /* loop over all particles */
-      x = xfunc(bp,tnow,i);                    /* transform */
-      y = yfunc(bp,tnow,i);
-      z = zfunc(bp,tnow,i);
-      flux = efunc[ivar](bp,tnow,i);
-      if (Qdepth) {
-	emtau = odepth( tfunc(bp,tnow,i) );
-	depth = dfunc(bp,tnow,i);
+    if (zplane == NULL)
+        zplane = (real *) allocate(nz*sizeof(real));
+    for (iz=0, z0=Zmin(iptr); iz<nz; iz++, z0 += Dz(iptr))
+        zplane[iz] = z0;
+
+    out[0] = Frame(iptr);
+    out[1] = iptr0 ? Frame(iptr0) : NULL;
+    out[2] = iptr1 ? Frame(iptr1) : NULL;
+    out[3] = iptr2 ? Frame(iptr2) : NULL;
+    g = gridsum_init(4, out, (size_t)nx*ny*nz, !Qdepth);
+    nout[0] = nout[1] = 0;
+
+#pragma omp parallel num_threads(g->nthread)
+    {
+      real **grid = gridsum_grids(g);
+      real *w = (real *) allocate(nz*sizeof(real));
+      real xv[NGCHUNK], yv[NGCHUNK], zv[NGCHUNK], fv[NGCHUNK];
+      real tv[NGCHUNK], dv[NGCHUNK];
+      int  i0, j, n, nt[2];
+      Body *bp;
+
+      nt[0] = nt[1] = 0;
+#pragma omp for schedule(static)
+      for (i0=0; i0<nobj; i0 += NGCHUNK) {         /* loop over all particles */
+        n = MIN(NGCHUNK, nobj-i0);
+        bp = btab + i0;
+        for (j=0; j<n; j++)                        /* transform */
+          xv[j] = xfunc(bp+j,tnow,i0+j);
+        for (j=0; j<n; j++)
+          yv[j] = yfunc(bp+j,tnow,i0+j);
+        for (j=0; j<n; j++)
+          zv[j] = zfunc(bp+j,tnow,i0+j);
+        for (j=0; j<n; j++)
+          fv[j] = efunc[ivar](bp+j,tnow,i0+j);
+        for (j=0; j<n; j++)
+          if (Qdepth) {
+            tv[j] = odepth( tfunc(bp+j,tnow,i0+j) );
+            dv[j] = dfunc(bp+j,tnow,i0+j);
+          } else
+            tv[j] = dv[j] = 0.0;
+        for (j=0; j<n; j++)
+          deposit(grid, i0+j, xv[j], yv[j], zv[j], fv[j], tv[j], dv[j], w, nt);
+      }  /*-- end particles loop --*/
+      free(w);
+#pragma omp critical
+      {
+        nout[0] += nt[0];
+        nout[1] += nt[1];
       }
-      for (l=0; l<ngridx; l++) {                   /* loop over all grid positions */
+    }
+    gridsum_reduce(g);
+    gridsum_free(g);
+    noutz += nout[0];
+    nzero += nout[1];
+}
+
+/*
+ * DEPOSIT: add one body to the spectra of all fibers it falls in; nout[]
+ *	    counts (per fiber) the bodies outside in Z and with zero flux;
+ *	    w[] is scratch of size nz.
+ */
+
+local void deposit(real **grid, int i, real x, real y, real z, real flux,
+		   real emtau, real depth, real *w, int *nout)
+{
+    real brightness, b, fac, r2;
+    int    j, k, l, ix, iy, iz, ioff, izlo, nw;
+    long   off;
+    Point  *pp, *pf, *pl;
+
+    nw = -1;                                       /* Z-kernel not yet known */
+    iy = 0;
+    for (l=0; l<ngridx; l++) {                   /* loop over all grid positions */
 	ix = l;
 	r2 = sqr(x-xgrid[l])+sqr(y-ygrid[l]);
 	if (r2>r2max)
 	  continue;
 
         if (z<zmin || z>zmax) {         /* initial check in Z */
-            noutz++;
+            nout[0]++;
             continue;
         }
         if (flux == 0.0) {              /* discard zero flux cases */
-            nzero++;
+            nout[1]++;
             continue;
         }
 
@@ -399,26 +475,28 @@ bin_data(int ivar)
 	}
 
 	if (zsig > 0.0) {                   /* with Gaussian convolve in Z */
-	  for (iz=0, z0=Zmin(iptr); iz<nz; iz++, z0 += Dz(iptr)) {
-	    fac = (z-z0)/zsig;
-	    if (ABS(fac)>CUTOFF)            /* if too far from gaussian center */
-	      continue;                     /* no contribution added */
-	    fac = expfac*exp(-0.5*fac*fac);
-	    CV(iptr) += brightness*fac;     /* moment */
-	    if(iptr1) CV(iptr1) += b*fac;   /* moment -1,-2 */
-	    if(iptr2) CV(iptr2) += b*z*fac; /* moment -2 */
+	  if (nw < 0)
+	    nw = gridsum_gauss(z, zsig, CUTOFF, expfac, zplane, nz, Dz(iptr),
+	                       w, &izlo);
+	  for (j=0; j<nw; j++) {
+	    fac = w[j];
+	    if (fac == 0.0)                 /* beyond CUTOFF */
+	      continue;
+	    off = CVO(ix,iy,izlo+j);
+	    grid[0][off] += brightness*fac;     /* moment */
+	    if(grid[2]) grid[2][off] += b*fac;   /* moment -1,-2 */
+	    if(grid[3]) grid[3][off] += b*z*fac; /* moment -2 */
 	  }
 	} else {                            /* straight box gridding */
 	  iz = zbox(z);
-	  CV(iptr) +=   brightness;         /* moment */
-	  if(iptr0) CV(iptr0) += 1.0;       /* for mean */
-	  if(iptr1) CV(iptr1) += b;         /* moment -1,-2 */
-	  if(iptr2) CV(iptr2) += b*z;       /* moment -2 */
+	  off = CVO(ix,iy,iz);
+	  grid[0][off] +=   brightness;         /* moment */
+	  if(grid[1]) grid[1][off] += 1.0;       /* for mean */
+	  if(grid[2]) grid[2][off] += b;         /* moment -1,-2 */
+	  if(grid[3]) grid[3][off] += b*z;       /* moment -2 */
 	}
-      } /*-- (l) end grid loop --*/
-    }  /*-- (i) end particles loop --*/
+    } /*-- (l) end grid loop --*/
 }
-
 
 void los_data(void)
 {
@@ -11,6 +11,7 @@
  *	22-apr-92  V2.0  NEMO V2.x; major overhaul: xvar=yvar= etc.  PJT
  *	21-jul-95  V2.0a bugfix - calling sprintf for strcpy   Dave Shone
  *	 4-mar-97      b fix for SINGLEPREC
+ *	19-oct-26  V2.1  parallel gridding (gridsum), batched bodytrans calls
  */
 
 #include <stdinc.h>
@@ -24,6 +25,7 @@
 
 #include <yapp.h>
 #include <axis.h>
+#include <gridsum.h>
 
 string defv[] = {
     "in=???\n		    input filename (snapshot)",
@@ -44,7 +46,7 @@ string defv[] = {
     "vmax=0.0\n             max mean to plot",
     "smax=0.0\n             max dispersion to plot",
     "tab=f\n                Need a table? If yes, no plot",
-    "VERSION=2.0b\n         4-mar-97 PJT",
+    "VERSION=2.1\n         19-oct-26 PJT",
     NULL,
 };
 
@@ -184,7 +186,8 @@ out_slit()
     real xslit, yslit, xplt, yplt, sinpa, cospa;
     real m_max, v_min, v_max, s_max;	      /* local min/max */
     int    i, islit;
-    Body *bp;
+    real   *out[3];
+    gridsum *g;
 
     for (islit=0; islit<nslit; islit++)     /* reset local variables */
 	v0star[islit] = v1star[islit] = v2star[islit] = 0.0;
@@ -192,28 +195,47 @@ out_slit()
     inv_surden = 1.0 / (slit_width*slit_cell);
     sinpa = sin(pa); cospa = cos(pa);
 
-    for(bp=btab, i=0; i<nobj; bp++, i++) {      /* loop over all particles */
- 	xsky = xvar(bp,tsnap,i);
- 	ysky = yvar(bp,tsnap,i);
- 	vrad = zvar(bp,tsnap,i);
- 	mass = evar(bp,tsnap,i) * inv_surden;
- 	
-	xsky -= origin[0];			/* translate to slit origin */
-	ysky -= origin[1];
-	xslit = -cospa*ysky + sinpa*xsky;	/* and rotate to slit frame */
-	yslit =  sinpa*ysky + cospa*xsky;	/* !!! check signs !!! */
-
-	if (fabs(yslit) > 0.5*slit_width) 
-	   continue;			/* not in slit */
-
-	islit =  (xslit+0.5*slit_length)/slit_cell;
-	if (islit<0 || islit>=nslit)
-	   continue;			/* not in slit */
-
-	v0star[islit] += mass;
-	v1star[islit] += vrad * mass;
-	v2star[islit] += sqr(vrad) * mass;
-     } /*-- end particles loop --*/
+    out[0] = v0star;  out[1] = v1star;  out[2] = v2star;
+    g = gridsum_init(3, out, (size_t) nslit, TRUE);
+#pragma omp parallel num_threads(g->nthread) private(i,islit,xsky,ysky,vrad,mass,xslit,yslit)
+    {
+      real **grid = gridsum_grids(g);
+      real xv[NGCHUNK], yv[NGCHUNK], zv[NGCHUNK], ev[NGCHUNK];
+      int  i0, n;
+      Body *bp;
+
+#pragma omp for schedule(static)
+      for (i0=0; i0<nobj; i0 += NGCHUNK) {	/* loop over all particles */
+        n = MIN(NGCHUNK, nobj-i0);
+        bp = btab + i0;
+        for (i=0; i<n; i++)  xv[i] = xvar(bp+i,tsnap,i0+i);
+        for (i=0; i<n; i++)  yv[i] = yvar(bp+i,tsnap,i0+i);
+        for (i=0; i<n; i++)  zv[i] = zvar(bp+i,tsnap,i0+i);
+        for (i=0; i<n; i++)  ev[i] = evar(bp+i,tsnap,i0+i);
+
+        for (i=0; i<n; i++) {
+ 	  xsky = xv[i] - origin[0];		/* translate to slit origin */
+	  ysky = yv[i] - origin[1];
+ 	  vrad = zv[i];
+ 	  mass = ev[i] * inv_surden;
+	  xslit = -cospa*ysky + sinpa*xsky;	/* and rotate to slit frame */
+	  yslit =  sinpa*ysky + cospa*xsky;	/* !!! check signs !!! */
+
+	  if (fabs(yslit) > 0.5*slit_width) 
+	     continue;			/* not in slit */
+
+	  islit =  (xslit+0.5*slit_length)/slit_cell;
+	  if (islit<0 || islit>=nslit)
+	     continue;			/* not in slit */
+
+	  grid[0][islit] += mass;
+	  grid[1][islit] += vrad * mass;
+	  grid[2][islit] += sqr(vrad) * mass;
+        }
+      } /*-- end particles loop --*/
+    }
+    gridsum_reduce(g);
+    gridsum_free(g);
 
 
      while (nsmooth-- > 0) {            	/* convolution */
@@ -9,6 +9,10 @@
  *       9-apr-01       c  added header in output   pjt
  *      14-apr-04   V1.5  added headline= to plots                     pjt
  *      15-apr-05         add RMS to output
+ *      19-oct-26   V1.7  key=t to match bodies by Key (hash join),
+ *                        parallel obs=, quartiles by selection,
+ *                        statistics over all times                pjt
+ *                        qselect() from the library               pjt
  */
 
 #include <stdinc.h>
@@ -17,6 +21,7 @@
 #include <history.h>
 #include <vectmath.h>
 #include <moment.h>
+#include <mquantile.h>
 #include <yapp.h>
 #include <axis.h>
 #include <snapshot/snapshot.h>
@@ -32,6 +37,7 @@ string defv[] = {			/* DEFAULT INPUT PARAMETERS         */
     "diffpart=true\n			  difference particles first",
     "relative=false\n			  scale difference by ref value",
     "log=f\n                              use logarithm ",
+    "key=f\n				  match bodies by Key instead of order",
 #if HISTOGRAM
     "nbins=8\n				  number of bins in histogram",
     "xrange=0.0:1.0\n			  range of values to histogram",
@@ -54,7 +60,7 @@ string defv[] = {			/* DEFAULT INPUT PARAMETERS         */
     "formal=false\n			  if true, make publication plot",
     "headline=\n                          header",
 #endif
-    "VERSION=1.6a\n			  25-apr-2019 PJT",
+    "VERSION=1.7\n			  19-oct-2026 PJT",
     NULL,
 };
 
@@ -78,12 +84,16 @@ string headline;
 local real small_dt = 1.0e-14;
 
 local bool Qlog;
+local bool Qkey;
 
 
 
-local real *snapcmp(Body*, Body*, int, real);
-local int cmpreal(real*, real*);
+local real *snapcmp(Body*, Body*, int*, int*, int, real);
+local int keymatch(Body*, int, Body*, int, int**, int**);
+#if STATISTICS
 local void printquart(real*, int, real);
+local void printall(void);
+#endif
 
 extern rproc btrtrans(string);
 
@@ -92,7 +102,7 @@ void nemo_main()
     stream instr1, instr2;
     string time1, time2, file1, file2;
     Body *btab1 = NULL, *btab2 = NULL;
-    int nbody1, bits1, nbody2, bits2;
+    int nbody1, bits1, nbody2, bits2, n, *i1 = NULL, *i2 = NULL;
     real dt, tsnap1 = 0.0, tsnap2 = 0.0, *result;
 
     file1 = getparam("in1");
@@ -107,17 +117,20 @@ void nemo_main()
     diffpart = getbparam("diffpart");
     relative = getbparam("relative");
     Qlog = getbparam("log");
+    Qkey = getbparam("key");
 #if HISTOGRAM || SCATTERPLOT
     headline = getparam("headline");
 #endif
 
     for(;;) {
       do {
+	get_history(instr1);		/* skip history between snapshots */
 	if (!get_snap_by_t(instr1, &btab1, &nbody1, &tsnap1, &bits1, time1))
 		break;
         dprintf(1,"snap1: reading time=%g\n",tsnap1);
       } while (bits1 == TimeBit);
       do {
+	get_history(instr2);		/* skip history between snapshots */
 	if (!get_snap_by_t(instr2, &btab2, &nbody2, &tsnap2, &bits2, time2))
 		break;
         dprintf(1,"snap2: reading time=%g\n",tsnap2);
@@ -128,7 +141,7 @@ void nemo_main()
     	error("no more snapshots found in %s at t=%g",file1,tsnap2);
       else if (bits2 == 0)
     	error("no more snapshots found in %s at t=%g",file2,tsnap1);
-      if (nbody1 != nbody2) 
+      if (nbody1 != nbody2 && !Qkey)
 	error("%s = %d, %d different", NobjTag, nbody1, nbody2);
       if (tsnap1 != tsnap2) {
 	dt = ABS(tsnap2-tsnap1);
@@ -137,29 +150,105 @@ void nemo_main()
       }
       if (bits1 != bits2)
 	warning("bits = 0x%x, 0x%x are different", bits1, bits2);
-      result = snapcmp(btab1, btab2, nbody1, tsnap1);
+      if (Qkey) {
+	if ((bits1 & KeyBit) == 0 || (bits2 & KeyBit) == 0)
+	  error("key=t needs a Key in both snapshots");
+	n = keymatch(btab1, nbody1, btab2, nbody2, &i1, &i2);
+      } else
+	n = nbody1;
+      result = snapcmp(btab1, btab2, i1, i2, n, tsnap1);
 #if STATISTICS
-      printquart(result, nbody1, tsnap1);
+      printquart(result, n, tsnap1);
 #endif
 #if HISTOGRAM
-      histogramplot(result, nbody1);
+      histogramplot(result, n);
 #endif
 #if SCATTERPLOT
-      snapcmpplot(result, btab1, nbody1, tsnap1);
+      snapcmpplot(result, btab1, i1, n, tsnap1);
 #endif
+      free(result);
     }
+#if STATISTICS
+    printall();
+#endif
 }
 
-local real *snapcmp(Body *btab1, Body *btab2, int nbody, real tsnap)
+/*
+ * KEYMATCH: pair up the bodies of both snapshots with the same Key, with
+ *	     a hash table of the keys of the second; the pairs are returned
+ *	     in i1[] and i2[] in the order of the first snapshot.
+ */
+
+local int keymatch(Body *btab1, int nbody1, Body *btab2, int nbody2,
+		   int **i1, int **i2)
+{
+    permanent int *hash = NULL, nhash = 0, nmax = 0;
+    int i, j, n, nmiss;
+    unsigned int h, mask;
+
+    if (nhash < 2*nbody2) {		/* power of two, at most half full */
+	for (nhash = 1024; nhash < 2*nbody2; nhash *= 2)
+	    ;
+	hash = (int *) reallocate(hash, nhash * sizeof(int));
+    }
+    mask = nhash - 1;
+    for (h = 0; h < nhash; h++)
+	hash[h] = -1;
+    for (j = 0; j < nbody2; j++) {
+	h = ((unsigned int) Key(btab2+j) * 2654435761u) & mask;
+	while (hash[h] >= 0) {		/* linear probing */
+	    if (Key(btab2+hash[h]) == Key(btab2+j))
+		error("key=t: duplicate Key %d in in2=",Key(btab2+j));
+	    h = (h+1) & mask;
+	}
+	hash[h] = j;
+    }
+    if (nmax < nbody1) {
+	nmax = nbody1;
+	*i1 = (int *) reallocate(*i1, nmax * sizeof(int));
+	*i2 = (int *) reallocate(*i2, nmax * sizeof(int));
+    }
+#pragma omp parallel for private(h)
+    for (i = 0; i < nbody1; i++) {	/* look up all keys of in1= */
+	h = ((unsigned int) Key(btab1+i) * 2654435761u) & mask;
+	while (hash[h] >= 0 && Key(btab2+hash[h]) != Key(btab1+i))
+	    h = (h+1) & mask;
+	(*i2)[i] = hash[h];		/* -1 if not found */
+    }
+    for (i = 0, n = 0; i < nbody1; i++)	/* and keep the pairs */
+	if ((*i2)[i] >= 0) {
+	    (*i1)[n] = i;
+	    (*i2)[n++] = (*i2)[i];
+	}
+    nmiss = nbody1 - n;
+    if (nmiss > 0 || n < nbody2)
+	warning("key=t: %d bodies of in1= and %d of in2= not matched",
+		nmiss, nbody2 - n);
+    dprintf(1,"keymatch: %d pairs\n",n);
+    return n;
+}
+
+/*
+ * SNAPCMP: observable differences of the pairs (i1[k],i2[k]), or of the
+ *	    bodies in the same order if i1 is NULL
+ */
+
+local real *snapcmp(Body *btab1, Body *btab2, int *i1, int *i2,
+		    int nbody, real tsnap)
 {
-    real *result, oref, odiff;
-    Body *bp1, *bp2, dbody;
-    int i;
+    real *result;
+    int k;
 
     result = (real *) allocate(nbody * sizeof(real));
-    for (i = 0; i < nbody; i++) {
+#pragma omp parallel for schedule(static)
+    for (k = 0; k < nbody; k++) {
+	real oref, odiff;
+	Body *bp1, *bp2, dbody;
+	int i;
+
+	i = (i1 ? i1[k] : k);
 	bp1 = btab1 + i;
-	bp2 = btab2 + i;
+	bp2 = btab2 + (i1 ? i2[k] : k);
 	oref = (*obsfunc)(bp1, tsnap, i);
 	if (diffpart) {
 	    Mass(&dbody) = Mass(bp1) - Mass(bp2);
@@ -174,7 +263,7 @@ local real *snapcmp(Body *btab1, Body *btab2, int nbody, real tsnap)
 	    odiff = oref - (*obsfunc)(bp2, tsnap, i);
 	if (relative)
 	    odiff = odiff / oref;
-	result[i] = odiff;
+	result[k] = odiff;
     }
     return result;
 }
@@ -186,10 +275,13 @@ real show(real x) {
 }
 #if STATISTICS
 
+local Moment mall;		/* statistics over all times */
+local bool Qall = FALSE;
+
 local void printquart(real result[], int nbody, real tsnap)
 {
   static int Qheader = 1;
-  int i;
+  int i, rank[5];
   Moment m;
 
   if (Qheader) {
@@ -197,33 +289,52 @@ local void printquart(real result[], int nbody, real tsnap)
     printf("# obs=%s\n",getparam("obs"));
     Qheader = 0;
   }
-  qsort(result, nbody, sizeof(real), cmpreal);
+  if (nbody < 1) {
+    warning("time %g: no bodies to compare",tsnap);
+    return;
+  }
+  if (!Qall) {
+    ini_moment(&mall,2,0);
+    Qall = TRUE;
+  }
   ini_moment(&m,2,0);
-  for (i=0; i<nbody; i++)
+  for (i=0; i<nbody; i++) {
     accum_moment(&m,result[i],1.0);
+    accum_moment(&mall,result[i],1.0);
+  }
+  rank[0] = 0;				/* no need to sort: select these */
+  rank[1] = nbody/4;
+  rank[2] = MAX(nbody/2-1, rank[1]);
+  rank[3] = MAX(3*nbody/4-1, rank[2]);
+  rank[4] = nbody-1;
+  qselect(result, 0, nbody, rank, 5);
   printf("%g   %g %g %g %g %g  %g %g\n",
 	 tsnap,
-	 show(result[0]),
-	 show(result[nbody/4]),
-	 show(result[nbody/2-1]),
-	 show(result[3*nbody/4-1]),
-	 show(result[nbody-1]),
+	 show(result[rank[0]]),
+	 show(result[rank[1]]),
+	 show(result[rank[2]]),
+	 show(result[rank[3]]),
+	 show(result[rank[4]]),
 	 show(mean_moment(&m)),
 	 show(sigma_moment(&m)));
 	 
 }
 
-/* should have prototype :: int (*compar)(const void *, const void *)) */
+/*
+ * PRINTALL: statistics over all times compared
+ */
 
-local int cmpreal(real *ap, real *bp)
+local void printall(void)
 {
-    return (*ap < *bp ? -1 : *ap > *bp ? 1 : 0);
+  if (!Qall) return;
+  printf("# all  Min Max  Mean Sigma  N:  %g %g  %g %g  %d\n",
+	 show(min_moment(&mall)),
+	 show(max_moment(&mall)),
+	 show(mean_moment(&mall)),
+	 show(sigma_moment(&mall)),
+	 n_moment(&mall));
 }
 
-
-
-
-
 #endif
 
 #if HISTOGRAM
@@ -308,9 +419,10 @@ int nbins;
 
 #if SCATTERPLOT
 
-snapcmpplot(result, btab, nbody, tsnap)
+snapcmpplot(result, btab, i1, nbody, tsnap)
 real result[];
 Body *btab;
+int *i1;
 int nbody;
 real tsnap;
 {
@@ -333,8 +445,9 @@ real tsnap;
     plinit("", 0.0, 20.0, 0.0, 20.0);
     axisplot(xlabel, ylabel);
     pltext(headline,18.0,18.2,0.24,0.0);
-    for (i = 0, bp = btab; i < nbody; i++, bp++) {
-	x = xtrans((*indfunc)(bp, tsnap, i));
+    for (i = 0; i < nbody; i++) {
+	bp = btab + (i1 ? i1[i] : i);
+	x = xtrans((*indfunc)(bp, tsnap, bp-btab));
 	y = ytrans(result[i]);
 	if (xbox[0] <= x && x <= xbox[1] &&
 	      ybox[0] <= y && y <= ybox[1])
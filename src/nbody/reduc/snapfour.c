@@ -7,6 +7,8 @@
  *	22-feb-92	V1.1b   usage
  *       9-nov-93       V1.2    times=
  *       7-may-02       minor code cleanup
+ *      19-oct-26       V1.3    all rings in one pass over the bodies, in
+ *                              parallel; cos/sin(m.phi) by recurrence PJT
  */
 
 #include <stdinc.h>
@@ -18,6 +20,10 @@
 #include <snapshot/body.h>
 #include <snapshot/get_snap.c>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 string defv[] = {
     "in=???\n              Input snapshot",
     "radii=0:2:0.1\n       Set of radii denoting edges of cylinders",
@@ -29,7 +35,7 @@ string defv[] = {
     "weight=1\n            Weight applied to observable",
     "amode=t\n             Display sin/cos amps or amp/phase if possible?",
     "times=all\n           Snapshots to select",
-    "VERSION=1.2c\n        25-nov-2019 PJT",
+    "VERSION=1.3\n         19-oct-2026 PJT",
     NULL,
 };
 
@@ -40,6 +46,8 @@ string usage = "Fourier coefficients of an N-body distribution";
 #define MAXRAD 513
 #define MAXORDER 8
 
+local int ring(real r2, real *rad, int nrad);
+
 nemo_main()
 {
     stream instr;
@@ -110,11 +118,10 @@ bool Qcos[], Qsin[];        /* designate if coef to be used */
 int nbody, maxorder, nrad;     
 bool amode;                 /* TRUE=amps only FALSE=amp+phase if all available */
 {
-    real   th, r2, v, rsum, vsum, cosk, amp, pha, radius, w;
-    int    i,k,m,cnt,dim,ip;
-    Body *bp;
-    real mat[2*(MAXORDER+1)*(MAXORDER+1)],vec[2*(MAXORDER+1)];
-    real sol[2*(MAXORDER+1)], a[2*(MAXORDER+1)+1];
+    real   r2, amp, pha, radius, *acc, *mat, *vec;
+    int    i,k,m,dim,nd,t,nthread=1,*cnt;
+    bool   Qsorted;
+    real   sol[2*(MAXORDER+1)];
     permanent bool first=TRUE;
 
     for (m=0, dim=0; m<=maxorder; m++)  /* count dimension of matrix needed */
@@ -139,39 +146,84 @@ bool amode;                 /* TRUE=amps only FALSE=amp+phase if all available *
         first = FALSE;
     }
 
-    for (i=1; i<nrad; i++) {            /* foreach ring */
-        lsq_zero(dim,mat,vec);          /* reset accum. matrix and vector */
-        cnt = 0;                        /* count points in this ring */
-        for (ip=0, bp=btab; ip<nbody; ip++, bp++) {  /* loop for all bodies */
+    for (i=1, Qsorted=TRUE; i<nrad; i++)    /* rings can be found by bisection */
+        if (rad[i] < rad[i-1]) Qsorted = FALSE;
+#if defined(_OPENMP)
+    nthread = omp_get_max_threads();
+#endif
+    nd = dim*dim + dim;                 /* LSQ matrix and vector of a ring */
+    acc = (real *) allocate(nthread*nrad*nd*sizeof(real));
+    cnt = (int *) allocate(nthread*nrad*sizeof(int));
+
+    /* one pass over the bodies: each thread accumulates its own matrices */
+#pragma omp parallel num_threads(nthread) private(i,k,m,t,r2)
+    {
+        real x, y, w, r, c1, s1, cm[MAXORDER+1], sm[MAXORDER+1];
+        real a[2*(MAXORDER+1)+1], *tacc;
+        int ip, *tcnt;
+        Body *bp;
+
+        t = 0;
+#if defined(_OPENMP)
+        t = omp_get_thread_num();
+#endif
+        tacc = acc + t*nrad*nd;
+        tcnt = cnt + t*nrad;
+#pragma omp for schedule(static)
+        for (ip=0; ip<nbody; ip++) {     /* loop for all bodies */
+            bp = btab + ip;
+            x = xproc(bp,tsnap,ip);
+            y = yproc(bp,tsnap,ip);
+            r2 = x*x + y*y;
+            i = Qsorted ? ring(r2,rad,nrad) : 1;
+            if (i >= nrad) continue;        /* not in any ring */
             w = wproc(bp,tsnap,ip);
-            r2 = sqr(xproc(bp,tsnap,ip)) + sqr(yproc(bp,tsnap,ip));
-            if (r2<rad[i-1] || r2>rad[i])          /* if not in ring:  */
-                continue;                           /* skip this particle */
-            cnt++;
-            th = atan2(yproc(bp,tsnap,ip) , xproc(bp,tsnap,ip));
-            k=0;                            /* always count how many coefs */
-            for(m=0; m<=maxorder; m++) {     /* cos(m.theta) */
-                if (!Qcos[m]) continue;
-                a[k++] = cos(m*th);
-            }
-            for(m=1; m<=maxorder; m++) {     /* sin(m.theta) */
-                if (!Qsin[m]) continue;
-                a[k++] = sin(m*th);
+
+            r = sqrt(r2);                   /* cos/sin(m.theta) by recurrence */
+            c1 = (r > 0.0 ? x/r : 1.0);
+            s1 = (r > 0.0 ? y/r : 0.0);
+            cm[0] = 1.0;
+            sm[0] = 0.0;
+            for (m=1; m<=maxorder; m++) {
+                cm[m] = cm[m-1]*c1 - sm[m-1]*s1;
+                sm[m] = sm[m-1]*c1 + cm[m-1]*s1;
             }
+            k=0;                            /* always count how many coefs */
+            for(m=0; m<=maxorder; m++)      /* cos(m.theta) */
+                if (Qcos[m]) a[k++] = cm[m];
+            for(m=1; m<=maxorder; m++)      /* sin(m.theta) */
+                if (Qsin[m]) a[k++] = sm[m];
             a[k] = fproc(bp,tsnap,ip);
-            dprintf(1,"adding %d: r^2=%g th=%g, fvar=%g wt=%g\n",
-			      cnt,r2,th*180/PI,a[k],w);
-            if (k!=dim) error("snapfour: Counting error dim=%d k=%d",dim,k);
-            lsq_accum(dim,mat,vec,a,w);  /* accumulate for LSQ normal matrix */
-        } /* bp */
-    
+
+            for ( ; i<nrad; i++) {          /* all rings it is in */
+                if (r2<rad[i-1] || r2>rad[i]) {
+                    if (Qsorted) break;
+                    continue;
+                }
+                tcnt[i]++;
+                dprintf(1,"adding %d: r^2=%g fvar=%g wt=%g\n",
+                        i,r2,a[k],w);
+                lsq_accum(dim,tacc+i*nd,tacc+i*nd+dim*dim,a,w);
+            }
+        } /* ip */
+    }
+    for (t=1; t<nthread; t++)           /* add threads in order */
+        for (i=1; i<nrad; i++) {
+            cnt[i] += cnt[t*nrad+i];
+            for (k=0; k<nd; k++)
+                acc[i*nd+k] += acc[(t*nrad+i)*nd+k];
+        }
+
+    for (i=1; i<nrad; i++) {            /* foreach ring */
+        mat = acc + i*nd;
+        vec = mat + dim*dim;
         radius = 0.5*(sqrt(rad[i-1])+sqrt(rad[i]));
-	if (cnt<dim) {
-            dprintf(0,"radius %g has %d points: skipped\n",radius,cnt);
+	if (cnt[i]<dim) {
+            dprintf(0,"radius %g has %d points: skipped\n",radius,cnt[i]);
             continue;
         }
         lsq_solve(dim,mat,vec,sol);
-        printf("%g %d",radius,cnt);
+        printf("%g %d",radius,cnt[i]);
 	if (amode) {				/* only print amplitudes */
             for (k=0; k<dim; k++)
                 printf(" %g",sol[k]);
@@ -187,9 +239,32 @@ bool amode;                 /* TRUE=amps only FALSE=amp+phase if all available *
 	}
         printf("\n");
     } /* i */
+    free(acc);
+    free(cnt);
     return 0;
 }
 
+/*
+ * RING: first ring i (rad[i-1] <= r2 <= rad[i]) containing r2, by bisection
+ *	 in the increasing rad[]; nrad if none.
+ */
+
+local int ring(real r2, real *rad, int nrad)
+{
+    int lo = 1, hi = nrad-1, mid;
+
+    if (nrad < 2 || r2 < rad[0] || r2 > rad[nrad-1])
+        return nrad;
+    while (lo < hi) {
+        mid = (lo+hi)/2;
+        if (rad[mid] < r2)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
 print_header(maxorder,Qcos,Qsin,amode)
 int maxorder;
 bool Qcos[], Qsin[], amode;
@@ -1,7 +1,10 @@
 /*
- *  SNAPKMEAN: find kmean in a selected phase space 
+ *  SNAPKMEAN: find kmean in a selected phase space
  *
  *	24-sep-07	V1.0 created, at ADASS     		PJT
+ *	19-oct-26	V2.0 Hamerly's accelerated k-means, in parallel;
+ *			     k-means++ seeding, no limit on k and var's,
+ *			     mean= now used, out= to store the clusters	PJT
  */
 
 #include <stdinc.h>
@@ -10,19 +13,27 @@
 #include <vectmath.h>		/* otherwise NDIM undefined */
 #include <filestruct.h>
 
-#include <snapshot/snapshot.h>	
+#include <snapshot/snapshot.h>
 #include <snapshot/body.h>
 #include <snapshot/get_snap.c>
+#include <snapshot/put_snap.c>
 
 #include <mdarray.h>
 
-string defv[] = {		
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+string defv[] = {
   "in=???\n	              Input file (snapshot)",
   "var=x\n                    Variables to use for coordinates",
   "k=2\n                      Number of means to find",
-  "mean=-1,1\n                Initial estimates of the means",
+  "mean=\n                    Initial estimates of the means (k*nvar values) [k-means++]",
+  "seed=0\n                   Random seed for the k-means++ initial means",
+  "maxiter=100\n              Maximum number of iterations",
+  "out=\n                     Optional output snapshot, with Key the cluster (0..k-1)",
   "times=all\n                Times of snapshot",
-  "VERSION=1.0\n	      26-sep-07 pjt",
+  "VERSION=2.0\n	      19-oct-26 pjt",
   NULL,
 };
 
@@ -30,58 +41,56 @@ string usage = "find kmean in selected phase space of a snapshot";
 
 string cvsid = "$Id$";
 
-#define MAXOPT    6
-#define MAXK      10
-
-void do_kmean(int k,int ndim,int nbody,real **x, real **xmean, int *idx);
+local void kmeanpp(int k, int ndim, int nbody, mdarray2 x, mdarray2 xmean);
+local int  do_kmean(int k, int ndim, int nbody, mdarray2 x, mdarray2 xmean,
+		    int *idx, int *count, int maxiter);
 
 nemo_main()
 {
-  stream instr, tabstr;
-  real   tsnap, ekin, etot, dr, r, rv, v, vr, vt, aux;
-  real   varmin[MAXOPT], varmax[MAXOPT];
-  real   var0[MAXOPT], var1[MAXOPT], var2[MAXOPT];
-  real   mean[MAXOPT*MAXK];
+  stream instr, outstr = NULL;
+  real   tsnap, *mean = NULL, d, sse;
   mdarray2 xmean, x;
-  string headline=NULL, options, times, mnmxmode;
-  Body *btab = NULL, *bp, *bq;
-  bool   Qmin, Qmax, Qmean, Qsig, Qtime, scanopt();
-  int i, k, n, nbody, bits, nsep, isep, ndim, ParticlesBit, *idx, nmean;
-  char fmt[20],*pfmt;
+  string times;
+  Body *btab = NULL, *bp;
+  int i, j, k, n, nbody, bits, ndim, ParticlesBit, *idx, *count, nmean;
+  int maxiter, iter;
   string *burststring(), *opt;
-  rproc btrtrans(), fopt[MAXOPT], faux;
-  
+  rproc btrtrans(), *fopt;
+
   ParticlesBit = (MassBit | PhaseSpaceBit | PotentialBit | AccelerationBit |
 		  AuxBit | KeyBit);
   instr = stropen(getparam("in"), "r");	/* open input file */
+  if (hasvalue("out"))
+    outstr = stropen(getparam("out"), "w");
   k = getiparam("k");
-
+  if (k < 1) error("k=%d must be positive",k);
+  maxiter = getiparam("maxiter");
 
   opt = burststring(getparam("var"),", ");
-  ndim = 0;					/* count options */
-  while (opt[ndim]) {				/* scan through options */
-    fopt[ndim] = btrtrans(opt[ndim]);
-    ndim++;
-    if (ndim==MAXOPT) {
-      dprintf(0,"\n\nMaximum number of var's = %d exhausted\n",MAXOPT);
-      break;
-    }
+  for (ndim=0; opt[ndim]; ndim++)		/* count options */
+    ;
+  if (ndim==0) error("no var= given");
+  fopt = (rproc *) allocate(ndim*sizeof(rproc));
+  for (i=0; i<ndim; i++) {
+    fopt[i] = btrtrans(opt[i]);
+    dprintf(1,"%s ",opt[i]);
   }
-  for (i=0; i<ndim; i++)
-    dprintf(0,"%s ",opt[i]);
-  dprintf(0,"\n");
+  dprintf(1,"\n");
 
-  nmean = nemoinpr(getparam("mean"),mean,MAXOPT*MAXK);
-  if (nmean != ndim*k) error("not enough means given (found %d, need %d)",nmean,ndim*k);
-  
-  tabstr = stdout;
+  if (hasvalue("mean")) {
+    mean = (real *) allocate(ndim*k*sizeof(real));
+    nmean = nemoinpr(getparam("mean"),mean,ndim*k);
+    if (nmean != ndim*k) error("not enough means given (found %d, need %d)",nmean,ndim*k);
+  } else
+    init_xrandom(getparam("seed"));
 
   times = getparam("times");
 
   xmean = allocate_mdarray2(k,ndim);
-
+  count = (int *) allocate(k*sizeof(int));
 
   get_history(instr);                 /* read history */
+  if (outstr) put_history(outstr);
 
   for(;;) {                /* repeating until first or all times are read */
     get_history(instr);
@@ -92,99 +101,253 @@ nemo_main()
       continue;                   /* skip work on this snapshot */
     if ( (bits & ParticlesBit) == 0)
       continue;                   /* skip work, only diagnostics here */
+    if (nbody < k)
+      error("Cannot find %d means with only %d bodies",k,nbody);
 
     x = allocate_mdarray2(nbody,ndim);
     idx = (int *) allocate(nbody*sizeof(int));       /* idx[nbody] */
-    
-    
-    for (bp = btab, i=0; bp < btab+nbody; bp++, i++) {
-      idx[i] = -1;
+
+#pragma omp parallel for private(n)
+    for (i=0; i<nbody; i++)
+      for (n=0; n<ndim; n++)
+	x[i][n]= fopt[n](btab+i,tsnap,i);
+
+    if (mean)
+      for (j=0; j<k; j++)
+	for (n=0; n<ndim; n++)
+	  xmean[j][n] = mean[j*ndim+n];
+    else
+      kmeanpp(k,ndim,nbody,x,xmean);
+
+    iter = do_kmean(k,ndim,nbody,x,xmean,idx,count,maxiter);
+
+    sse = 0.0;
+#pragma omp parallel for private(n,d) reduction(+:sse)
+    for (i=0; i<nbody; i++)
       for (n=0; n<ndim; n++) {
-	x[i][n]= fopt[n](bp,tsnap,i);
+	d = x[i][n] - xmean[idx[i]][n];
+	sse += d*d;
       }
-    }
-    for (i=0; i<k; i++)
+    printf("# time=%g iter=%d rms=%g\n",tsnap,iter,sqrt(sse/nbody));
+    for (j=0; j<k; j++) {
+      printf("%d %d",j,count[j]);
       for (n=0; n<ndim; n++)
-	xmean[i][n] = i;
+	printf(" %g",xmean[j][n]);
+      printf("\n");
+    }
 
-    do_kmean(k,ndim,nbody,x,xmean,idx);
+    if (outstr) {
+      for (bp = btab, i=0; i<nbody; bp++, i++)
+	Key(bp) = idx[i];
+      bits |= KeyBit;
+      put_snap(outstr, &btab, &nbody, &tsnap, &bits);
+    }
 
     free_mdarray2(x,nbody,ndim);
     free(idx);
   }
-  
-strclose(instr);
+
+  strclose(instr);
+  if (outstr) strclose(outstr);
 }
 
-real distance(int ndim, real *x1, real *x2)
+real distance(int ndim, real *x1, real *x2)	/* squared distance */
 {
   int i;
   real d;
 
-  if (ndim==1) {
-    d = *x1-*x2;
-    if (d<0) d = -d;
-  } else {
-    for (i=0, d=0.0; i<ndim; i++)
-      d += (x1[i]-x2[i])*(x1[i]-x2[i]);
-  }
+  for (i=0, d=0.0; i<ndim; i++)
+    d += (x1[i]-x2[i])*(x1[i]-x2[i]);
   return d;
 }
 
+/*
+ * NEAREST: closest (m) and second closest mean to a point, and the
+ *	    distances to them (upper and lower bound for Hamerly)
+ */
+
+local void nearest(int k, int ndim, real *x, mdarray2 xmean,
+		   int *m, real *u, real *l)
+{
+  int j;
+  real d, d1, d2;
+
+  d1 = distance(ndim,x,xmean[0]);
+  d2 = HUGE;
+  *m = 0;
+  for (j=1; j<k; j++) {
+    d = distance(ndim,x,xmean[j]);
+    if (d<d1) {
+      d2 = d1;
+      d1 = d;
+      *m = j;
+    } else if (d<d2)
+      d2 = d;
+  }
+  *u = sqrt(d1);
+  *l = (k>1 ? sqrt(d2) : HUGE);
+}
+
+/*
+ * KMEANPP: k-means++ seeding (Arthur & Vassilvitskii 2007): the first mean
+ *	    is a random point, each next one is drawn with a probability
+ *	    proportional to the squared distance to the nearest mean so far
+ */
+
+local void kmeanpp(int k, int ndim, int nbody, mdarray2 x, mdarray2 xmean)
+{
+  int i, j, n;
+  real *d2, d, sum, r;
+
+  d2 = (real *) allocate(nbody*sizeof(real));
+  i = MIN((int) xrandom(0.0,(real)nbody), nbody-1);
+  for (j=0; ; j++) {
+    for (n=0; n<ndim; n++)
+      xmean[j][n] = x[i][n];
+    if (j==k-1) break;
+    sum = 0.0;
+#pragma omp parallel for private(d) reduction(+:sum)
+    for (i=0; i<nbody; i++) {
+      d = distance(ndim,x[i],xmean[j]);
+      if (j==0 || d<d2[i]) d2[i] = d;
+      sum += d2[i];
+    }
+    if (sum > 0.0) {
+      r = xrandom(0.0,sum);
+      for (i=0; i<nbody-1; i++)
+	if ((r -= d2[i]) < 0.0) break;
+    } else				/* all points are on a mean */
+      i = MIN((int) xrandom(0.0,(real)nbody), nbody-1);
+    dprintf(1,"k-means++: mean %d is point %d\n",j+1,i);
+  }
+  free(d2);
+}
+
 /*
  *  k               number of means
  *  ndim            dimension of space
  *  nbody           number of points
  *  x[nbody][ndim]  coordinates of points
- *  xmean[k][ndim]  coordinates of means
- *  idx[nbody]      membershop to mean (0..k-1)
+ *  xmean[k][ndim]  coordinates of means, initial estimates on input
+ *  idx[nbody]      membership to mean (0..k-1)
+ *  count[k]        number of points per mean
+ *  maxiter         maximum number of iterations
+ *
+ *  Lloyd's iteration, accelerated with Hamerly's (2010) bounds: u[i] is an
+ *  upper bound on the distance of point i to its own mean, l[i] a lower
+ *  bound to the distance to any other mean.  If u[i] is below l[i], or
+ *  below half the distance of its mean to the nearest other mean (s[]),
+ *  the point cannot change membership and the distances to all k means
+ *  need not be computed.  Apart from exact ties the memberships are those
+ *  of the plain iteration; the means are summed per thread, and added in
+ *  thread order.
+ *  Returns the number of iterations.
  */
 
-void do_kmean(int k, int ndim, int nbody, mdarray2 x, mdarray2 xmean, int *idx)
+local int do_kmean(int k, int ndim, int nbody, mdarray2 x, mdarray2 xmean,
+		   int *idx, int *count, int maxiter)
 {
-  int i,j,m,nq,iter=0;
-  real d,dmin,q;
-  bool again;
+  int i, j, jj, n, r, iter, nchanged, nthread = 1, *tcount;
+  real d, m, pmax, pmax2, *u, *l, *s, *p, *tsum;
 
-  dprintf(0,"iter0: ndim=%d xmean[0][0] = %g\n",ndim,xmean[0][0]);
+#if defined(_OPENMP)
+  nthread = omp_get_max_threads();
+#endif
+  u = (real *) allocate(nbody*sizeof(real));
+  l = (real *) allocate(nbody*sizeof(real));
+  s = (real *) allocate(k*sizeof(real));
+  p = (real *) allocate(k*sizeof(real));
+  tsum = (real *) allocate(nthread*k*ndim*sizeof(real));
+  tcount = (int *) allocate(nthread*k*sizeof(int));
 
-  while(1) {
-    again = FALSE;
-    iter++;
-    for (i=0; i<nbody; i++) {
-      dmin = distance(ndim,x[i],xmean[0]);
-      dprintf(1,"%d: %d %g     %g %g\n",i,idx[i],dmin,x[i][0],xmean[0][0]);
-      m = 0;
-      for (j=1; j<k; j++) {
-	d =  distance(ndim,x[i],xmean[j]);
-	if (d<dmin) {
-	  dmin = d;
-	  m = j;
-	}
-      }
-      if (m != idx[i]) {
-	again = TRUE;
-	idx[i] = m;
+  nchanged = nbody;
+#pragma omp parallel for schedule(static)
+  for (i=0; i<nbody; i++)				/* initial membership */
+    nearest(k,ndim,x[i],xmean,&idx[i],&u[i],&l[i]);
+
+  for (iter=1; ; iter++) {
+    for (j=0; j<k*ndim*nthread; j++) tsum[j] = 0.0;	/* new means */
+    for (j=0; j<k*nthread; j++) tcount[j] = 0;
+#pragma omp parallel num_threads(nthread) private(i,j,n)
+    {
+      int t = 0;
+#if defined(_OPENMP)
+      t = omp_get_thread_num();
+#endif
+#pragma omp for schedule(static)
+      for (i=0; i<nbody; i++) {
+	j = idx[i];
+	tcount[t*k+j]++;
+	for (n=0; n<ndim; n++)
+	  tsum[(t*k+j)*ndim+n] += x[i][n];
       }
-      dprintf(1,"%d: %d %g\n",i,idx[i],dmin);
     }
-
     for (j=0; j<k; j++) {
-      q=0.0;
-      nq = 0;
-      for (i=0; i<nbody; i++) {
-	if (idx[i] != j) continue;
-	q += x[i][0];
-	nq++;
+      for (i=1; i<nthread; i++) {
+	tcount[j] += tcount[i*k+j];
+	for (n=0; n<ndim; n++)
+	  tsum[j*ndim+n] += tsum[(i*k+j)*ndim+n];
+      }
+      count[j] = tcount[j];
+      p[j] = 0.0;
+      if (count[j]==0) {
+	warning("no points for mean %d, keeping it at its old value",j);
+	continue;
+      }
+      for (n=0; n<ndim; n++) {
+	d = tsum[j*ndim+n]/count[j];
+	p[j] += sqr(d - xmean[j][n]);
+	xmean[j][n] = d;
       }
-      if (nq==0) error("odd nq=0 for j=%d",j);
-      xmean[j][0] = q/nq;
+      p[j] = sqrt(p[j]);			/* how far the mean moved */
+    }
+    dprintf(1,"iterating %d  changed=%d  xmean[0][0]=%g\n",
+	    iter,nchanged,xmean[0][0]);
+    if (iter==maxiter) {
+      warning("No convergence after %d iterations",maxiter);
+      break;
+    }
+
+    for (j=0, r=0, pmax=pmax2=0.0; j<k; j++) {	/* update the bounds */
+      if (p[j] > pmax) {
+	pmax2 = pmax;
+	pmax = p[j];
+	r = j;
+      } else if (p[j] > pmax2)
+	pmax2 = p[j];
+    }
+#pragma omp parallel for schedule(static)
+    for (i=0; i<nbody; i++) {
+      u[i] += p[idx[i]];
+      l[i] -= (idx[i]==r ? pmax2 : pmax);
     }
-    dprintf(0,"iterating %d  q=%g\n",iter,xmean[0][0]);    
 
-    if (!again) break;
-  } 
-  
+    for (j=0; j<k; j++) {			/* half distance to nearest mean */
+      s[j] = HUGE;
+      for (jj=0; jj<k; jj++)
+	if (jj != j)
+	  s[j] = MIN(s[j], distance(ndim,xmean[j],xmean[jj]));
+      s[j] = 0.5*sqrt(s[j]);
+    }
 
-  
+    nchanged = 0;				/* new membership */
+#pragma omp parallel for schedule(static) private(j,m) reduction(+:nchanged)
+    for (i=0; i<nbody; i++) {
+      j = idx[i];
+      m = MAX(s[j], l[i]);
+      if (u[i] <= m) continue;
+      u[i] = sqrt(distance(ndim,x[i],xmean[j]));	/* tighten */
+      if (u[i] <= m) continue;
+      nearest(k,ndim,x[i],xmean,&idx[i],&u[i],&l[i]);
+      if (idx[i] != j) nchanged++;
+    }
+    if (nchanged==0) break;
+  }
+  free(u);
+  free(l);
+  free(s);
+  free(p);
+  free(tsum);
+  free(tcount);
+  return iter;
 }
@@ -9,9 +9,7 @@
  *	25-mar-97     a  fixed for SINGLEPREC				pjt
  *      10-mar-04  V1.4  add log=                                       pjt
  *      27-jul-05   1.5  added sort=                                    pjt
- *
- *  Bug: if the massfractions are too close such that there
- *       are bins withouth mass, this algorithm fails
+ *      19-oct-26   2.0  mquantile() on (key,mass) pairs, no more qsort     pjt
  */
 
 #include <stdinc.h>
@@ -24,6 +22,7 @@
 #include <snapshot/body.h>
 #include <snapshot/get_snap.c>
 #include <bodytransc.h>
+#include <mquantile.h>
 
 string defv[] = {
     "in=???\n                   Input file name (snapshot)",
@@ -31,7 +30,7 @@ string defv[] = {
     "tab=f\n			Full table of r,m(r) ? ",
     "log=f\n                    Print radii in log10() ? ",
     "sort=r\n                   Observerble to sort masses by",
-    "VERSION=1.5\n              27-jul-05 PJT",
+    "VERSION=2.0\n              19-oct-26 PJT",
     NULL,
 };
 
@@ -42,18 +41,18 @@ string cvsid="$Id$";
 
 #define MFRACT 256
 
-local void snapsort(Body *, int , real, rproc_body);
-local int rank_aux(Body *, Body *);
+local void snapkeys(Body *, int , real, rproc_body, mqpair *);
 
 
 void nemo_main()
 {
     stream instr;
-    real   tsnap, mf[MFRACT], tmass, cmass, fmass, mold, rold, rlag;
-    int    k, nbody, bits, nfract;
+    real   tsnap, mf[MFRACT], rf[MFRACT], tmass, rlag;
+    int    k, nbody, bits, nfract, npair = 0;
     bool   Qtab = getbparam("tab");
     bool   Qlog = getbparam("log");
-    Body *btab = NULL, *bp;
+    Body *btab = NULL;
+    mqpair *pairs = NULL;
     rproc_body sortptr;
 
     sortptr = btrtrans(getparam("sort"));
@@ -77,29 +76,19 @@ void nemo_main()
         if ((bits & PhaseSpaceBit) == 0)
             continue;                       /* if no positions -  skip */
         if (!Qtab) printf("%g",tsnap);
-        snapsort(btab,nbody,tsnap,sortptr);/* sort; hides radius in aux */
-        for (bp=btab, tmass=0.0; bp<btab+nbody; bp++)
-            tmass += Mass(bp);
+        if (nbody > npair) {
+            npair = nbody;
+            pairs = (mqpair *) reallocate(pairs, npair * sizeof(mqpair));
+        }
+        snapkeys(btab,nbody,tsnap,sortptr,pairs);        /* (key,mass) */
+        tmass = mquantile(pairs,nbody,nfract,mf,rf);
         if (tmass == 0.0) error("No masses available in this snapshot");
-        k=0;  
-        fmass=mf[0]*tmass;
-        mold=0.0;
-        rold=0.0;
-        cmass=0.0;
-        for (bp=btab; bp<btab+nbody; bp++) {    /* loop over bodies */
-            cmass += Mass(bp);
-            if(cmass>=fmass) {
-            	if (Qtab) printf("%g", mf[k]);
-		rlag = rold + (tmass*mf[k]-mold)*(Aux(bp)-rold)/(cmass-mold);
-		if (Qlog) rlag = log10(rlag);
-                printf(" %g", rlag);
-                if (Qtab) printf("\n");
-                k++;
-                if (k >= nfract) break;
-                fmass = mf[k] * tmass;
-            }
-            rold = Aux(bp);
-            mold = cmass;
+        for (k=0; k<nfract; k++) {
+            if (Qtab) printf("%g", mf[k]);
+            rlag = rf[k];
+            if (Qlog) rlag = log10(rlag);
+            printf(" %g", rlag);
+            if (Qtab) printf("\n");
         }
         if (!Qtab) printf("\n");
 #if 0
@@ -110,18 +99,14 @@ void nemo_main()
     }   /* for(;;) */
 } /* nemo_main() */
 
-void snapsort(Body *btab, int nbody, real tsnap, rproc_body sortptr) 
+local void snapkeys(Body *btab, int nbody, real tsnap, rproc_body sortptr,
+                    mqpair *pairs)
 {
     int i;
-    Body *b;
-
-    for (i = 0, b = btab; i < nbody; i++, b++)
-      Aux(b) = sortptr(b,tsnap,i);
-    qsort(btab, nbody, sizeof(Body), rank_aux);
-}
 
-int rank_aux(Body *a, Body *b)
-{
-    return (Aux(a) < Aux(b) ? -1 : Aux(a) > Aux(b) ? 1 : 0);
+#pragma omp parallel for
+    for (i = 0; i < nbody; i++) {
+        pairs[i].key  = sortptr(btab+i,tsnap,i);
+        pairs[i].mass = Mass(btab+i);
+    }
 }
-
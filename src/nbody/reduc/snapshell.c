@@ -7,6 +7,10 @@
  *     19-nov-02     V1.2   process all snapshots in input if requested        PJT
  *     14-nov-05     V2.0   changed svar= to rvar=, no more sort=              PJT
  *                   V2.1   added mvar= cumulative=                            PJT
+ *     19-oct-26     V3.0   sorted=f: one pass binning, no sort needed, parallel
+ *                          Chan/Welford moments, median per shell             PJT
+ *                   V3.1   median by selection, not interpolated              PJT
+ *                          qselect() from the library                         PJT
  *
  * TODO: use constant number (or mass?) fraction shells as option
  */
@@ -16,18 +20,23 @@
 #include <vectmath.h>
 #include <filestruct.h>
 #include <moment.h>
+#include <mquantile.h>
 
 #include <snapshot/snapshot.h>
 #include <snapshot/body.h>
 #include <snapshot/get_snap.c>
 #include <bodytransc.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 
 string defv[] = {	
     "in=???\n			 Input file name (snapshot)",
     "radii=???\n                 (normalized) radii for shell boundaries (see also cumulative=)",
     "pvar=vt\n                   Variables to print statistics of in each shell",
-    "rvar=r\n                    shell radius variable (snapshot needs sorted in this)",
+    "rvar=r\n                    shell radius variable (snapshot needs sorted in this, see sorted=)",
     "mvar=m\n                    Mass variable if cumulative= is selected",
     "weight=1\n			 weighting for particles",
     "axes=1,1,1\n                X,Y,Z axes for spatial spheroidal normalization",
@@ -37,7 +46,8 @@ string defv[] = {
     "cumulative=f\n              Use mvar= as cumulative in radii=",
     "first=t\n                   Process only first snapshot?",
     "rstat=f\n                   Add stats in 'r' also ?",
-    "VERSION=2.1\n		 14-nov-05 PJT",
+    "sorted=t\n                  Is the snapshot sorted in rvar? If not, bin in one pass",
+    "VERSION=3.1\n		 19-oct-26 PJT",
     NULL,
 };
 
@@ -70,6 +80,7 @@ local bool Qaxes;
 local bool Qnorm;                     /* rvar in normalized space ? */
 local bool Qrstat;
 local bool Qcumul;
+local bool Qsorted;
 
 
 local string p_format;
@@ -90,9 +101,29 @@ local string stat_options = "npt,mean,dispersion,skewness,kurtosis,min,max,media
 local string *sel_options;
 local int n_sel, *n_mask;
 
+/*
+ * Shellstat: weighted moments about the mean, updated one body at a time
+ * (Welford) and merged between threads (Chan et al., Pebay 2008), which
+ * is much less prone to cancellation than the power sums in a Moment.
+ */
 
-local void print_stat(Moment *m, bool Qhead, string name);
+typedef struct shellstat {
+  int n;                                /* number of bodies */
+  real sw;                              /* sum of weights */
+  real mean;                            /* weighted mean */
+  real m2, m3, m4;                      /* weighted sums of (x-mean)^2,3,4 */
+  real min, max;
+  real med;                             /* median (unweighted), if asked for */
+} Shellstat;
+
+#define NVAR  3                         /* rvar, pvar, r */
+
+local void add_stat(Shellstat *a, Shellstat *b);
+local void accum_stat(Shellstat *s, real x, real w);
+local real stat_value(Moment *m, Shellstat *s, int mask);
+local void print_stat(Moment *m, Shellstat *s, bool Qhead, string name);
 local void printvec(string name, vector vec);
+local void stream_shells(void);
 
 nemo_main()
 {
@@ -101,6 +132,7 @@ nemo_main()
     bool Qfirst = getbparam("first");
     Qrstat = getbparam("rstat");
     Qcumul = getbparam("cumulative");
+    Qsorted = getbparam("sorted");
 
     instr = stropen(getparam("in"), "r");
     nrad = nemoinpd(getparam("radii"),radii,MAXRAD);
@@ -134,7 +166,10 @@ nemo_main()
     while (get_snap(instr, &btab, &nbody, &tsnap, &bits)) {
       if (bits & PhaseSpaceBit) {
 	reshape(1);
-	shells();
+	if (Qsorted)
+	  shells();
+	else
+	  stream_shells();
       }
       if (Qfirst) break;
     }
@@ -303,16 +338,16 @@ shells()
     }
     if (n_moment(&mr)) {       /* only print shells that have data */
       if (Qhead) {
-	print_stat(&ms,Qhead,"rvar");
-	print_stat(&mq,Qhead,"pvar");
-	if (Qrstat) print_stat(&mr,Qhead,"r");
-	print_stat(0,Qhead,"");
+	print_stat(&ms,0,Qhead,"rvar");
+	print_stat(&mq,0,Qhead,"pvar");
+	if (Qrstat) print_stat(&mr,0,Qhead,"r");
+	print_stat(0,0,Qhead,"");
 	Qhead = FALSE;
       }
-      print_stat(&ms,Qhead,"");
-      print_stat(&mq,Qhead,"");
-      if (Qrstat) print_stat(&mr,Qhead,"");
-      print_stat(0,Qhead,"");
+      print_stat(&ms,0,Qhead,"");
+      print_stat(&mq,0,Qhead,"");
+      if (Qrstat) print_stat(&mr,0,Qhead,"");
+      print_stat(0,0,Qhead,"");
     }
     if (irad >= nrad) break;
   } /* for (i=0, irad=0; ; i < nbody */
@@ -324,12 +359,271 @@ shells()
   }
 }
 
+/*
+ * STREAM_SHELLS: the same table as shells(), but the snapshot need not be
+ * sorted.  Each body is placed in its shell by bisection in the shell
+ * edges and accumulated in the Shellstat's of its thread, which are
+ * merged in thread order afterwards.  For normalized= or cumulative=
+ * the edges are first found as (mass weighted) quantiles of rvar with
+ * mquantile(), and the median in each shell by qselect(): both are
+ * O(N), instead of the O(N log N) sort otherwise needed.  Unlike the
+ * moments, the median is not weighted: it is that of the bodies.
+ */
 
-local void print_stat(Moment *m, bool Qhead, string name)
+local void stream_shells(void)
 {
-  int i;
+  int i, j, j0, j1, k, v, nshell, nvar, nthread = 1, *ibin, *off;
+  real *edge, *frac, *mkey, r, rmin, rmax, tmass;
+  int rank[2];
+  Shellstat *tstat, *st, *sk;
+  mqpair *pairs = NULL;
+  Body *b;
+  bool Qmed = FALSE, Qhead = TRUE;
+
+#if defined(_OPENMP)
+  nthread = omp_get_max_threads();
+#endif
+  for (i=0; i<n_sel; i++)
+    if (n_mask[i] == STAT_MED) Qmed = TRUE;
+  nshell = nrad-1;
+  if (nshell < 1) error("Need at least two radii= to define a shell");
+  for (j=1; j<nrad; j++)
+    if (radii[j] <= radii[j-1])
+      error("radii= must be increasing: %d->%g",j+1,radii[j]);
+  nvar = Qrstat ? NVAR : NVAR-1;
+  edge = (real *) allocate(nrad*sizeof(real));
+  ibin = (int *) allocate(nbody*sizeof(int));
+
+  if (Qcumul || Qnorm) {             /* edges are quantiles in rvar */
+    pairs = (mqpair *) allocate(nbody*sizeof(mqpair));
+    rmin = HUGE;
+    rmax = -HUGE;
+    tmass = 0.0;
+#pragma omp parallel for schedule(static) private(b,r) reduction(min:rmin) reduction(max:rmax) reduction(+:tmass)
+    for (i=0; i<nbody; i++) {
+      b = btab+i;
+      r = (rvar)(b, tsnap, i);
+      pairs[i].key = r;
+      pairs[i].mass = Qcumul ? (mvar)(b, tsnap, i) : 1.0;
+      rmin = MIN(rmin, r);
+      rmax = MAX(rmax, r);
+      tmass += pairs[i].mass;
+    }
+    dprintf(0,"Range rvar=%s  from %g to %g\n",getparam("rvar"),rmin,rmax);
+    if (Qcumul && !Qnorm)
+      dprintf(0,"Total for cmas = %g\n",tmass);
+    if (tmass <= 0.0) error("Total mass %g, cannot make cumulative shells",tmass);
+    for (i=0; i<nbody; i++)         /* keys from 0, see mquantile() */
+      pairs[i].key -= rmin;
+    frac = (real *) allocate(nrad*sizeof(real));
+    for (j=0, j0=nrad, j1=0; j<nrad; j++) {
+      if (Qcumul)
+	frac[j] = Qnorm ? radii[j] : radii[j]/tmass;
+      else                       /* body number nbody*radii[j] starts it */
+	frac[j] = (radii[j]*nbody + 1.0)/nbody;
+      if (Qnorm && !Qcumul && (radii[j] < 0.0 || radii[j] > 1.0))
+	error("Normalized radii need to be in range 0..1: %d->%g",
+	      j+1,radii[j]);
+      if (frac[j] <= 0.0)
+	edge[j] = -HUGE;
+      else if (frac[j] >= 1.0)
+	edge[j] = HUGE;
+      else {
+	j0 = MIN(j0, j);
+	j1 = j+1;
+      }
+    }
+    if (j1 > j0) {
+      mquantile(pairs, nbody, j1-j0, frac+j0, edge+j0);
+      for (j=j0; j<j1; j++)
+	edge[j] += rmin;
+    }
+    free(frac);
+  } else
+    for (j=0; j<nrad; j++)
+      edge[j] = radii[j];
+  dprintf(0,"Shell range %g .. %g\n",edge[0],edge[nrad-1]);
+
+  tstat = (Shellstat *) allocate(nthread*nshell*NVAR*sizeof(Shellstat));
+  for (k=0; k<nthread*nshell*NVAR; k++)
+    tstat[k].n = 0;
+#pragma omp parallel num_threads(nthread) private(i,j,k,b,r)
+  {
+    int t = 0, lo, hi;
+    Shellstat *ts;
+#if defined(_OPENMP)
+    t = omp_get_thread_num();
+#endif
+#pragma omp for schedule(static)
+    for (i=0; i<nbody; i++) {
+      b = btab+i;
+      r = (rvar)(b, tsnap, i);
+      ibin[i] = -1;
+      if (r < edge[0] || r >= edge[nrad-1]) continue;
+      for (lo=0, hi=nrad-1; hi-lo > 1; ) {    /* edge[lo] <= r < edge[hi] */
+	k = (lo+hi)/2;
+	if (r >= edge[k]) lo = k; else hi = k;
+      }
+      ibin[i] = lo;
+      ts = tstat + (t*nshell+lo)*NVAR;
+      accum_stat(&ts[0], r, 1.0);
+      accum_stat(&ts[1], (pvar)(b, tsnap, i), (weight)(b, tsnap, i));
+      if (Qrstat) accum_stat(&ts[2], absv(Pos(b)), 1.0);
+    }
+  }
+  st = tstat;                              /* thread 0 collects the rest */
+  for (i=1; i<nthread; i++)
+    for (k=0; k<nshell*NVAR; k++)
+      add_stat(&st[k], &tstat[i*nshell*NVAR+k]);
+
+  if (Qmed) {                  /* median: bodies grouped by shell */
+    mkey = (real *) allocate(nbody*sizeof(real));
+    off = (int *) allocate((nshell+1)*sizeof(int));
+    for (k=0, off[0]=0; k<nshell; k++)
+      off[k+1] = off[k] + st[k*NVAR].n;
+    for (i=0; i<nbody; i++)               /* ibin[] becomes the slot */
+      if (ibin[i] >= 0) ibin[i] = off[ibin[i]]++;
+    for (k=nshell; k>0; k--)
+      off[k] = off[k-1];
+    off[0] = 0;
+    for (v=0; v<nvar; v++) {
+#pragma omp parallel for schedule(static) private(b)
+      for (i=0; i<nbody; i++) {
+	if (ibin[i] < 0) continue;
+	b = btab+i;
+	if (v==0)
+	  mkey[ibin[i]] = (rvar)(b, tsnap, i);
+	else if (v==1)
+	  mkey[ibin[i]] = (pvar)(b, tsnap, i);
+	else
+	  mkey[ibin[i]] = absv(Pos(b));
+      }
+#pragma omp parallel for schedule(dynamic) private(sk,rank)
+      for (k=0; k<nshell; k++) {
+	sk = &st[k*NVAR+v];
+	if (sk->n == 0) continue;
+	rank[0] = off[k] + (sk->n-1)/2;       /* the middle one or two */
+	rank[1] = off[k] + sk->n/2;
+	qselect(mkey, off[k], off[k+1], rank, rank[1] > rank[0] ? 2 : 1);
+	sk->med = 0.5*(mkey[rank[0]] + mkey[rank[1]]);
+      }
+    }
+    free(off);
+    free(mkey);
+  }
+
+  for (k=0; k<nshell; k++) {
+    sk = &st[k*NVAR];
+    if (sk[0].n == 0) continue;            /* only print shells that have data */
+    if (Qhead) {
+      print_stat(0,&sk[0],Qhead,"rvar");
+      print_stat(0,&sk[1],Qhead,"pvar");
+      if (Qrstat) print_stat(0,&sk[2],Qhead,"r");
+      print_stat(0,0,Qhead,"");
+      Qhead = FALSE;
+    }
+    print_stat(0,&sk[0],Qhead,"");
+    print_stat(0,&sk[1],Qhead,"");
+    if (Qrstat) print_stat(0,&sk[2],Qhead,"");
+    print_stat(0,0,Qhead,"");
+  }
+  if (pairs) free(pairs);
+  free(tstat);
+  free(ibin);
+  free(edge);
+}
+
+/*
+ * ADD_STAT: merge the bodies of b into a (Chan et al. for the mean and M2,
+ *	     Pebay 2008 for M3 and M4, with weights instead of counts)
+ */
+
+local void add_stat(Shellstat *a, Shellstat *b)
+{
+  real wa = a->sw, wb = b->sw, w, d, dw, dw2, m2, m3, m4;
+
+  if (b->n == 0) return;
+  if (a->n == 0) {
+    *a = *b;
+    return;
+  }
+  w = wa + wb;
+  d = b->mean - a->mean;
+  dw = (w != 0.0 ? d/w : 0.0);
+  dw2 = dw*dw;
+  m2 = a->m2 + b->m2 + wa*wb*d*dw;
+  m3 = a->m3 + b->m3 + wa*wb*(wa-wb)*d*dw2 + 3*dw*(wa*b->m2 - wb*a->m2);
+  m4 = a->m4 + b->m4 + wa*wb*(wa*wa-wa*wb+wb*wb)*d*dw*dw2
+         + 6*dw2*(wa*wa*b->m2 + wb*wb*a->m2) + 4*dw*(wa*b->m3 - wb*a->m3);
+  a->mean += wb*dw;
+  a->m2 = m2;
+  a->m3 = m3;
+  a->m4 = m4;
+  a->sw = w;
+  a->n += b->n;
+  a->min = MIN(a->min, b->min);
+  a->max = MAX(a->max, b->max);
+}
+
+/*
+ * ACCUM_STAT: add one value x with weight w
+ */
+
+local void accum_stat(Shellstat *s, real x, real w)
+{
+  Shellstat one;
+
+  one.n = 1;
+  one.sw = w;
+  one.mean = one.min = one.max = x;
+  one.m2 = one.m3 = one.m4 = 0.0;
+  add_stat(s, &one);
+}
+
+/*
+ * STAT_VALUE: a statistic from either a Moment or a Shellstat; the latter
+ *	       are defined as in moment.c
+ */
+
+local real stat_value(Moment *m, Shellstat *s, int mask)
+{
+  real sig2;
 
   if (m) {
+    switch (mask) {
+    case STAT_MEA:  return mean_moment(m);
+    case STAT_DIS:
+    case STAT_SIG:  return sigma_moment(m);
+    case STAT_SKE:  return skewness_moment(m);
+    case STAT_KUR:  return kurtosis_moment(m);
+    case STAT_MIN:  return min_moment(m);
+    case STAT_MAX:  return max_moment(m);
+    case STAT_MED:  error("median needs sorted=f");
+                    break;
+    default:        error("Bad stats %d selected",mask);
+    }
+  }
+  sig2 = (s->sw != 0.0 ? s->m2/s->sw : 0.0);
+  switch (mask) {
+  case STAT_MEA:  return s->mean;
+  case STAT_DIS:
+  case STAT_SIG:  return (s->min == s->max || sig2 <= 0.0) ? 0.0 : sqrt(sig2);
+  case STAT_SKE:  return (s->min == s->max) ? 0.0 : s->m3/s->sw/(sig2*sqrt(sig2));
+  case STAT_KUR:  return (s->min == s->max) ? 0.0 : s->m4/s->sw/(sig2*sig2) - 3.0;
+  case STAT_MIN:  return s->min;
+  case STAT_MAX:  return s->max;
+  case STAT_MED:  return s->med;
+  default:        error("Bad stats %d selected",mask);
+  }
+  return 0.0;
+}
+
+
+local void print_stat(Moment *m, Shellstat *s, bool Qhead, string name)
+{
+  int i;
+
+  if (m || s) {
     if (Qhead) {
       printf("#[%s] ",name);
       for (i=0; i<n_sel;i++) {
@@ -366,35 +660,10 @@ local void print_stat(Moment *m, bool Qhead, string name)
       return;
     }
     for (i=0; i<n_sel;i++) {
-      switch (n_mask[i]) {
-      case STAT_NPT:  
-	printf("%d", n_moment(m));            
-	break;
-      case STAT_MEA:  
-	printf(p_format, mean_moment(m));     
-	break;
-      case STAT_DIS:  
-      case STAT_SIG:  
-	printf(p_format, sigma_moment(m));    
-	break;
-      case STAT_SKE:  
-	printf(p_format, skewness_moment(m)); 
-	break;
-      case STAT_KUR:  
-	printf(p_format, kurtosis_moment(m)); 
-	break;
-      case STAT_MIN:  
-	printf(p_format, min_moment(m));      
-	break;
-      case STAT_MAX:  
-	printf(p_format, max_moment(m));      
-	break;
-      case STAT_MED:  
-	error("cannot do median yet");        
-	break;
-      default: 	      error("Bad stats %d selected",n_mask[i]);
-
-      }
+      if (n_mask[i] == STAT_NPT)
+	printf("%d", m ? n_moment(m) : s->n);
+      else
+	printf(p_format, stat_value(m, s, n_mask[i]));
       printf(" ");
     }
     printf("  ");
@@ -407,4 +676,3 @@ local void printvec(string name, vector vec)
     printf("%12s  %10.5f  %10.5f  %10.5f  %10.5f\n",
 	   name, absv(vec), vec[0], vec[1], vec[2]);
 }
-
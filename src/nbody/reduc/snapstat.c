@@ -19,6 +19,7 @@
  *      11-feb-19   1.6  add crossing time estimate
  *       8-apr-19   1.6c   fix times= bug
  *      11-apr-19   1.6d   add virial ration 2T/W
+ *      19-oct-26   1.7  tree (tol=) or parallel exact pair sums (exact=t)
  */
 
 /**************** INCLUDE FILES ********************************/ 
@@ -28,6 +29,7 @@
 #include <vectmath.h>
 #include <filestruct.h>
 #include <snapshot/snapshot.h>  
+#include <treepot.h>
 
 #ifndef HUGE
 # define  HUGE  1e20
@@ -42,7 +44,8 @@
 string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "in=???\n                   input file name ",
     "times=all\n                range of times to plot ",
-    "exact=f\n                  use hackforces or exact forces ",
+    "exact=f\n                  use tree forces or exact forces ",
+    "tol=0.7\n                  tree opening angle, if not exact ",
     "minradfrac=0.1\n           <1, for core radius det. ",
     "all=false\n                want to do all?",
     "pot=false\n                don't  all N*N calcu's ",
@@ -53,7 +56,7 @@ string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "rms=false\n                Want rms",
     "ecutoff=0.0\n              Cutoff for bound particles",
     "verbose=t\n                verbose mode?",
-    "VERSION=1.6d\n             11-apr-2019 PJT",
+    "VERSION=1.7\n              19-oct-2026 PJT",
     NULL
 };
 
@@ -88,7 +91,7 @@ local real **up, **vp, **wp;  /* pointers to velocities; for sorting */
 
 local string times;                           /* input parameters */
 local real minradfrac;
-local real eps, sqreps;
+local real eps, tol;
 local bool Qpot, Qr_v, Qr_c, Qr_h, Qrms, Qexact;
 local bool verbose;
 local real Ecutoff;
@@ -113,6 +116,9 @@ local real *epot=NULL;                              /* potential energies */
 local real *rad=NULL;                               /* radii */
 local int  *idr=NULL;                               /* index array for sorting */
 
+local void potential(void);
+local void minpair(void);
+
 
 /****************************** START OF PROGRAM **********************/
 
@@ -124,7 +130,7 @@ void nemo_main()
     times = getparam("times");
     minradfrac = getdparam("minradfrac");
     eps = getdparam("eps");
-    sqreps = eps*eps;
+    tol = getdparam("tol");
     Qpot = getbparam("pot");
     Qr_v = getbparam("r_v");
     Qr_c = getbparam("r_c");
@@ -135,8 +141,8 @@ void nemo_main()
     Qexact = getbparam("exact");
     if (getbparam("all"))
         Qpot=Qr_v=Qr_h=Qr_c=Qrms=TRUE;
-    need_phi = FALSE | Qexact | Qpot;
-    need_acc = FALSE | Qexact | Qpot;
+    need_phi = FALSE | Qpot | Qr_v;
+    need_acc = FALSE | Qpot;
     need_rad = TRUE;
     
     instr = stropen(getparam("in"), "r");
@@ -221,29 +227,6 @@ get_snap(stream instr) /* returns:   -1: not a snapshot   0: no ParticlesTag */
                 rad[i] += sqr(Pos(i)[j]);
             rad[i] = sqrt(rad[i]);
          }
-         if (Qexact)
-            exact(); /* timeconsuming - calculate exact forces/potential */
-         else {
-            if (need_phi) {
-                if (get_tag_ok(instr,PotentialTag)) {
-                    dprintf (2,"Reading %d potentials\n",nbody);
-                    get_data(instr, PotentialTag, RealType, phi, nbody, 0);
-                } else
-                    error("Need potentials in this snapshot or use exact=t");
-            }
-            if (need_acc) {
-               if (!get_tag_ok(instr,AccelerationTag)) {
-                  error("Need forces in this snapshot");
-                  dprintf (2,"Reading %d accelarations\n",nbody);
-                  get_data(instr, AccelerationTag, RealType, acc, nbody, NDIM, 0);
-                  for (i=0, p=acc; i<nbody; i++) {        /* kludge */
-                    ax[i] = *p++;
-                    ay[i] = *p++;
-                    az[i] = *p++;
-                  }
-	       }
-            }
-         }
       get_tes(instr, ParticlesTag);
     get_tes(instr,SnapShotTag);
 
@@ -281,32 +264,93 @@ snap_alloc()
     }
 }
 
-exact()                         /* exact potential and forces */
+local real sum_epot()
 {
-    int i,j,k;
-    real rij;
+    int i;
+    real sum = 0.0;
 
-    dprintf (2,"Doing an exact potential calculation\n");    
     for (i=0; i<nbody; i++)
-        phi[i] = 0;
-    for (i=1; i<nbody; i++) {
-        for (j=0; j<i; j++) {
-            rij = 0.0;
-            for (k=0; k<NDIM; k++)
-                rij += sqr(Pos(i)[k] - Pos(j)[k]);
-            rij = 1.0/sqrt(sqreps + rij);
-            phi[i] -= mass[j]*rij;              /* G==1 */
-            phi[j] -= mass[i]*rij;              /* G==1 */
+        sum += epot[i];
+    return sum;
+}
+
+/*
+ *  POTENTIAL:  potential energies and forces, exact or with a tree
+ *              and, for the virial radius, the sum of 1/r over all pairs
+ */
+
+local void potential(void)
+{
+    int i;
+    real *ones;
+
+    if (Qpot) {
+        if (Qexact)
+            exactpot(nbody, phase, 2*NDIM, mass, eps, phi, acc);
+        else
+            treepot(nbody, phase, 2*NDIM, mass, eps, tol, phi, acc);
+        for (i=0; i<nbody; i++) {
+            epot[i] = mass[i]*phi[i];
+            ax[i] = Acc(i)[0];
+            ay[i] = Acc(i)[1];
+            az[i] = Acc(i)[2];
         }
+        dprintf(2,"Total of body potentials = %f\n",0.5*sum_epot());
     }
-    rij=0;
-    for (i=0; i<nbody; i++)
-        rij +=  phi[i];
-    dprintf(2,"Total of body potentials = %f\n",rij);
+    if (Qr_v) {                         /* unit masses, no softening */
+        ones = (real *) allocate(nbody*sizeof(real));
+        for (i=0; i<nbody; i++)
+            ones[i] = 1.0;
+        if (Qexact)
+            exactpot(nbody, phase, 2*NDIM, ones, 0.0, phi, NULL);
+        else
+            treepot(nbody, phase, 2*NDIM, ones, 0.0, tol, phi, NULL);
+        for (i=0; i<nbody; i++)
+            r_v -= 0.5*phi[i];
+        free(ones);
+    }
+    if (Qexact)
+        minpair();
 }
 
+/*
+ *  MINPAIR:  smallest interparticle distance, rows in parallel
+ */
+
+local void minpair(void)
+{
+    int i1 = -1, i2 = -1;
+
+#pragma omp parallel
+    {
+        int i, j, k, im = -1, jm = -1;
+        real r2, rmin = HUGE;
+#pragma omp for schedule(dynamic,64) nowait
+        for (i=0; i<nbody; i++)
+            for (j=i+1; j<nbody; j++) {
+                r2 = 0.0;
+                for (k=0; k<NDIM; k++)
+                    r2 += sqr(Pos(i)[k] - Pos(j)[k]);
+                if (r2 < rmin) {
+                    rmin = r2;
+                    im = i;
+                    jm = j;
+                }
+            }
+#pragma omp critical
+        if (rmin < r2min || (rmin == r2min && im < i1)) {
+            r2min = rmin;
+            i1 = im;
+            i2 = jm;
+        }
+    }
+    if (i1 >= 0)
+        dprintf(1,"rmin=%g for (%d,%d) mass (%g,%g)\n",
+                sqrt(r2min),i1,i2,mass[i1],mass[i2]);
+}
+
+
 
-
 /*
  *  ANALYSIS:
  *    -  mean position & velocities as well as their dispersion
@@ -315,13 +359,12 @@ exact()                         /* exact potential and forces */
 
 analysis(int nbody)
 {
-        int i,j,i1,i2;
+        int i;
         real x,y,z,u,v,w;
-        real inv_rad, pmass, tmp, r2;
-        real xdir, ydir, zdir, artmp, axtmp, aytmp, aztmp;
+        real pmass;
 
         ini_analysis();
-        if (nbody>200 && Qpot && verbose)
+        if (nbody>200 && (Qpot || Qr_v) && Qexact && verbose)
                 dprintf (1,"Be patient...this operation takes a while\n");
                 
         for (i=0; i<nbody; i++) {
@@ -329,38 +372,9 @@ analysis(int nbody)
                 u = *up[i]; v = *vp[i]; w = *wp[i];     /* velocities */
                 pmass = mass[i];                              /* mass */
                 add_analysis (i,pmass,x,y,z,u,v,w);   /* add to analysis */
-
-                if (Qpot || Qr_v) 
-                   for (j=i+1; j<nbody; j++) {
-                        xdir = x - *xp[j];
-                        ydir = y - *yp[j];
-                        zdir = z - *zp[j];
-                        r2 = sqr(xdir) + sqr(ydir) + sqr(zdir);
-                        dprintf (2,"%d %d %f\n",i,j,sqrt(r2));
-                        if (r2<r2min) {
-			  i1=i;
-			  i2=j;
-			  r2min=r2;
-			  dprintf(1,"rmin=%g for (%d,%d) mass (%g,%g)\n",sqrt(r2min),i1,i2,mass[i1],mass[i2]);
-			}
-                        if (!Qacc) {
-                          artmp = mass[j]/((r2+sqreps)*sqrt(r2));  /* tmp force */
-                          axtmp = xdir*artmp;
-                          aytmp = ydir*artmp;
-                          aztmp = zdir*artmp;
-                          ax[i] -= axtmp;               ax[j] += axtmp;
-                          ay[i] -= aytmp;               ay[j] += aytmp;
-                          az[i] -= aztmp;               az[j] += aztmp;
-                        }
-                        if (Qpot) {
-                           tmp = mass[j] * pmass / sqrt(r2 + sqreps);
-                           epot[i] -= tmp;
-                           epot[j] -= tmp;
-                        }
-                        if (Qr_v)
-                           r_v += 1.0/sqrt(r2);
-                   }
         }
+        if (Qpot || Qr_v)
+                potential();
         report_analysis();
 }
 
@@ -437,7 +451,7 @@ report_analysis()
         printf ("vel:  %f +/- %f    %f +/- %f    %f +/- %f\n\n",
                        um  ,  us,   vm,    vs,   wm,    ws);
         }
-        if (verbose) { 
+        if (verbose && r2min < HUGE) {  /* only known for exact=t */
            printf ("Smallest interparticle distance = %f\n",sqrt(r2min));
         } 
         rmsvel = sqrt(us*us+vs*vs+ws*ws);
@@ -143,3 +143,12 @@ global int nbcterm;			/* num of body-cell terms evaluated */
 
 global bool debug;                     /* control debugging messages */
 global bool Qdensity;                  /* output density or kth neighbor distance */
+global int ndim;                       /* 3, or 2 to use X and Y only */
+
+/*
+ * Routines shared between the source files.
+ */
+
+void inputparams(void);                 /* hackdens.c: control parameters */
+void maketree(bodyptr, int, double);    /* load.c: build tree of bodies */
+int treebodies(bodyptr *);              /* load.c: bodies in tree order */
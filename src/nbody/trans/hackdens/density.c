@@ -6,12 +6,14 @@
  *	 1-apr-01  PJT  compiler warnings
  *      15-sep-06  WD   compiler error (in gcc-3.4.5)/warning (otherwise)
  *      20-oct-06  PJT  removed all old style declarations, all local routines
+ *      19-oct-26  PJT  walk is reentrant (no more pos0/pskip), for OpenMP;
+ *                      stop a walk once it has too many bodies; ndim=2
  */
 
 #include "defs.h"
 
-local void walksub(real, nodeptr, vector, real, real *, int *);
-local bool subdivp(real, vector, real);
+local void walksub(real, nodeptr, vector, real, vector, real *, int *, int);
+local bool subdivp(real, vector, real, vector);
 local real distcount(real *, int, int);
 
 real directden(p, nb, dis, ra, base, nbody)
@@ -39,12 +41,13 @@ real directden(p, nb, dis, ra, base, nbody)
     return (den);
 }
 
-real hackden(p, nb, dis, newdis, ra)
+real hackden(p, nb, dis, newdis, ra, nra)
     bodyptr p;
     int nb;
     real dis;
     real *newdis;
-    real *ra;
+    real *ra;			/* work space for distances */
+    int nra;			/* its length, at least nb*10 */
 {
     int total;
     real rn, nbr, den;
@@ -54,7 +57,7 @@ real hackden(p, nb, dis, newdis, ra)
 #endif    
     total=0; dis0=0; dismax=1.1e30;
     while(total < nb || total > nb*10){
-	hackcount(p, dis, ra, &total);
+	hackcount(p, dis, ra, &total, nra);
 	if(total < nb) {
 	   dis0=dis;
 	   if(dismax < 1e30){
@@ -73,7 +76,7 @@ real hackden(p, nb, dis, newdis, ra)
 
      }
     nbr=nb;
-    *newdis=1.5*dis*pow(nbr/total,0.333333);
+    *newdis=1.5*dis*pow(nbr/total,1.0/ndim);
 #ifdef DEBUG
     dprintf(0,"Hackcount returns: %d\n", total);
 #endif	
@@ -83,7 +86,10 @@ real hackden(p, nb, dis, newdis, ra)
 #endif
     if (Qdensity) {
       nbr = nb-2.0;
-      den=nbr/(rn*sqrt(rn)*FRTHRD_PI);
+      if (ndim == 2)
+	den=nbr/(rn*PI);
+      else
+	den=nbr/(rn*sqrt(rn)*FRTHRD_PI);
     } else
       den = rn;
 
@@ -125,69 +131,77 @@ local real distcount(ra ,total, nb)
     return(ra[nb-1]);
 }
 /*
- * HACKCOUNT: count the number of particles in a given radius.
+ * HACKCOUNT: count the number of particles in a given radius, and store
+ *	      the first nra squared distances in ra[]; a count above nra
+ *	      means there were more.  All state is in the arguments, so
+ *	      different threads can count at the same time.
  */
 
-local bodyptr pskip;			/* body to skip in force evaluation */
-local vector pos0;			/* point to evaluate field at */
-
-hackcount(p, dis, ra, total)
+hackcount(p, dis, ra, total, nra)
 bodyptr p;
 real dis;
 real *ra;
 int * total;
+int nra;
 {
-    pskip = p;					/* exclude p from f.c.      */
-    SETV(pos0, Pos(p));				/* set field point          */
-    hackwalk(dis, ra, total);			/* recursively compute      */
+    hackwalk(dis, Pos(p), ra, total, nra);	/* recursively compute      */
 }
-
+
 /*
  * HACKWALK: walk the tree opening cells too close to a given point.
  */
 
 
-hackwalk(dis, ra, total)
+hackwalk(dis, pos0, ra, total, nra)
 real dis;
+vector pos0;
 real *ra;
 int * total;
+int nra;
 {
     vector croot;
     int i;
     for(i=0; i<NDIM; i++)croot[i]=rmin[i]+rsize*0.5;
     *total=0;
-    walksub(dis, troot, croot, rsize, ra, total);
+    walksub(dis, troot, croot, rsize, pos0, ra, total, nra);
 }
 
 /*
  * WALKSUB: recursive routine to do hackwalk operation.
  */
 
-local void walksub(dis, p, cpos, d, ra, total)
+local void walksub(dis, p, cpos, d, pos0, ra, total, nra)
 real dis;			        /* critical displacement */
 register nodeptr p;                     /* pointer into body-tree */
 vector cpos;			        /* geometoric center of the node */
 real d;                                 /* size of box  */
+vector pos0;				/* point to count around */
 real * ra;			/* array to store distances to */
 				/* particles within sphere */
 int *total;			/* number of particles in the sphere */
+int nra;			/* length of ra */
 {
     register nodeptr *pp;
     register int i,j;
     register int k;
     real offset, r2;
     vector cpossub, disp;
+    if (*total > nra) return;			/* too many already         */
     offset = d*0.25;
     dprintf(1,"walksub: p = %o  d = %f\n", p, d);
     if (Type(p) == BODY){
 	r2=0.0;
 	SUBV(disp, Pos(p), pos0);               /* compute displacement     */
-	DOTVP(r2, disp, disp);                  /* and find dist squared    */
+	if (ndim == 2)
+	    r2 = disp[0]*disp[0] + disp[1]*disp[1];
+	else
+	    DOTVP(r2, disp, disp);              /* and find dist squared    */
 	if(r2 < dis*dis){
+	    if (*total < nra)
+		ra[*total]=r2;
 	    *total +=1;
-	    ra[*total-1]=r2;
 	}
-    }else if (subdivp(dis, cpos, d)) {          /* should p be opened?      */
+    }else if (subdivp(dis, cpos, d, pos0)) {    /* should p be opened?      */
         pp = & Subp(p)[0];                      /*   point to sub-cells     */
         for (k = 0; k < NSUB; k++) {            /*   loop over sub-cells    */
 	    for(i=NDIM-1, j=1; i>=0; i--, j*=2){
@@ -198,32 +212,36 @@ int *total;			/* number of particles in the sphere */
 		}
 	    }
             if (*pp != NULL)                    /*     does this one exist? */
-                walksub(dis,*pp, cpossub, d*0.5, ra, total);
+                walksub(dis,*pp, cpossub, d*0.5, pos0, ra, total, nra);
             pp++;                               /*     point to next one    */
         }
     }
 }
-
+
 /*
  * SUBDIVP: decide if a node should be opened.
  * true if need to subdivide
  */
 
-local bool subdivp(dis, cpos, d)
+local bool subdivp(dis, cpos, d, pos0)
 real dis;			        /* critical separation  */
 vector cpos;			        /* geometrical center of the node */
 real d;                                 /* size of cell squared */
+vector pos0;				/* point to count around */
 {
     int i;
     vector dr;
     real drsq, lcrit;
     SUBV(dr, cpos, pos0);                     /* compute displacement     */
-    for (i=0; i<3; i++){
+    for (i=0; i<ndim; i++){
 	if(ABS(dr[i]) > dis+d*0.5){
 	    return (0);
 	}
     }
-    DOTVP(drsq, dr, dr);                        /* and find dist squared    */
+    if (ndim == 2)
+	drsq = dr[0]*dr[0] + dr[1]*dr[1];
+    else
+	DOTVP(drsq, dr, dr);                    /* and find dist squared    */
     lcrit= dis + 0.875*d;	                /* critical separation */
     lcrit = lcrit*lcrit;
     return (drsq < lcrit);                /* use geometrical rule     */
@@ -12,6 +12,9 @@
  *     25-apr-06  V2.2b  use global to isolate extern's (for Mac linking)
  *     28-jul-06  V2.2c  default for tag is now Density
  *                V2.2d  clarify D vs. P, working with std snapshot, not archaic
+ *     19-oct-26  V3.0   parallel searches in tree order, each starting from the
+ *                       radius of the previous body; ndim=2; all snapshots
+ *                       unless first=t				PJT
  *
  * TODO:  this program seems to assume m_i = 1, so for unequal masses wrong
  */
@@ -23,6 +26,10 @@
 #include <filestruct.h>
 #include <snapshot/snapshot.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 string defv[] = {	
     "in=???\n			  input snapshot",
     "out=\n			  output file with f.c. results ",
@@ -36,8 +43,9 @@ string defv[] = {
     "nudge=0\n                    nudge overlapping particles with this dispersion",
     "verbose=f\n		  flag to print # of particles finished ",
     "density=t\n                  write density, or distance to Kth particle",
-    "ndim=3\n                     3D or 2D computation",
-    "VERSION=2.2d\n		  6-jan-2009 PJT",
+    "ndim=3\n                     3D or 2D (in X-Y) computation",
+    "first=t\n                    Only process the first snapshot?",
+    "VERSION=3.0\n		  19-oct-2026 PJT",
     NULL,
 };
 
@@ -46,33 +54,51 @@ string usage = "hackcode local density calculation tool";
 string cvsid="$Id$";
 
 
-nemo_main()
-{
-    inputdata();			/* input mass and test data */
-    dencalc();				/* find force at test pos */
-    outresult();			/* write snap with results */
-}
-
-bodyptr massdata;		/* array of mass points */
+bodyptr massdata = NULL;	/* array of mass points */
 int nmass;			/* number of mass points */
 
 bodyptr testdata;		/* array of test points */
 int ntest;			/* number of test points */
 
-inputdata()
+stream instr = NULL;		/* input file */
+stream outstr = NULL;		/* output file, if any */
+int nframe = 0;			/* snapshots processed so far */
+
+nemo_main()
 {
-    string input;
-    stream instr;
+    bool Qfirst = getbparam("first");
 
-    input = getparam("in");
-    instr = stropen(input, "r");
+    inputparams();			/* get the control parameters */
+    while (inputdata()) {		/* input mass and test data */
+	dencalc();			/* find density at test pos */
+	outresult();			/* write snap with results */
+	if (Qfirst) break;
+    }
+    if (outstr) strclose(outstr);
+}
+
+void inputparams(void)
+{
+    instr = stropen(getparam("in"), "r");
     Qdensity = getbparam("density");
-    readsnapshot(&massdata, &nmass, instr);	/* read mass coord data */
-    strclose(instr);
+    ndim = getiparam("ndim");
+    if (ndim != 2 && ndim != NDIM)
+	error("ndim=%d not supported, use 2 or %d", ndim, NDIM);
+}
+
+inputdata()
+{
+    if (massdata != NULL) free(massdata);	/* previous snapshot */
+    if (!readsnapshot(&massdata, &nmass, instr)) {
+	if (nframe == 0) error("No snapshot found in %s", getparam("in"));
+	return 0;
+    }
+    nframe++;
     testdata = massdata;
     ntest = nmass;
+    return 1;
 }
-
+
 real tsnap;
 
 readsnapshot(btab_ptr, nobj_ptr, instr)
@@ -84,19 +110,31 @@ stream instr;					/* stream to read from */
     real *mbuf, *mp, *pbuf, *pp;
     bodyptr bp;
 
-    get_history(instr);
-
-    get_set(instr, SnapShotTag);
-    get_set(instr, ParametersTag);
-    if (get_tag_ok(instr, TimeTag)) {
-	get_data_coerced(instr, TimeTag, RealType, &tsnap, 0);
-    }else{
-	tsnap=0.0;
+    for (;;) {				/* until a snapshot with particles */
+	get_history(instr);
+	if (!get_tag_ok(instr, SnapShotTag))
+	    return 0;
+	get_set(instr, SnapShotTag);
+	if (!get_tag_ok(instr, ParametersTag)) {
+	    get_tes(instr, SnapShotTag);
+	    continue;
+	}
+	get_set(instr, ParametersTag);
+	if (get_tag_ok(instr, TimeTag)) {
+	    get_data_coerced(instr, TimeTag, RealType, &tsnap, 0);
+	}else{
+	    tsnap=0.0;
+	}
+	get_data(instr, NobjTag, IntType, &nobj, 0);
+	if (nobj < 1)
+	    error("readsnapshot: %s = %d  is absurd\n", NobjTag, nobj);
+	get_tes(instr, ParametersTag);
+	if (!get_tag_ok(instr, ParticlesTag)) {
+	    get_tes(instr, SnapShotTag);
+	    continue;
+	}
+	break;
     }
-    get_data(instr, NobjTag, IntType, &nobj, 0);
-    if (nobj < 1)
-	error("readsnapshot: %s = %d  is absurd\n", NobjTag, nobj);
-    get_tes(instr, ParametersTag);
     get_set(instr, ParticlesTag);
     get_data(instr, CoordSystemTag, IntType, &cs, 0);
     if (cs != CSCode(Cartesian, NDIM, 2))
@@ -124,28 +162,45 @@ stream instr;					/* stream to read from */
     free(mbuf);
     free(pbuf);
     *nobj_ptr = nobj;
+    return 1;
 }
-
-real *dendata;			/* local density */
+
+real *dendata = NULL;		/* local density */
 
 int n2btot, nbctot;		/* body-body, body-cell interactions */
 
 real cputree, cpufcal;		/* CPU time to build tree, compute forces */
 
+#define CHUNK  256		/* bodies handed out to a thread at a time */
+
+/*
+ * DENCALC: the neighbour searches are independent, and are done in
+ * parallel.  Bodies are visited in tree order, so each search can start
+ * from the radius estimated by the previous one, a nearby body with a
+ * similar density, and the input need not be sorted.  The result does
+ * not depend on this order, or on the starting radii.
+ */
+
 dencalc()
 {
     real hackden(), directden();
-    real *pp, *work, rneib, newrneib, nudge;
-    int neibnum;
+    real *work, rneib, nudge;
+    int neibnum, ncap, nthread = 1;
     double cputime(), cpubase, atof();
     string *burststring(), *rminxstr;
-    int xstrlen(), i, ibody;
-    bodyptr bp;
+    int xstrlen(), i, nlist;
+    bodyptr bp, *blist;
     bool verbose;
 
+#if defined(_OPENMP)
+    nthread = omp_get_max_threads();
+#endif
     verbose=getbparam("verbose");
     rneib=getdparam("rneib");
     neibnum=getiparam("neib")+1;
+    if (neibnum > nmass)
+	error("neib=%d needs more than %d bodies", neibnum-1, nmass);
+    ncap = 10*neibnum;			/* see hackden() */
     nudge = getdparam("nudge");
     if (nudge > 0) {
       set_xrandom(0);   /* should use seed= */
@@ -160,7 +215,7 @@ dencalc()
 #ifdef DEBUG
     dprintf(0,"neib=%d rneib=%f\n", neibnum, rneib);
 #endif    
-    rsize = getdparam("rsize");
+    rsize = getdparam("rsize");		/* each snapshot its own tree */
     rminxstr = burststring(getparam("rmin"), ", ");
     if (xstrlen(rminxstr, sizeof(string)) < NDIM) {
 	SETVS(rmin, - rsize / 2.0);
@@ -170,9 +225,11 @@ dencalc()
     dprintf(0,"initial rsize: %8f    rmin: %8f  %8f  %8f\n",
 	   rsize, rmin[0], rmin[1], rmin[2]);
     fcells = getdparam("fcells");
-    dendata = pp = (real *) malloc(ntest * sizeof(real));
-    work = (real *) malloc(ntest * sizeof(real));
-    if (pp == NULL||work==NULL){
+    if (dendata != NULL) free(dendata);
+    dendata = (real *) malloc(ntest * sizeof(real));
+    work = (real *) malloc(nthread * ncap * sizeof(real));
+    blist = (bodyptr *) malloc(ntest * sizeof(bodyptr));
+    if (dendata == NULL || work == NULL || blist == NULL){
 	error("forcecalc: not enuf memory for results\n");
     }
     cpubase = cputime();
@@ -180,24 +237,37 @@ dencalc()
     cputree = cputime() - cpubase;
     dprintf(0,"  final rsize: %8f    rmin: %8f  %8f  %8f\n",
 	   rsize, rmin[0], rmin[1], rmin[2]);
+    nlist = treebodies(blist);			/* bodies in tree order */
+    for (bp = testdata; bp < testdata+ntest; bp++)
+	if (Mass(bp) == 0.0)			/* and those not in the tree */
+	    blist[nlist++] = bp;
     cpubase = cputime();
     n2btot = nbctot = 0;
-    ibody=0;
-    for (bp = testdata; bp < testdata+ntest; bp++) {
+#pragma omp parallel num_threads(nthread) private(i,bp)
+    {
+	int t = 0;
+	real rn = rneib, newrn;
+
+#if defined(_OPENMP)
+	t = omp_get_thread_num();
+#endif
+#pragma omp for schedule(dynamic,CHUNK)
+	for (i = 0; i < ntest; i++) {
+	    bp = blist[i];
 #if 0
-	dprintf(0,"DirectDen= %f\n", directden(bp, neibnum, rneib, work,
-					    testdata, ntest));
+	    dprintf(0,"DirectDen= %f\n", directden(bp, neibnum, rneib, work,
+						testdata, ntest));
 #endif	
-	*pp = hackden(bp, neibnum, rneib, &newrneib, work);
-	rneib=0.95*rneib+0.05*newrneib;
-	pp++;
-	ibody++;
-	if(verbose && ibody%100==0)dprintf(0," %d rn=%f\n", ibody,rneib);
+	    dendata[bp-testdata] = hackden(bp, neibnum, rn, &newrn,
+					   work + t*ncap, ncap);
+	    rn = newrn;				/* guess for the next body */
+	    if(verbose && (i+1)%100==0)dprintf(0," %d rn=%f\n", i+1, rn);
+	}
     }
     cpufcal = cputime() - cpubase;
+    free(blist);
+    free(work);
 }
-
-stream outstr;
 
 outresult()
 {
@@ -205,10 +275,11 @@ outresult()
 
     out = getparam("out");
     if (*out != 0) {
-	outstr = stropen(out, "w");
-	put_history(outstr);
+	if (outstr == NULL) {
+	    outstr = stropen(out, "w");
+	    put_history(outstr);
+	}
 	writesnapshot();			/* output testdata results */
-	strclose(outstr);
     }
 }
 
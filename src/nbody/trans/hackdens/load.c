@@ -1,12 +1,13 @@
 /*
  * LOAD.C: routines to create body-tree.
- * Public routines: maketree().
+ * Public routines: maketree(), treebodies().
  *
  *	19-jun-92  PJT  replaced an 'assert' by 'error' call
  *      18-jul-92  PJT  replaced many if(debug)printf(...) by dprintf(1,...)
  *      24-may-02  pjt  while waiting for the coffee to brew.... laptop on lap....
  *                      changed the 32bit depth treebuild to 64bit... (see int_hack)
  *      29-mar-02  pjt  add 'nudge' to maketree
+ *      19-oct-26  pjt  treebodies(); more cells if a later snapshot needs them
  */
 
 #include "defs.h"
@@ -21,6 +22,7 @@ static bool intcoord(int_hack xp[3], vector rp);
 static int_hack subindex(int_hack x[3], int_hack l);
 static hackcofm(register nodeptr q);
 static cellptr makecell(void);
+static void listbodies(nodeptr q, bodyptr *blist, int *n);
 
 extern double xrandom(double,double);
 
@@ -29,14 +31,15 @@ extern double xrandom(double,double);
  * MAKETREE: initialize tree structure for hack force calculation.
  */
 
-maketree(
+void maketree(
 	 bodyptr btab,			/* array of bodies to build into tree */
 	 int nbody,			/* number of bodies in above array */
 	 double nudge)
 {
     register bodyptr p;
 
-    if (ctab == NULL) {				/* first time through?      */
+    if (ctab == NULL || fcells * nbody > maxcell) {  /* first, or bigger? */
+	if (ctab != NULL) free(ctab);
 	maxcell = fcells * nbody;		/*   typ. need: 0.5 nbody   */
 	ctab = (cellptr) allocate(maxcell * sizeof(cell));  /* alloc  cells */
     }
@@ -50,6 +53,33 @@ maketree(
     hackcofm(troot);				/* find c-of-m coordinates  */
 }
 
+/*
+ * TREEBODIES: list the bodies in the tree in the order of a depth first
+ * walk, so bodies close in the list are close in space.
+ * Returns: the number of bodies listed.
+ */
+
+int treebodies(bodyptr *blist)
+{
+    int n = 0;
+
+    if (troot != NULL)
+	listbodies(troot, blist, &n);
+    return n;
+}
+
+local void listbodies(nodeptr q, bodyptr *blist, int *n)
+{
+    int i;
+
+    if (Type(q) == BODY)
+	blist[(*n)++] = (bodyptr) q;
+    else
+	for (i = 0; i < NSUB; i++)
+	    if (Subp(q)[i] != NULL)
+		listbodies(Subp(q)[i], blist, n);
+}
+
 /*
  * EXPANDBOX: enlarge cubical "box", salvaging existing tree structure.
  */
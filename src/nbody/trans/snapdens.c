@@ -16,6 +16,7 @@
  *     12-apr-03        V1.5 add nn= keyword for atlas  PJT
  *     29-dec-04            a   forgotten m2tot=0       PJT
  *      5-apr-06            c   ndim not set            PJT
+ *     19-oct-26        V2.0 kd-tree NN search, parallel, no kmax limit  PJT
  */
 
 #include <stdinc.h>
@@ -23,6 +24,9 @@
 #include <math.h>
 #include <vectmath.h>		/* otherwise NDIM undefined */
 #include <filestruct.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include <snapshot/snapshot.h>	
 #include <snapshot/body.h>
@@ -39,7 +43,7 @@ string defv[] = {
     "tfactor=-1.0\n               conversion factor v->r [virial=sqrt(2)]",
     "nn=f\n                       add NN index to the Key field?",
     "ndim=3\n                     3dim or 2dim densities?",
-    "VERSION=1.5c\n		  5-apr-2006 PJT",
+    "VERSION=2.0\n		  19-oct-2026 PJT",
     NULL,
 };
 
@@ -55,23 +59,61 @@ string cvsid="$Id$";
 #define FAC5   1.0              /* T.B.D. */
 #define FAC6   1.0              /* T.B.D. */
 
-#define MAXK   256
+#define NLEAF  8                /* max number of bodies in a kd-tree leaf */
 
-int   iindex[MAXK+1];             /* pointer to nearest neighbours */
-Body  *bindex[MAXK+1];            /* pointer to body */
-real  r[MAXK+1];                  /* radius squared to nearest neighbours */
+/*
+ * The K nearest neighbours of all bodies are found with a kd-tree over
+ * the positions (or positions and tfactor-scaled velocities), each body
+ * being a separate query.  These are independent and done in parallel
+ * if compiled with OpenMP; the neighbour list of a query is kept in a
+ * bounded max-heap, one per thread.  Ties in distance are broken by body
+ * index, so the neighbours and their order are those of the old N^2 scan.
+ */
+
+typedef struct {
+    int  lo, hi;                /* range of bodies in perm[] */
+    int  dim;                   /* split dimension, -1 for a leaf */
+    real split;                 /* split coordinate */
+    int  left, right;           /* child nodes */
+} kdnode;
+
+typedef struct {
+    int   n;                    /* current length of the list */
+    real *r;                    /* radius squared to nearest neighbours */
+    int  *idx;                  /* index of nearest neighbours */
+} knnlist;
+
+typedef struct {
+    real dens, fc, fc2;         /* (phase space) density estimates */
+    real rad, sigma, sigma2;    /* K-th NN radius, velocity dispersion */
+    real r0;                    /* radius squared to nearest neighbour */
+    int  nn;                    /* index of nearest neighbour */
+} nnstat;
 
 Body  *btab = NULL;               /* pointer to snapshot Body datastructure */
-int   nbody, kmax, klen, ndim;
+int   nbody, kmax, ndim;
 
 bool  Qdens, Qtab, Qnn;
 char  *fmt;
 real  tfactor;
 
+local int    *perm = NULL;        /* bodies, in kd-tree order */
+local kdnode *kdtree = NULL;      /* the kd-tree, root is node 0 */
+local int    nnode, kdim;         /* number of nodes, dimensions of tree */
+local real   kfac[2*NDIM];        /* scale factor of each tree dimension */
+
 local void density(void);
 local real raddif(Body *, Body *);
-local void stat_nn(Body *);
-
+local void stat_nn(int, knnlist *, nnstat *);
+local void put_nn(Body *, nnstat *);
+local void build_tree(void);
+local int  make_node(int, int);
+local void select_nn(int, int, int, int);
+local void search_nn(int, int, knnlist *);
+local void insert_nn(knnlist *, real, int);
+local void sift_nn(knnlist *, int, int, real, int);
+local void sort_nn(knnlist *);
+
 
 nemo_main()
 {
@@ -79,7 +121,7 @@ nemo_main()
     real   tsnap, dm;
     string headline=NULL;
     int i, bits;
-    Body   *bi, *bj;
+    Body   *bi;
 					
     instr =  stropen(getparam("in"),  "r");
     if (hasvalue("out"))
@@ -87,8 +129,8 @@ nemo_main()
     else
         outstr = NULL;
     kmax = getiparam("kmax");
-    if (kmax > MAXK)
-        error("parameter kmax=%d too large (%d)",kmax,MAXK);
+    if (kmax < 1)
+        error("parameter kmax=%d must be positive",kmax);
     Qdens = getbparam("dens"); 
     Qtab = getbparam("tab");  
     Qnn = getbparam("nn");  
@@ -97,6 +139,8 @@ nemo_main()
     if (Qdens && tfactor>0)
         warning("tfactor & Qdens incomplete");
     ndim = getiparam("ndim");
+    if (ndim != 2 && ndim != 3)
+        error("ndim=%d must be 2 or 3",ndim);
 
     /* only do one (the first) snapshot */
 
@@ -108,6 +152,8 @@ nemo_main()
         get_snap(instr, &btab, &nbody, &tsnap, &bits);
 	if ( (bits & PhaseSpaceBit)==0)
 	  error("need phasespace in snapshot");
+	if (kmax >= nbody)
+	  error("parameter kmax=%d too large, need less than nbody=%d",kmax,nbody);
 	if ( (bits & MassBit)==0) {
 	  warning("no masses in snapshot, assume M=1, m_i=1/%d",nbody);
 	  dm = 1.0 / (double) nbody;
@@ -128,13 +174,44 @@ nemo_main()
       strclose(outstr);
 }
 
-
+
 local void density(void)
 {
     double tmp2, drmin, mtot, m2tot, rdtot, com[NDIM], rmtot[NDIM], mmax;
-    Body  *bi, *bj;
-    int    i, j, k, kk;
-    
+    Body  *bi;
+    int    i, j, nthread = 1;
+    bool   Qpar = !nemo_debug(2);
+    real  *rbuf;
+    int   *ibuf;
+    nnstat *st;
+
+    build_tree();
+#if defined(_OPENMP)
+    nthread = omp_get_max_threads();
+#endif
+    rbuf = (real *) allocate(nthread*kmax*sizeof(real));
+    ibuf = (int *) allocate(nthread*kmax*sizeof(int));
+    st = (nnstat *) allocate(nbody*sizeof(nnstat));
+
+    /* the NN lists at debug=2 are printed in body order, so do not thread */
+#pragma omp parallel if(Qpar)
+    {
+        knnlist nl;
+        int n, t = 0;
+#if defined(_OPENMP)
+        t = omp_get_thread_num();
+#endif
+        nl.r = rbuf + t*kmax;
+        nl.idx = ibuf + t*kmax;
+#pragma omp for schedule(dynamic,64)
+        for (n=0; n<nbody; n++) {
+            nl.n = 0;
+            search_nn(0, n, &nl);
+            sort_nn(&nl);
+            stat_nn(n, &nl, &st[n]);
+        }
+    }
+
     drmin = HUGE;       /* init minimum interparticle distance */
     mmax = -HUGE;       /* init maximum density */
     rdtot = 0.0;
@@ -142,37 +219,9 @@ local void density(void)
         rmtot[j] = 0.0;
     mtot = m2tot = 0.0;
     for (i=0, bi=btab; i<nbody; i++, bi++) {
-        klen = 0;                   /* reset nearest neighbours list length */
-        for (k=0; k<=kmax; k++) {          /* .. and index pointers etc */
-            iindex[k] = -1;
-            bindex[k] = NULL;
-            r[k] = HUGE;
-        }
-        for (j=0, bj=btab; j<nbody; j++, bj++) { /* look at all other stars */
-            if (i==j)                            /* except itself */
-                continue;
-            tmp2 = raddif(bi,bj);                /* radius diff squared */
-            if (tmp2 < drmin)
-                drmin = tmp2;
-            if (tmp2 > r[klen])          /* if already larger than largest */
-                continue;                        /* goto next star 'j' */
-            for (k=0; k<=klen; k++) {     /* check where to insert in list */
-                if (tmp2 < r[k]) {
-                    if (klen<kmax)               /* increase list length */
-                        klen++;
-                    for (kk=klen-1; kk>k; kk--) {/* shift higher values */
-                        r[kk] = r[kk-1];
-                        iindex[kk] = iindex[kk-1];
-                        bindex[kk] = bindex[kk-1];
-                    } /* for-kk */
-                    r[k] = tmp2;                 /* and insert in list */
-                    iindex[k] = j;
-                    bindex[k] = bj;
-                    break;                       /* done with k-loop */
-                } /* if */
-            } /* for-k */
-        } /* for-j */
-        stat_nn(bi);                       /* statistics of NN list stars */
+        if (st[i].r0 < drmin)
+            drmin = st[i].r0;
+        put_nn(bi, &st[i]);
         for (j=0; j<NDIM; j++) {
             rmtot[j] += Aux(bi) * Pos(bi)[j]; /* (phase space) density weight */
         }
@@ -181,6 +230,11 @@ local void density(void)
         if (Aux(bi) > mmax)
             mmax = Aux(bi);
     } /* for-i */
+    free(st);
+    free(ibuf);
+    free(rbuf);
+    free(kdtree);
+    free(perm);
 /* Table header in debug mode */
     dprintf(1,"Weighted_c_o_m[%d]  ",NDIM);
     dprintf(1,"Nearest_neighbor_distance   ");
@@ -223,15 +277,15 @@ local real raddif(Body *bi, Body *bj)
     
     return rtmp;
 }
-
+
 /*  stat_nn:   some statistics on the K nearest neighbors of a star
- *
+ *             the list must be sorted in increasing distance
  */
-local void stat_nn(Body *bi)
+local void stat_nn(int n, knnlist *nl, nnstat *st)
 {
-    real sigma, sigma2, rad, dens, fc, fc2, radius;
+    real sigma, sigma2, rad, dens, fc, fc2;
     real v1[NDIM], v2[NDIM], s[NDIM];
-    int i, k;
+    int i, k, klen = nl->n;
     Body *bp;
     
     dens = sigma = sigma2 = 0.0;
@@ -240,26 +294,20 @@ local void stat_nn(Body *bi)
     }
     dprintf(2,"NN[%d] list: ",klen);
     for (k=0; k<klen; k++) {            /* loop over nearest neighbors */
-        bp = bindex[k];
-	dprintf(2," %d",iindex[k]);
+        bp = btab + nl->idx[k];
+	dprintf(2," %d",nl->idx[k]);
         if (k<klen-1) dens += Mass(bp); /* eq (II.2) in CH 1985 ApJ 298,80) */
         for (i=0; i<NDIM; i++) {
             v1[i] += Vel(bp)[i];
             v2[i] += Vel(bp)[i] * Vel(bp)[i];
         }
     }
+    rad = sqrt(nl->r[klen-1]);  /* radius of K-th nearest neighbor */
     dprintf(2," (dens=%g rad=%g)\n",dens,rad);
-    rad = sqrt(r[klen-1]);      /* radius of K-th nearest neighbor */
     if (ndim == 3)
       dens /= (rad*rad*rad*FAC1);        /* space density estimate */
-    else if (ndim == 2)
-      dens /= (rad*rad*FAC4);            /* surface density estimate */
     else
-      error("ndim=%d must be 2 or 3",ndim);
-    if (klen!=kmax) {       /* should never occur */
-        error ("DENSITY  %f %f %f %f klen=%d\n",rad,dens,0.0,0.0,klen);
-        return;
-    }
+      dens /= (rad*rad*FAC4);            /* surface density estimate */
     for (i=0; i<NDIM; i++) {
         s[i] = v2[i]/(double)klen - sqr(v1[i]/(double)klen);
         sigma += s[i];
@@ -269,28 +317,232 @@ local void stat_nn(Body *bi)
     if (ndim == 3) {
       fc = dens / (sigma*sigma*sigma*FAC2);  /* phase space density estimate */
       fc2 = dens / qbe(rad/tfactor) / FAC3;    /* new 6D phase space estimate */
-    } else if (ndim == 2) {
+    } else {
       fc = dens / (sigma*sigma*FAC5);        /* phase space density estimate TODO: get FAC5 */
       fc2 = dens / sqr(rad/tfactor) / FAC6;
     }
 
-    Aux(bi) = (Qdens ? dens : fc);        /* replace (phase space) density */
+    st->dens = dens;
+    st->fc = fc;
+    st->fc2 = fc2;
+    st->rad = rad;
+    st->sigma = sigma;
+    st->sigma2 = sigma2;
+    st->r0 = nl->r[0];
+    st->nn = nl->idx[0];
+}
+
+/*  put_nn:   store the estimates of a star, and optionally tabulate them
+ */
+local void put_nn(Body *bi, nnstat *st)
+{
+    real radius;
+
+    Aux(bi) = (Qdens ? st->dens : st->fc); /* replace (phase space) density */
     if (Qnn)
-      Key(bi) = iindex[0];
-    if (tfactor>0 && !Qdens)  Aux(bi) = fc2;	/* new new */
+      Key(bi) = st->nn;
+    if (tfactor>0 && !Qdens)  Aux(bi) = st->fc2;	/* new new */
     if (Qtab) {
         ABSV(radius,Pos(bi));
-        printf(fmt,radius);       printf(" ");
-        printf(fmt,dens);         printf(" ");
-        printf(fmt,fc);           printf(" ");
-        printf(fmt,rad);          printf(" ");
-        printf(fmt,sigma);        printf (" ");
-        printf(fmt,sqrt(sigma2)); printf (" ");	/* debug */
-        if (tfactor > 0) printf(fmt,fc2);          
+        printf(fmt,radius);           printf(" ");
+        printf(fmt,st->dens);         printf(" ");
+        printf(fmt,st->fc);           printf(" ");
+        printf(fmt,st->rad);          printf(" ");
+        printf(fmt,st->sigma);        printf (" ");
+        printf(fmt,sqrt(st->sigma2)); printf (" ");	/* debug */
+        if (tfactor > 0) printf(fmt,st->fc2);
 	printf ("\n");
 
     }
 }
 
+/* coordinate k of body i in the kd-tree; velocities follow positions */
+
+#define COORD(i,k)  ((k)<NDIM ? Pos(btab+(i))[k] : Vel(btab+(i))[(k)-NDIM])
+
+/*  build_tree:   kd-tree over all bodies, in the metric of raddif()
+ */
+local void build_tree(void)
+{
+    int i, k;
+
+    kdim = (tfactor > 0.0 ? 2*NDIM : NDIM);
+    for (k=0; k<kdim; k++)
+        kfac[k] = (k<NDIM ? 1.0 : tfactor);
+    perm = (int *) allocate(nbody*sizeof(int));
+    for (i=0; i<nbody; i++)
+        perm[i] = i;
+    /* leaves hold at least NLEAF/2 bodies, so this is plenty */
+    kdtree = (kdnode *) allocate((nbody+1)*sizeof(kdnode));
+    nnode = 0;
+    (void) make_node(0, nbody);
+    dprintf(1,"kd-tree: %d nodes for %d bodies in %d dimensions\n",
+            nnode, nbody, kdim);
+}
+
+/*  make_node:   node for perm[lo..hi-1], split at the median of the
+ *               dimension with the largest (scaled) extent
+ */
+local int make_node(int lo, int hi)
+{
+    int n = nnode++, i, k, mid;
+    real x, xmin, xmax, ext, emax;
+
+    kdtree[n].lo = lo;
+    kdtree[n].hi = hi;
+    kdtree[n].dim = -1;
+    if (hi-lo <= NLEAF)
+        return n;
+    emax = -1.0;
+    for (k=0; k<kdim; k++) {
+        xmin = xmax = COORD(perm[lo],k);
+        for (i=lo+1; i<hi; i++) {
+            x = COORD(perm[i],k);
+            if (x < xmin) xmin = x;
+            else if (x > xmax) xmax = x;
+        }
+        ext = (xmax-xmin)*kfac[k];
+        if (ext > emax) {
+            emax = ext;
+            kdtree[n].dim = k;
+        }
+    }
+    k = kdtree[n].dim;
+    mid = (lo+hi)/2;
+    select_nn(lo, hi-1, mid, k);
+    kdtree[n].split = COORD(perm[mid],k);
+    kdtree[n].left  = make_node(lo, mid);
+    kdtree[n].right = make_node(mid, hi);
+    return n;
+}
+
+/*  select_nn:   partially order perm[l..ir] in dimension k, such that
+ *               perm[m] is in its sorted place (Numerical Recipes select)
+ */
+#define SWAP_NN(a,b)  { tmp=perm[a]; perm[a]=perm[b]; perm[b]=tmp; }
+
+local void select_nn(int l, int ir, int m, int k)
+{
+    int i, j, mm, tmp, p;
+    real a;
+
+    for (;;) {
+        if (ir <= l+1) {
+            if (ir == l+1 && COORD(perm[ir],k) < COORD(perm[l],k))
+                SWAP_NN(l,ir);
+            return;
+        }
+        mm = (l+ir) >> 1;
+        SWAP_NN(mm,l+1);
+        if (COORD(perm[l],k)   > COORD(perm[ir],k))  SWAP_NN(l,ir);
+        if (COORD(perm[l+1],k) > COORD(perm[ir],k))  SWAP_NN(l+1,ir);
+        if (COORD(perm[l],k)   > COORD(perm[l+1],k)) SWAP_NN(l,l+1);
+        i = l+1;
+        j = ir;
+        p = perm[l+1];
+        a = COORD(p,k);
+        for (;;) {
+            do i++; while (COORD(perm[i],k) < a);
+            do j--; while (COORD(perm[j],k) > a);
+            if (j < i) break;
+            SWAP_NN(i,j);
+        }
+        perm[l+1] = perm[j];
+        perm[j] = p;
+        if (j >= m) ir = j-1;
+        if (j <= m) l = i;
+    }
+}
+
+/*  search_nn:   add the bodies of node n to the NN list of body i; the
+ *               far child is skipped if it cannot hold a closer body
+ */
+local void search_nn(int n, int i, knnlist *nl)
+{
+    kdnode *np = kdtree + n;
+    int p, j, n1, n2;
+    real d;
 
+    if (np->dim < 0) {
+        for (p=np->lo; p<np->hi; p++) {
+            j = perm[p];
+            if (j != i)                          /* except itself */
+                insert_nn(nl, raddif(btab+i, btab+j), j);
+        }
+        return;
+    }
+    d = (COORD(i,np->dim) - np->split) * kfac[np->dim];
+    if (d < 0.0) {
+        n1 = np->left;
+        n2 = np->right;
+    } else {
+        n1 = np->right;
+        n2 = np->left;
+    }
+    search_nn(n1, i, nl);
+    if (nl->n < kmax || d*d <= nl->r[0])
+        search_nn(n2, i, nl);
+}
 
+/* NN list order: by radius, then by index */
+
+#define FARTHER(r1,i1,r2,i2)  ((r1) > (r2) || ((r1) == (r2) && (i1) > (i2)))
+
+/*  insert_nn:   insert body j at radius squared r2 in the NN list, which
+ *               is a max-heap of at most kmax entries
+ */
+local void insert_nn(knnlist *nl, real r2, int j)
+{
+    int c, p;
+
+    if (nl->n < kmax) {
+        c = nl->n++;
+        while (c > 0) {
+            p = (c-1)/2;
+            if (!FARTHER(r2,j,nl->r[p],nl->idx[p]))
+                break;
+            nl->r[c] = nl->r[p];
+            nl->idx[c] = nl->idx[p];
+            c = p;
+        }
+        nl->r[c] = r2;
+        nl->idx[c] = j;
+    } else if (FARTHER(nl->r[0],nl->idx[0],r2,j))
+        sift_nn(nl, 0, nl->n, r2, j);
+}
+
+/*  sift_nn:   put (r2,j) at position p of the first n entries of the heap,
+ *             and sift it down
+ */
+local void sift_nn(knnlist *nl, int p, int n, real r2, int j)
+{
+    int c;
+
+    while ((c = 2*p+1) < n) {
+        if (c+1 < n && FARTHER(nl->r[c+1],nl->idx[c+1],nl->r[c],nl->idx[c]))
+            c++;
+        if (!FARTHER(nl->r[c],nl->idx[c],r2,j))
+            break;
+        nl->r[p] = nl->r[c];
+        nl->idx[p] = nl->idx[c];
+        p = c;
+    }
+    nl->r[p] = r2;
+    nl->idx[p] = j;
+}
+
+/*  sort_nn:   heapsort the NN list in increasing distance
+ */
+local void sort_nn(knnlist *nl)
+{
+    int n, j;
+    real r2;
+
+    for (n=nl->n-1; n>0; n--) {
+        r2 = nl->r[n];
+        j = nl->idx[n];
+        nl->r[n] = nl->r[0];
+        nl->idx[n] = nl->idx[0];
+        sift_nn(nl, 0, n, r2, j);
+    }
+}
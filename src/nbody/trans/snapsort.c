@@ -10,6 +10,7 @@
  *     1-nov-07       a  bug when Aux is present                    pjt
  *    29-feb-08          fix a memory leak on btab                  jcl
  *    19-Jun-09          fix a bug when Aux is present              jcl
+ *    19-oct-26   V1.6   sort=radix: parallel LSD radix sort of (key,index)  pjt
  */
 
 #include <stdinc.h>
@@ -22,14 +23,17 @@
 #include <snapshot/get_snap.c>
 #include <snapshot/put_snap.c>
 #include <bodytransc.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 string defv[] = {	
     "in=???\n		Input file name (snapshot)",
     "out=???\n		Output file name (snapshot)",
     "rank=etot\n	Value used in ranking particles",
     "times=all\n        Range of times to process ",
-    "sort=qsort\n       Sort mode {qsort;...}",
-    "VERSION=1.5c\n     19-jun-09 PJT ",
+    "sort=qsort\n       Sort mode {qsort;radix;...}",
+    "VERSION=1.6\n      19-oct-26 PJT ",
     NULL,
 };
 
@@ -40,6 +44,8 @@ string cvsid="$Id$";
 /* #define FLOGGER 1       /* merge in the cute flogger test routines */
 
 void snapsort(Body *, int , real , bool, bool, rproc_body, iproc);
+void snaprsort(Body **, int , real , bool, rproc_body);
+local void radix_sort(int, unsigned long long *, int *);
 
 nemo_main()
 {
@@ -64,9 +70,12 @@ nemo_main()
         get_history(instr);  /*  get history that is not written */
 	get_snap_by_t(instr, &btab, &nbody, &tsnap, &bits, times);
 	if (bits & PhaseSpaceBit) {
-	  snapsort(btab, nbody, tsnap, bits&AuxBit, bits&KeyBit, rank, mysort);
-	    bits |= KeyBit;
-	    put_snap(outstr, &btab, &nbody, &tsnap, &bits);
+	  if (mysort)
+	    snapsort(btab, nbody, tsnap, bits&AuxBit, bits&KeyBit, rank, mysort);
+	  else
+	    snaprsort(&btab, nbody, tsnap, bits&KeyBit, rank);
+	  bits |= KeyBit;
+	  put_snap(outstr, &btab, &nbody, &tsnap, &bits);
 	}
 	if (btab) free((Body *) btab);
 	btab=NULL;	/* 'free' the snapshot */
@@ -117,6 +126,123 @@ void snapsort(
     }
 }
 
+/*
+ *  SNAPRSORT: sort by a radix sort on (key,index) pairs, and gather the
+ *	       bodies in their new order into a new table.  Since Aux is
+ *	       never touched, it needs no backup.  Bodies of equal rank
+ *	       stay in their input order.
+ */
+
+void snaprsort(
+	 Body **btab,
+	 int nbody,
+	 real tsnap,
+	 bool Qkey,
+	 rproc_body rank)
+{
+    int i, *idx;
+    unsigned long long *key;
+    Body *b, *bnew;
+    double r;
+
+    key = (unsigned long long *) allocate(nbody*sizeof(unsigned long long));
+    idx = (int *) allocate(nbody*sizeof(int));
+    b = *btab;
+#pragma omp parallel for private(r)
+    for (i = 0; i < nbody; i++) {
+	if (!Qkey)
+	    Key(b+i) = i;
+	r = (rank)(b+i, tsnap, i);		/* double, also if SINGLEPREC */
+	memcpy(&key[i], &r, sizeof(double));	/* IEEE bits as unsigned:   */
+	key[i] ^= (key[i] >> 63) ? ~0ULL : (1ULL << 63);  /* flip negatives */
+	idx[i] = i;
+    }
+    radix_sort(nbody, key, idx);
+    bnew = (Body *) allocate(nbody*sizeof(Body));
+#pragma omp parallel for
+    for (i = 0; i < nbody; i++)
+	bnew[i] = b[idx[i]];
+    free(b);
+    *btab = bnew;
+    free(idx);
+    free(key);
+}
+
+/*
+ *  RADIX_SORT: stable LSD radix sort of keys, carrying idx along, one byte
+ *		per pass.  Each thread counts and scatters its own slice of
+ *		the array; a pass where all keys share the byte is skipped.
+ */
+
+#define NBUCKET 256
+
+local void radix_sort(int n, unsigned long long *key, int *idx)
+{
+    unsigned long long *kin = key, *kout, *ktmp;
+    int *iin = idx, *iout, *itmp, *count, pass, nthread = 1;
+    bool skip;
+
+    kout = (unsigned long long *) allocate(n*sizeof(unsigned long long));
+    iout = (int *) allocate(n*sizeof(int));
+#if defined(_OPENMP)
+    nthread = omp_get_max_threads();
+#endif
+    count = (int *) allocate(nthread*NBUCKET*sizeof(int));
+
+    for (pass = 0; pass < 8; pass++) {
+#pragma omp parallel num_threads(nthread)
+      {
+	int i, d, t = 0, nt = 1, lo, hi, off, c, shift = 8*pass;
+	int *cnt;
+
+#if defined(_OPENMP)
+	t = omp_get_thread_num();
+	nt = omp_get_num_threads();
+#endif
+	lo = (int) ((long) n * t / nt);
+	hi = (int) ((long) n * (t+1) / nt);
+	cnt = count + t*NBUCKET;
+	for (d = 0; d < NBUCKET; d++)
+	    cnt[d] = 0;
+	for (i = lo; i < hi; i++)
+	    cnt[(kin[i] >> shift) & 0xff]++;
+#pragma omp barrier
+#pragma omp single
+	{
+	    skip = FALSE;
+	    for (d = 0, off = 0; d < NBUCKET; d++) {  /* offsets by byte, thread */
+		for (i = 0, c = off; i < nt; i++) {
+		    c += count[i*NBUCKET + d];
+		    count[i*NBUCKET + d] = c - count[i*NBUCKET + d];
+		}
+		if (c - off == n)
+		    skip = TRUE;
+		off = c;
+	    }
+	}
+	if (!skip)
+	    for (i = lo; i < hi; i++) {
+		d = cnt[(kin[i] >> shift) & 0xff]++;
+		kout[d] = kin[i];
+		iout[d] = iin[i];
+	    }
+      }
+	dprintf(2,"radix_sort: pass %d %s\n", pass, skip ? "skipped" : "");
+	if (skip)
+	    continue;
+	ktmp = kin;  kin = kout;  kout = ktmp;
+	itmp = iin;  iin = iout;  iout = itmp;
+    }
+    if (iin != idx) {			/* result ended up in the scratch arrays */
+	memcpy(key, kin, n*sizeof(unsigned long long));
+	memcpy(idx, iin, n*sizeof(int));
+	kout = kin;
+	iout = iin;
+    }
+    free(kout);
+    free(iout);
+    free(count);
+}
 
 
 /*
@@ -159,6 +285,7 @@ local sortmode smode[] = {
     "shell",    shell_sort,
 #endif
     "qsort",    (iproc) qsort,      /* standard Unix qsort() */
+    "radix",    NULL,               /* parallel radix sort, snaprsort() */
     NULL, NULL,
 };
 
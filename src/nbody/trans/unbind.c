@@ -19,12 +19,15 @@
  *	22-dec-92	V2.4 again write out 0 length snapshots	PJT
  *      28-dec-92       V2.4a - fixed cases where Mass output negative  PJT/SF
  *	15-aug-96       V2.5 code cleaned (old version crashed on linux)  PJT
+ *      19-oct-26       V3.0 tree potentials, iter=, parallel exact=t     PJT
+ *                      V3.1 iter= keeps snapshot potentials (external)   PJT
  */
 
 #include <stdinc.h>
 #include <getparam.h>
 #include <vectmath.h>
 #include <filestruct.h>
+#include <treepot.h>
 
 #include <snapshot/snapshot.h>
 #include <snapshot/body.h>
@@ -35,12 +38,14 @@ string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "in=???\n           Input file name",
     "out=???\n          Output file name",
     "exact=f\n          Exact N-squared potential ?",
-    "eps=0.025\n        Softening length in case exact potentials",
+    "eps=0.025\n        Softening length in case potentials are computed",
+    "tol=0.7\n          Tree opening angle if not exact potentials",
+    "iter=1\n           Max number of unbinding passes (0=until converged)",
     "ecutoff=0.0\n      Cutoff for (un)binding",
     "bind=t\n           Output bound(t) or unbound(f) stars",
     "map=f\n            Print map of bound/unbound",
     "times=all\n        Times of shapshots to copy",
-    "VERSION=2.5\n      15-aug-96 PJT",
+    "VERSION=3.1\n      19-oct-26 PJT",
     NULL,
 };
 
@@ -58,21 +63,29 @@ local int    bits;                    /* bitmap of output quantities */
 local double  ecutoff;                /* cutoff energy */
 local int     nesc;                   /* counter how many flagged as escaped */
 
-local double sqreps;                  /* square of softening length */
+local double eps;                     /* softening length */
+local double tol;                     /* tree opening angle */
+local int    niter;                   /* max number of passes, 0=no limit */
 local bool   Qexact;                  /* exact potential ? */
 local bool   Qbind;                   /* true=keep bound   false=keep escapers */
 local bool   Qmap;                    /* true=make map of bound/unnound */
+local bool   Qphi;                    /* potentials taken from snapshot ? */
+local int    *esc = NULL;             /* pass in which a star escaped, or 0 */
+
+local double kinetic(Body *);
+local void   potential(int);
 
 
 nemo_main()
 {
-    int  i;
-    double ekin;
+    int  nnew, npass;
     Body  *bp;
 
     instr = stropen(getparam("in"), "r");       /* get parameters */
     outstr = stropen(getparam("out"),"w");
-    sqreps = sqr(getdparam("eps"));
+    eps = getdparam("eps");
+    tol = getdparam("tol");
+    niter = getiparam("iter");
     ecutoff = getdparam("ecutoff");
     Qexact = getbparam("exact");
     Qbind = getbparam("bind");
@@ -85,17 +98,25 @@ nemo_main()
 
     while (read_snap()) {             /* read snapshot */
         nesc = 0;
-        for (bp=btab; bp<btab+nbody; bp++) {
-                ekin = 0;
-                for (i=0; i<NDIM; i++)
-                        ekin += sqr(Vel(bp)[i]);
-                ekin *= 0.5;
-                Phi(bp) += ekin;
-                if (Phi(bp) >= ecutoff) {
+        for (npass=1; ; npass++) {
+            nnew = 0;
+            for (bp=btab; bp<btab+nbody; bp++) {
+                if (esc[bp-btab])
+                        continue;               /* escaped in earlier pass */
+                if (Phi(bp) + kinetic(bp) >= ecutoff) {
                         Mass(bp) *= -1;         /* flag as escaper */
-                        nesc++;
-                } 
+                        esc[bp-btab] = npass;
+                        nnew++;
+                }
+            }
+            nesc += nnew;
+            dprintf (1,"Pass %d: %d stars escaped\n",npass,nnew);
+            if (nnew == 0 || npass == niter || nesc == nbody)
+                break;
+            potential(npass);   /* of the stars still bound */
         }
+        for (bp=btab; bp<btab+nbody; bp++)
+                Phi(bp) += kinetic(bp);         /* binding energy */
         if (Qbind)
             dprintf (0,"%d out of %d stars bound and written to file\n",
                             nbody-nesc,nbody);
@@ -109,7 +130,17 @@ nemo_main()
     strclose(instr);
 }
 
-
+local double kinetic(Body *bp)
+{
+    int i;
+    double ekin = 0;
+
+    for (i=0; i<NDIM; i++)
+        ekin += sqr(Vel(bp)[i]);
+    return 0.5*ekin;
+}
+
+
 read_snap()
 {                               
     int    i;
@@ -122,13 +153,20 @@ read_snap()
         get_snap(instr, &btab, &nbody, &stime, &bits);
         if ((bits & MassBit) == 0 || (bits & PhaseSpaceBit) == 0)
                 error("missing essential data");
+        esc = (int *) reallocate(esc, nbody*sizeof(int));
+        for (i=0; i<nbody; i++)
+            esc[i] = 0;
+        Qphi = FALSE;
         if (Qexact) {
             dprintf (0,"Doing an exact potential calculation\n");
-            exact();            /* fill in newtonian potentials */
-        } else if ((bits & PotentialBit)==0)            
-            error("missing potentials in snapshot, use hackforce or exact=t");
-        else
+            potential(0);       /* fill in newtonian potentials */
+        } else if ((bits & PotentialBit)==0) {
+            dprintf (0,"Doing a tree potential calculation\n");
+            potential(0);
+        } else {
            dprintf (1,"Using potentials in snapshot for energy calculation\n");
+           Qphi = TRUE;
+        }
         if ((bits & KeyBit) == 0) {
             warning ("Keys (re)set according to their order in file");
             for (i=0, b=btab; i<nbody; i++, b++)
@@ -191,25 +229,46 @@ map()
 }
 
 /*
- * newton_potential exact 
+ * potential: newtonian potentials of the stars not (yet) flagged as
+ *            escaper, exact or with a tree; escapers keep theirs.
+ *            Potentials from the snapshot may include an external
+ *            field, so they are kept and only the potential of the
+ *            stars that escaped in pass npass is taken out.
  */
  
-exact()
+local void potential(int npass)
 {
-    Body *bi, *bj;
-    int i,j,k;
-    real rij;
-    
-    for (bi=btab; bi<btab+nbody; bi++)
-        Phi(bi) = 0.0;
-    for (i=1, bi=btab+1; i<nbody; i++, bi++) {
-        for (j=0, bj=btab; j<i; bj++, j++) {
-            rij = 0.0;
-            for (k=0; k<NDIM; k++)
-                rij += sqr(Pos(bi)[k] - Pos(bj)[k]);
-            rij = 1.0/sqrt(sqreps + rij);
-            Phi(bi) -= Mass(bj)*rij;            /* G==1 */
-            Phi(bj) -= Mass(bi)*rij;            /* G==1 */
+    Body *bp;
+    int  i, k, n;
+    real *pos, *mass, *phi;
+
+    pos  = (real *) allocate(nbody*NDIM*sizeof(real));
+    mass = (real *) allocate(nbody*sizeof(real));
+    phi  = (real *) allocate(nbody*sizeof(real));
+    for (bp=btab, n=0; bp<btab+nbody; bp++) {
+        if (Qphi) {             /* new escapers, and the rest massless */
+            if (esc[bp-btab] && esc[bp-btab] != npass) continue;
+        } else if (esc[bp-btab])
+            continue;
+        for (k=0; k<NDIM; k++)
+            pos[n*NDIM+k] = Pos(bp)[k];
+        mass[n++] = esc[bp-btab] ? -Mass(bp) : (Qphi ? 0.0 : Mass(bp));
+    }
+    if (Qexact)
+        exactpot(n, pos, NDIM, mass, eps, phi, NULL);
+    else
+        treepot(n, pos, NDIM, mass, eps, tol, phi, NULL);
+    for (bp=btab, i=0; bp<btab+nbody; bp++) {
+        if (Qphi && esc[bp-btab] == npass)
+            i++;                /* an escaper, keeps its potential */
+        else if (!esc[bp-btab]) {
+            if (Qphi)
+                Phi(bp) -= phi[i++];
+            else
+                Phi(bp) = phi[i++];
         }
     }
+    free(phi);
+    free(mass);
+    free(pos);
 }
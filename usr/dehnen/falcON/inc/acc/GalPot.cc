@@ -36,6 +36,7 @@
 // Version 0.8    24. June      2005  explicit construction of tupel           |
 // Version 0.9    06. November  2007  consistent with GalPot package           |
 // Version 0.10   16. November  2010  fixed memory leak (thanks to PJM)        |
+// Version 0.11   19. October   2026  Psplev2D() thread safe                   |
 //-----------------------------------------------------------------------------+
 #define  GalPot_cc
 #ifndef GalPot_h
@@ -482,7 +483,10 @@ namespace GalPot {                                  // v0.4
 	     T*  d1=0,	      // output:  gradient of y   if d1 != 0
 	     T** d2=0)	      // output:  d^2y/dxi/dxj    if d2 != 0
   {
-    static int l0=0, l1=0;
+    static int l0=0, l1=0;            // hints for find(), one set per thread
+#ifdef _OPENMP
+#   pragma omp threadprivate(l0,l1)
+#endif
     find(l0,n[0],x[0],xi[0]);
     find(l1,n[1],x[1],xi[1]);
     register int k0=l0+1, k1=l1+1;
@@ -1597,6 +1597,7 @@ namespace falcON {
     mutable double   TIME;
     void            *PBNK;
     ParallelSnapshot*PARA;                         // parent if MPI parallel    
+    friend class ParallelSnapshot;
     //--------------------------------------------------------------------------
   protected:
     void set_parallel(ParallelSnapshot*P) { PARA = P; }
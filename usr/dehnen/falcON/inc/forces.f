@@ -195,6 +195,16 @@ C                                                                              |
 C  it is possible to change, after initialisation, the softening length and    |
 C  kernel as well as the opening criterion.                                    |
 C                                                                              |
+C  The arrays given to FALCON_INITIALIZE are not copied, but read and written  |
+C  in place at every call; they must remain valid. If your code moves them     |
+C  but keeps the number of bodies, re-register them with                       |
+C                                                                              |
+      EXTERNAL FALCON_RESET_ARRAYS       !  re-register arrays, keep tree      |
+C     syntax:                                                                  |
+C     CALL FALCON_RESET_ARRAYS(FL,M,X,EP,A,P,RH)                               |
+C                                                                              |
+C  which, unlike another FALCON_INITIALIZE, keeps the tree and all settings.   |
+C                                                                              |
 C                                                                              |
 C                                                                              |
 C  1.2 AFTER USING THE CODE                                                    |
@@ -286,6 +296,18 @@ C                                                                              |
 C  after a call to FALCON_GROW, FALCON_GROW_CENTERED, or FALCON_REUSE.         |
 C  See file src/FORTRAN/TestGravF.f for an example application.                |
 C                                                                              |
+C  For many force computations, you may instead use the single call            |
+C                                                                              |
+      INTEGER  FALCON_GRAVITY            !  grow or reuse, then approx_grav    |
+      EXTERNAL FALCON_GRAVITY            !                                     |
+C     syntax:                                                                  |
+C     INTEGER NCRIT,NREUSE,GROWN                                               |
+C     GROWN = FALCON_GRAVITY(NCRIT,NREUSE)                                     |
+C                                                                              |
+C  which grows the tree at the first call and after every NREUSE calls that    |
+C  merely re-used it (NREUSE<=0: grow always), and re-uses it otherwise.       |
+C  GROWN is 1 if the tree was grown, 0 if re-used.                             |
+C                                                                              |
 C                                                                              |
 C  IMPORTANT NOTICE                                                            |
 C                                                                              |
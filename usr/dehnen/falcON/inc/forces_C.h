@@ -148,6 +148,24 @@ INPUT_TYPE falcON_default_theta();           /* return default value for THETA*/
  */
 int falcON_default_kernel();                 /* return default value for THETA*/
 /*
+ *                                                                             *
+ * The arrays given to falcON_initialize() are not copied: falcON reads and    *
+ * writes them in place at every call. They must therefore remain valid, and   *
+ * each must be contiguous (position and acceleration with stride 3, all      *
+ * others with stride 1). If your code moves its arrays (re-allocation,        *
+ * double buffering) but the number of bodies is unchanged, use                *
+ */
+void falcON_reset_arrays(const int       *,      /* flags                    */
+			 const INPUT_TYPE*,      /* masses                   */
+			 const INPUT_TYPE*,      /* positions                */
+			 const INPUT_TYPE*,      /* eps                      */
+			 INPUT_TYPE      *,      /* accelerations            */
+			 INPUT_TYPE      *,      /* potentials               */
+			 INPUT_TYPE      *);     /* densities                */
+/*
+ * which merely re-registers the arrays, but, unlike another call to           *
+ * falcON_initialize(), keeps the tree and all settings, such that the tree    *
+ * may still be re-used.                                                       *
  *                                                                             *
  * 1.2 AFTER USING THE CODE                                                    *
  * ------------------------                                                    *
@@ -234,6 +252,21 @@ void falcON_approx_grav();
  * falcON_approx_grav() implements the pre-computation of the quadrupoles, as  *
  * well as the interaction and evaluation phase. See src/exe/C/TestGravC.c     *
  * for an example application.                                                 *
+ *                                                                             *
+ * Only bodies flagged active receive accelerations and potentials. The flags  *
+ * (and masses) are read afresh after each falcON_grow() or falcON_reuse(),    *
+ * so the active subset may change from one re-use of the tree to the next.    *
+ *                                                                             *
+ * For codes that need forces many times, the routine                         *
+ */
+int falcON_gravity(                          /* R: 1 if tree was grown, else 0*/
+		   int,                      /* I: Ncrit, as for falcON_grow()*/
+		   int);                     /* I: Nreuse: max # re-uses      */
+/*
+ * combines tree growth or re-use with falcON_approx_grav() into one call:     *
+ * the tree is grown afresh at the first call and after every Nreuse calls     *
+ * that merely re-used it (Nreuse<=0: grow at every call), otherwise it is     *
+ * re-used (see above for the caveats). Nothing is copied between calls.       *
  */
 #ifdef falcON_ADAP
 /* For individual adaptive softening the routine                               *
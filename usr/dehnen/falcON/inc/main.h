@@ -146,7 +146,7 @@ namespace falcON { namespace compile_info {
   char __compiler[30]; const char*compiler() { return __compiler; }
   void init() {
     if(! __set ) {
-      SNprintf(__compiler,10,
+      SNprintf(__compiler,30,
 #if   defined (__INTEL_COMPILER)
 	       "icc-%d",__INTEL_COMPILER
 #elif defined (__GNUC__)
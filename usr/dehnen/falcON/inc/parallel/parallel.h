@@ -0,0 +1,287 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file    inc/parallel/parallel.h
+///
+/// \brief   basic MPI support: start & finish, communicators, collectives
+///
+/// \author  agent
+///
+/// \date    2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// \version 19/10/2026 agent created
+//
+////////////////////////////////////////////////////////////////////////////////
+#ifndef falcON_included_parallel_h
+#define falcON_included_parallel_h
+
+#ifndef falcON_MPI
+#  error "parallel/parallel.h requires falcON_MPI to be #defined"
+#endif
+
+#ifndef falcON_included_mpi_h
+#  define OMPI_SKIP_MPICXX                         // we don't want the C++
+#  define MPICH_SKIP_MPICXX                        // bindings (namespace MPI)
+#  include <mpi.h>
+#  define falcON_included_mpi_h
+#endif
+#ifndef falcON_included_basic_h
+#  include <public/basic.h>
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace falcON {
+  /// MPI support for falcON: wraps those parts of MPI we need
+  namespace MPI {
+    //--------------------------------------------------------------------------
+    /// \name starting and finishing MPI
+    //@{
+    /// start MPI; called from main() if falcON_USE_MPI is #defined
+    void   Init(int argc, const char**argv) falcON_THROWING;
+    /// finish MPI; called at the end of main() if falcON_USE_MPI is #defined
+    void   Finish();
+    /// has MPI been started (and not yet finished)?
+    bool   Initialized();
+    /// wall-clock time in seconds since MPI has been started
+    double WallClock();
+    //@}
+    //--------------------------------------------------------------------------
+    /// \name reduction operations: template arguments for Reduce() etc.
+    //@{
+    struct Sum { static MPI_Op op() { return MPI_SUM;  } }; ///< sum
+    struct Max { static MPI_Op op() { return MPI_MAX;  } }; ///< maximum
+    struct Min { static MPI_Op op() { return MPI_MIN;  } }; ///< minimum
+    struct And { static MPI_Op op() { return MPI_LAND; } }; ///< logical and
+    struct Or  { static MPI_Op op() { return MPI_LOR;  } }; ///< logical or
+    struct BOr { static MPI_Op op() { return MPI_BOR;  } }; ///< bit-wise or
+    //@}
+    //--------------------------------------------------------------------------
+    /// MPI_Datatype for a C++ type
+    template<typename T> struct Type;
+#define falcON_MPI_TYPE(TYPE,MPITYPE)					\
+    template<> struct Type<TYPE> {					\
+      static MPI_Datatype type() { return MPITYPE; }			\
+    };
+    falcON_MPI_TYPE(char,              MPI_CHAR)
+    falcON_MPI_TYPE(bool,              MPI_CXX_BOOL)
+    falcON_MPI_TYPE(int,               MPI_INT)
+    falcON_MPI_TYPE(unsigned,          MPI_UNSIGNED)
+    falcON_MPI_TYPE(long,              MPI_LONG)
+    falcON_MPI_TYPE(unsigned long,     MPI_UNSIGNED_LONG)
+    falcON_MPI_TYPE(long long,         MPI_LONG_LONG)
+    falcON_MPI_TYPE(unsigned long long,MPI_UNSIGNED_LONG_LONG)
+    falcON_MPI_TYPE(float,             MPI_FLOAT)
+    falcON_MPI_TYPE(double,            MPI_DOUBLE)
+#undef falcON_MPI_TYPE
+    //--------------------------------------------------------------------------
+    /// throw a falcON exception if an MPI call failed
+    inline void check(int e, const char*func) falcON_THROWING {
+      if(e != MPI_SUCCESS)
+	falcON_THROW("MPI: %s() failed with error code %d\n",func,e);
+    }
+    // /////////////////////////////////////////////////////////////////////////
+    //
+    // class falcON::MPI::Communicator
+    //
+    /// a group of processes which communicate.
+    ///
+    /// All communications are collective: they must be called by all members
+    /// of the group, in the same order. The methods are const, since they do
+    /// not change the group; use macro COMMUN() to use them via a pointer to
+    /// const, as in COMMUN(Comm)->AllReduceInPlace<MPI::Sum>(x).
+    //
+    // /////////////////////////////////////////////////////////////////////////
+    class Communicator {
+      MPI_Comm COMM;                               ///< MPI communicator
+      int      RANK;                               ///< our rank in COMM
+      int      SIZE;                               ///< # processes in COMM
+      /// contiguous MPI_Datatype of \a s bytes (to be freed after use)
+      static MPI_Datatype record(size_t s) falcON_THROWING {
+	MPI_Datatype R;
+	check(MPI_Type_contiguous(int(s),MPI_BYTE,&R),"MPI_Type_contiguous");
+	check(MPI_Type_commit(&R),"MPI_Type_commit");
+	return R;
+      }
+    public:
+      /// construction from MPI communicator (MPI must have been started)
+      explicit Communicator(MPI_Comm C) falcON_THROWING : COMM(C) {
+	check(MPI_Comm_rank(COMM,&RANK),"MPI_Comm_rank");
+	check(MPI_Comm_size(COMM,&SIZE),"MPI_Comm_size");
+      }
+      /// \name information
+      //@{
+      MPI_Comm const&comm() const { return COMM; } ///< MPI communicator
+      int const&rank() const { return RANK; }      ///< our rank: 0...size-1
+      int const&size() const { return SIZE; }      ///< # processes
+      bool is_master() const { return RANK==0; }   ///< are we rank 0?
+      //@}
+      /// \name collective communications
+      //@{
+      /// wait for all processes
+      void Barrier() const falcON_THROWING {
+	check(MPI_Barrier(COMM),"MPI_Barrier");
+      }
+      /// broadcast \a n objects from process \a root
+      template<typename T>
+      void BroadCast(int root, T*x, int n) const falcON_THROWING {
+	check(MPI_Bcast(x,n,Type<T>::type(),root,COMM),"MPI_Bcast");
+      }
+      /// broadcast object from process \a root
+      template<typename T>
+      void BroadCast(int root, T&x) const falcON_THROWING {
+	BroadCast(root,&x,1);
+      }
+      /// reduce \a n objects to process \a root
+      template<typename Op, typename T>
+      void Reduce(int root, const T*in, T*out, int n) const falcON_THROWING {
+	check(MPI_Reduce(const_cast<T*>(in),out,n,Type<T>::type(),Op::op(),
+			 root,COMM),"MPI_Reduce");
+      }
+      /// reduce object to process \a root
+      template<typename Op, typename T>
+      void Reduce(int root, T const&in, T&out) const falcON_THROWING {
+	Reduce<Op>(root,&in,&out,1);
+      }
+      /// reduce \a n objects to process \a root, overriding them there
+      template<typename Op, typename T>
+      void ReduceInPlace(int root, T*x, int n) const falcON_THROWING {
+	if(RANK == root)
+	  check(MPI_Reduce(MPI_IN_PLACE,x,n,Type<T>::type(),Op::op(),
+			   root,COMM),"MPI_Reduce");
+	else
+	  check(MPI_Reduce(x,0,n,Type<T>::type(),Op::op(),
+			   root,COMM),"MPI_Reduce");
+      }
+      /// reduce object to process \a root, overriding it there
+      template<typename Op, typename T>
+      void ReduceInPlace(int root, T&x) const falcON_THROWING {
+	ReduceInPlace<Op>(root,&x,1);
+      }
+      /// reduce \a n objects to all processes
+      template<typename Op, typename T>
+      void AllReduce(const T*in, T*out, int n) const falcON_THROWING {
+	check(MPI_Allreduce(const_cast<T*>(in),out,n,Type<T>::type(),Op::op(),
+			    COMM),"MPI_Allreduce");
+      }
+      /// reduce object to all processes
+      template<typename Op, typename T>
+      void AllReduce(T const&in, T&out) const falcON_THROWING {
+	AllReduce<Op>(&in,&out,1);
+      }
+      /// reduce \a n objects to all processes, overriding them
+      template<typename Op, typename T>
+      void AllReduceInPlace(T*x, int n) const falcON_THROWING {
+	check(MPI_Allreduce(MPI_IN_PLACE,x,n,Type<T>::type(),Op::op(),COMM),
+	      "MPI_Allreduce");
+      }
+      /// reduce object to all processes, overriding it
+      template<typename Op, typename T>
+      void AllReduceInPlace(T&x) const falcON_THROWING {
+	AllReduceInPlace<Op>(&x,1);
+      }
+      /// exclusive prefix reduction of \a n objects: process r obtains the
+      /// reduction over processes 0...r-1 (and process 0 obtains \a x)
+      template<typename Op, typename T>
+      void ExScan(const T*x, T*y, int n) const falcON_THROWING {
+	check(MPI_Exscan(const_cast<T*>(x),y,n,Type<T>::type(),Op::op(),COMM),
+	      "MPI_Exscan");
+	if(RANK == 0)
+	  for(int i=0; i!=n; ++i) y[i] = x[i];
+      }
+      /// gather \a n objects from each process into \a all[size*n] everywhere
+      template<typename T>
+      void AllGather(const T*x, T*all, int n) const falcON_THROWING {
+	check(MPI_Allgather(const_cast<T*>(x),n,Type<T>::type(),
+			    all,n,Type<T>::type(),COMM),"MPI_Allgather");
+      }
+      /// gather an object from each process into \a all[size] everywhere
+      template<typename T>
+      void AllGather(T const&x, T*all) const falcON_THROWING {
+	AllGather(&x,all,1);
+      }
+      /// gather \a n[r] objects from each process r into \a all everywhere,
+      /// those from process r starting at \a all[off[r]]
+      template<typename T>
+      void AllGatherV(const T*x, int nx, T*all, const int*n, const int*off)
+	const falcON_THROWING {
+	check(MPI_Allgatherv(const_cast<T*>(x),nx,Type<T>::type(),
+			     all,const_cast<int*>(n),const_cast<int*>(off),
+			     Type<T>::type(),COMM),"MPI_Allgatherv");
+      }
+      /// gather \a n[r] objects from each process r into \a all at \a root,
+      /// those from process r starting at \a all[off[r]]
+      /// \note \a all, \a n, and \a off are only used at \a root
+      template<typename T>
+      void GatherV(int root, const T*x, int nx, T*all, const int*n,
+		   const int*off) const falcON_THROWING {
+	check(MPI_Gatherv(const_cast<T*>(x),nx,Type<T>::type(),
+			  all,const_cast<int*>(n),const_cast<int*>(off),
+			  Type<T>::type(),root,COMM),"MPI_Gatherv");
+      }
+      /// send x[r] to process r and receive y[r] from process r
+      template<typename T>
+      void AllToAll(const T*x, T*y) const falcON_THROWING {
+	check(MPI_Alltoall(const_cast<T*>(x),1,Type<T>::type(),
+			   y,1,Type<T>::type(),COMM),"MPI_Alltoall");
+      }
+      /// send \a nx[r] objects starting at x[ox[r]] to process r and receive
+      /// \a ny[r] objects from process r into y[oy[r]]
+      template<typename T>
+      void AllToAllV(const T*x, const int*nx, const int*ox,
+		     T*y, const int*ny, const int*oy) const falcON_THROWING {
+	check(MPI_Alltoallv(const_cast<T*>(x),const_cast<int*>(nx),
+			    const_cast<int*>(ox),Type<T>::type(),
+			    y,const_cast<int*>(ny),const_cast<int*>(oy),
+			    Type<T>::type(),COMM),"MPI_Alltoallv");
+      }
+      /// like AllToAllV(), but for records of \a s bytes each; counts and
+      /// offsets are in units of records, which allows for more than 2GB
+      void AllToAllV(const void*x, const int*nx, const int*ox,
+		     void*y, const int*ny, const int*oy, size_t s) const
+	falcON_THROWING {
+	MPI_Datatype R = record(s);
+	check(MPI_Alltoallv(const_cast<void*>(x),const_cast<int*>(nx),
+			    const_cast<int*>(ox),R,
+			    y,const_cast<int*>(ny),const_cast<int*>(oy),R,
+			    COMM),"MPI_Alltoallv");
+	MPI_Type_free(&R);
+      }
+      /// like GatherV(), but for records of \a s bytes each
+      void GatherV(int root, const void*x, int nx, void*all, const int*n,
+		   const int*off, size_t s) const falcON_THROWING {
+	MPI_Datatype R = record(s);
+	check(MPI_Gatherv(const_cast<void*>(x),nx,R,
+			  all,const_cast<int*>(n),const_cast<int*>(off),R,
+			  root,COMM),"MPI_Gatherv");
+	MPI_Type_free(&R);
+      }
+      //@}
+    };// class falcON::MPI::Communicator
+    //--------------------------------------------------------------------------
+    /// all processes started (MPI_COMM_WORLD); NULL unless Initialized()
+    const Communicator*World();
+  } // namespace MPI {
+} // namespace falcON {
+/// access communications via pointer to const Communicator
+#define COMMUN(COMM) const_cast<falcON::MPI::Communicator*>(COMM)
+////////////////////////////////////////////////////////////////////////////////
+#endif // falcON_included_parallel_h
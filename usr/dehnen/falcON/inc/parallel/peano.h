@@ -0,0 +1,71 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file    inc/parallel/peano.h
+///
+/// \brief   Peano-Hilbert curve in three dimensions
+///
+/// \author  agent
+///
+/// \date    2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// \version 19/10/2026 agent created, used by the MPI parallel layer
+//
+////////////////////////////////////////////////////////////////////////////////
+#ifndef falcON_included_peano_h
+#define falcON_included_peano_h
+
+#ifndef falcON_included_basic_h
+#  include <public/basic.h>
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace falcON {
+  // ///////////////////////////////////////////////////////////////////////////
+  //
+  // class falcON::PeanoMap
+  //
+  /// orientation of the Peano-Hilbert curve within a cubic cell (1 byte).
+  ///
+  /// The curve through the eight octants of a cell takes one of 12 shapes.
+  /// key(i) is the position of octant i (bit 0,1,2 set if x,y,z above the
+  /// centre, as in the tree) along the curve through the cell, and
+  /// shift_to_kid(i) turns the map into that of octant i. Applying this down
+  /// the levels of a position gives its Peano-Hilbert key: consecutive keys
+  /// at any level belong to adjacent cells.
+  //
+  // ///////////////////////////////////////////////////////////////////////////
+  class PeanoMap {
+    uint8_t S;                                     // state: 0...11
+    static const uint8_t KEY [12][8];              // key of octant in state
+    static const uint8_t NEXT[12][8];              // state of octant in state
+  public:
+    /// map of the root cell
+    void set_root() { S = 0; }
+    /// Peano-Hilbert key of octant \a i: 0...7
+    int  key(int i) const { return KEY[S][i]; }
+    /// turn into the map of octant \a i
+    void shift_to_kid(int i) { S = NEXT[S][i]; }
+  };
+} // namespace falcON {
+////////////////////////////////////////////////////////////////////////////////
+#endif // falcON_included_peano_h
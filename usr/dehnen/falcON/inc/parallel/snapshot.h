@@ -0,0 +1,167 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file    inc/parallel/snapshot.h
+///
+/// \brief   body data distributed over MPI processes
+///
+/// \author  agent
+///
+/// \date    2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// \version 19/10/2026 agent created: Peano-Hilbert domains, local essential
+//                           trees for gravity, snapshot I/O via rank 0
+//
+////////////////////////////////////////////////////////////////////////////////
+#ifndef falcON_included_parallel_snapshot_h
+#define falcON_included_parallel_snapshot_h
+
+#ifndef falcON_included_parallel_h
+#  include <parallel/parallel.h>
+#endif
+#ifndef falcON_included_body_h
+#  include <body.h>
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace falcON {
+  class nemo_in;
+  class nemo_out;
+  // ///////////////////////////////////////////////////////////////////////////
+  //
+  // class falcON::ParallelSnapshot
+  //
+  /// body data distributed over the processes of a communicator.
+  ///
+  /// Each process holds the bodies of its domain in a local snapshot, which
+  /// is used like a serial one (and knows us via snapshot::parallel()).
+  ///
+  /// Domains are contiguous pieces of the Peano-Hilbert curve through the
+  /// cube containing all bodies, holding about equal numbers of bodies; they
+  /// are found afresh by decompose().
+  ///
+  /// For gravity, import_essential() adds to the local bodies those sources
+  /// from other processes which are needed to compute the forces on the local
+  /// bodies as accurately as with all bodies at hand (the local essential
+  /// tree): bodies near our domain and, for each cell of a remote tree which
+  /// is well separated from our domain, six pseudo-particles with the cell's
+  /// mass, centre of mass, and quadrupole. These must be discarded by
+  /// discard_imports() before the local bodies are used again.
+  ///
+  /// Snapshot I/O is not distributed, but done by rank 0, which reads all
+  /// bodies and distributes them, or collects them and writes them in the
+  /// order of their keys; hence rank 0 must hold all bodies at these times.
+  //
+  // ///////////////////////////////////////////////////////////////////////////
+  class ParallelSnapshot {
+    const MPI::Communicator*COMM;                  ///< our processes
+    snapshot               *LOCAL;                 ///< our bodies
+    unsigned               *NBOD;                  ///< # bodies/block w/o imports
+    unsigned                NIMP;                  ///< # bodies imported
+    //--------------------------------------------------------------------------
+    ParallelSnapshot(ParallelSnapshot const&);     // not implemented
+    ParallelSnapshot&operator=(ParallelSnapshot const&);
+    /// make sure all processes support the same body data
+    void unify_fields() falcON_THROWING;
+    /// copy data fields \a F of body \a b to \a buf; return end of copy
+    static char*pack(body const&b, fieldset F, char*buf);
+    /// copy data fields \a F of body \a b from \a buf; return end of copy
+    static const char*unpack(body const&b, fieldset F, const char*buf);
+    /// add up to \a n bodies of type \a t without creating new ones, i.e.
+    /// not counted as such, in free space of a block or in a new block for
+    /// \a na bodies; on return \a n holds the number actually added
+    body activate(unsigned&n, bodytype t, unsigned na) falcON_THROWING;
+  public:
+    /// construction: empty local snapshot
+    /// \param[in] C  communicator (default: all processes)
+    /// \param[in] Bd body data to support
+    explicit
+    ParallelSnapshot(const MPI::Communicator*C = MPI::World(),
+		     fieldset Bd = fieldset(bodies::DefaultBits))
+      falcON_THROWING;
+    /// destruction
+    ~ParallelSnapshot();
+    /// \name data access
+    //@{
+    /// our communicator
+    const MPI::Communicator*const&Comm() const { return COMM; }
+    /// our local snapshot
+    snapshot*local() const { return LOCAL; }
+    /// total # bodies of given type on all processes
+    unsigned N_global(bodytype t) const;
+    /// total # bodies on all processes
+    unsigned N_global() const;
+    //@}
+    /// \name domain decomposition and local essential tree
+    //@{
+    /// Peano-Hilbert domain decomposition: each process obtains a contiguous
+    /// section of the curve with about the same number of bodies.
+    /// \note collective; changes the local bodies and their order
+    void decompose() falcON_THROWING;
+    /// import the local essential tree for gravity
+    /// \return      # bodies (incl. pseudo-particles) imported
+    /// \param[in] th opening angle: a remote cell of size r at distance d
+    ///               from our domain is imported as pseudo-particles if
+    ///               r < th*d, and otherwise opened
+    /// \param[in] Nc leaf cells of remote trees have at most Nc bodies
+    /// \note collective; imports are bodies of type std, flagged inactive and
+    ///       appended after the local bodies, so that local bodies and their
+    ///       indices remain unchanged
+    unsigned import_essential(real th, unsigned Nc=8) falcON_THROWING;
+    /// remove the bodies added by import_essential()
+    /// \note they are counted in N_del(), as are bodies sent to other
+    ///       processes by decompose()
+    void discard_imports() falcON_THROWING;
+    /// # bodies imported by the last call to import_essential()
+    unsigned const&N_imported() const { return NIMP; }
+    //@}
+#ifdef falcON_NEMO
+    /// \name NEMO snapshot I/O
+    //@{
+    /// read a NEMO snapshot at rank 0 and distribute its bodies.
+    /// Arguments and return value as snapshot::read_nemo(), but \a Is is only
+    /// used at rank 0. If no keys are read, they are set to the running
+    /// index in the input, such that write_nemo() restores its order.
+    /// \note collective
+    bool read_nemo(nemo_in const&Is, fieldset&Read, fieldset Get,
+		   const char*range=0, bool warn=1) falcON_THROWING;
+    /// collect all bodies at rank 0 and write them in the order of their
+    /// keys to a NEMO snapshot; \a Os is only used at rank 0
+    /// \note collective
+    void write_nemo(nemo_out const&Os, fieldset Bd=fieldset::nemo) const
+      falcON_THROWING;
+    //@}
+#endif
+  };// class falcON::ParallelSnapshot
+  //----------------------------------------------------------------------------
+  /// communicator of a ParallelSnapshot
+  inline const MPI::Communicator*Comm(const ParallelSnapshot*P) {
+    return P->Comm();
+  }
+  /// communicator of a parallel snapshot (NULL if serial)
+  inline const MPI::Communicator*Comm(const snapshot*S) {
+    return S->parallel()? S->parallel()->Comm() : 0;
+  }
+} // namespace falcON {
+falcON_TRAITS(falcON::ParallelSnapshot,"ParallelSnapshot");
+////////////////////////////////////////////////////////////////////////////////
+#endif // falcON_included_parallel_snapshot_h
@@ -450,6 +450,13 @@ namespace falcON {
 		 const GravMAC*,                   // I: MAC                    
 		 bool          );                  // I: all or active only?    
     //--------------------------------------------------------------------------
+#ifdef _OPENMP
+    // interaction & evaluation phase of approx() done by several threads       
+    // IACT: GravIact or GravIactAll                                            
+    template<typename IACT>
+    void parallel_iact(bool);                      // I: all are active?        
+    //--------------------------------------------------------------------------
+#endif
     // tree stuff to be superseeded                                             
     //--------------------------------------------------------------------------
   public:
@@ -762,6 +769,15 @@ namespace falcON {
 #undef CELL_B
 #undef LEAF_B
 #undef ADD_SS
+    // 1a merging: add the records of another GravStats, e.g. of one thread   
+    void add(GravStats const&S)
+    {
+      D_BB+=S.D_BB, D_CB+=S.D_CB, D_CC+=S.D_CC, D_CX+=S.D_CX;
+      A_CB+=S.A_CB, A_CC+=S.A_CC;
+#ifdef ENHANCED_IACT_STATS
+      P_CB+=S.P_CB, P_CC+=S.P_CC, P_CX+=S.P_CX;
+#endif
+    }
     // 2 reporting                                                              
     unsigned const&BB_direct_iacts   () const { return D_BB; }
     unsigned const&CB_direct_iacts   () const { return D_CB; }
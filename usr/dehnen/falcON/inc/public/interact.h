@@ -494,6 +494,103 @@ namespace falcON {
     //--------------------------------------------------------------------------
   };// class MutualInteractor<> {
   // ///////////////////////////////////////////////////////////////////////////
+  //
+  // class falcON::MutualTasks<>
+  //
+  /// splits the root self-interaction into coarse tasks, which may be
+  /// resolved by several threads, each with its own MutualInteractor<>.
+  ///
+  /// The tree is cut into a set of coarse nodes by repeatedly splitting the
+  /// most populated cell until there are at least \e N cells. The leaf kids
+  /// of a split cell form one coarse node, a leaf group. The root
+  /// self-interaction is then the sum of the self-interactions of all coarse
+  /// nodes plus the mutual interactions of all pairs of them.
+  ///
+  /// The pairs are arranged in the rounds of a round-robin tournament, such
+  /// that no coarse node occurs twice in any one round. Hence, the tasks of
+  /// one round update disjoint sub-trees and can be done concurrently without
+  /// locking (the interactions are mutual, so both partners are updated),
+  /// while the rounds themselves must be done in sequence.
+  ///
+  /// Nodes with index i < N_cells() are cells, the others are leaf groups.
+  ///
+  /// \version October 2026  created for the parallel GravEstimator::approx()
+  ///
+  // ///////////////////////////////////////////////////////////////////////////
+  template<typename INTERACTOR> class MutualTasks {
+    typedef typename INTERACTOR::cell_iter cell_iter;// iterator over cells
+    //--------------------------------------------------------------------------
+    cell_iter *C;                                    // coarse cells
+    cell_iter *G;                                    // parents of leaf groups
+    unsigned   NC, NG, NN;                           // # cells, groups, players
+    //--------------------------------------------------------------------------
+    MutualTasks           (MutualTasks const&);      // not implemented
+    MutualTasks& operator=(MutualTasks const&);      // not implemented
+    //--------------------------------------------------------------------------
+  public:
+    /// construction: cut the tree into coarse nodes
+    ///
+    /// \param root (input) root cell of the tree
+    /// \param N    (input) desired minimum number of coarse cells
+    MutualTasks(cell_iter const&root,
+		unsigned  const&N) :
+      C  ( falcON_NEW(cell_iter,N+Nsub) ),
+      G  ( falcON_NEW(cell_iter,N) ),
+      NC ( 1 ),
+      NG ( 0 )
+    {
+      C[0] = root;
+      for(unsigned ns=0; NC && NC < N && ns < N; ++ns) {
+	unsigned is=0;                               // find most populated cell
+	for(unsigned i=1; i!=NC; ++i)
+	  if(number(C[i]) > number(C[is])) is = i;
+	cell_iter cs = C[is];                        // split it:
+	C[is] = C[--NC];                             //   remove from cells
+	LoopCellKids(typename cell_iter,cs,c)        //   add its cell kids
+	  C[NC++] = c;
+	if(cs.begin_leafs() != cs.end_leaf_kids())   //   its leaf kids form
+	  G[NG++] = cs;                              //   a new leaf group
+      }
+      NN = NC+NG;
+      if(NN & 1) ++NN;                               // add dummy if odd
+    }
+    //--------------------------------------------------------------------------
+    ~MutualTasks() {
+      falcON_DEL_A(C);
+      falcON_DEL_A(G);
+    }
+    //--------------------------------------------------------------------------
+    /// number of coarse cells
+    unsigned const&N_cells() const { return NC; }
+    /// number of leaf groups
+    unsigned const&N_groups() const { return NG; }
+    /// total number of coarse nodes
+    unsigned N_nodes() const { return NC+NG; }
+    /// coarse cell, \e i < N_cells()
+    cell_iter const&cell(unsigned const&i) const { return C[i]; }
+    /// cell whose leaf kids form leaf group \e i, \e i < N_groups()
+    cell_iter const&group(unsigned const&i) const { return G[i]; }
+    /// number of rounds of pair tasks
+    unsigned N_rounds() const { return NN-1; }
+    /// number of pair tasks per round
+    unsigned N_pairs() const { return NN/2; }
+    /// node indices of the \e k th pair of round \e r (circle method)
+    ///
+    /// \return false if that pair involves the dummy node (no task)
+    /// \param r (input) round, r < N_rounds()
+    /// \param k (input) pair,  k < N_pairs()
+    /// \param i (output) index of first node
+    /// \param j (output) index of second node, j > i
+    bool pair(unsigned const&r, unsigned const&k,
+	      unsigned&i, unsigned&j) const {
+      const unsigned M=NN-1;
+      if(k==0) { i = r;       j = M; }
+      else     { i = (r+k)%M; j = (r+M-k)%M; }
+      if(i > j) { unsigned t=i; i=j; j=t; }
+      return j < NC+NG;
+    }
+  };// class MutualTasks<> {
+  // ///////////////////////////////////////////////////////////////////////////
   //                                                                            
   // class falcON::BasicIactor<ESTIMATOR>                                       
   //                                                                            
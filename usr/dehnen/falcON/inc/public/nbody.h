@@ -378,12 +378,21 @@ namespace falcON {
     /// \param dt  (input) table with time step per level                       
     /// \param all (input) kick all or active bodies only?                      
     void kick_i  (const double*dt, bool all = true) const;
+    /// like \a kick_i(), but only for the \e n bodies listed in \e A
+    /// \param dt  (input) table with time step per level                       
+    /// \param A   (input) list of bodies to kick                               
+    /// \param n   (input) size of list                                         
+    void kick_i  (const double*dt, const bodies::index*A, unsigned n) const;
     /// remember properties to be predicted: in \a rembALL and \a rembSPH.
     /// currently we support the following remembrances:                      \n
     /// <b> w = v  </b>  remember velocity                                    \n
     /// <b> Y = U  </b>  remember SPH internal energy                           
     /// \param all (input) remember for all or active bodies only?              
     void remember(bool all = true) const;
+    /// like \a remember(), but only for the \e n bodies listed in \e A
+    /// \param A   (input) list of bodies to remember for                       
+    /// \param n   (input) size of list                                         
+    void remember(const bodies::index*A, unsigned n) const;
     /// construction: set properties for \a drift(), \a kick(), \a remember().
     /// we will double check that the input is sensible                         
     /// \param solver  pointer to solver for time derivatives                   
@@ -509,11 +518,16 @@ namespace falcON {
     unsigned              *N;                    ///< table: # bodies per level
     int                    W;                    ///< width in stats fields     
     const StepLevels*const ST;                   ///< for adjusing levels       
+    mutable bodies::index *A;                    ///< bodies sorted by level    
+    mutable bodies::index *AT;                   ///< buffer for sorting A      
+    mutable unsigned       NA;                   ///< size of A, AT             
+    mutable unsigned       NF;                   ///< # A[i] flagged active     
     //@}
     //--------------------------------------------------------------------------
   private:
     void assign_levels() const;
-    void adjust_levels(int, bool) const;
+    void sort_levels() const;
+    void adjust_active(int, unsigned) const;
     void update_Nlev(const bodies*);
     void account_del() const;
     void account_new() const;
@@ -536,14 +550,7 @@ namespace falcON {
       if(to) to<<std::endl;
     }
     /// implements Integrator::stats_head
-    void stats_body(output&to) const {
-      SOLVER -> dia_stats_body(to);
-      if(to && highest_level())
-	for(unsigned l=0; l!=Nsteps(); ++l)
-	  to<<std::setw(W)<<N[l]<<' ';
-      cpu_stats_body(to);
-      if(to) to<<std::endl;
-    }
+    void stats_body(output&to) const;
     /// construction
     /// \param[in] kmax  \f$ \tau_{\mathrm{max}}=2^{-\mathrm{kmax}} \f$
     /// \param[in] nlev  number of time step levels
@@ -563,7 +570,9 @@ namespace falcON {
 		   int w) falcON_THROWING;
     /// destruction
     ~BlockStepCode () { 
-      if(N) { falcON_DEL_A(N); N=0; }
+      if(N)  { falcON_DEL_A(N);  N=0; }
+      if(A)  { falcON_DEL_A(A);  A=0; }
+      if(AT) { falcON_DEL_A(AT); AT=0; }
     }
   };// class falcON::BlockStepCode   
 } // namespace falcON {
@@ -933,6 +942,9 @@ namespace falcON {
     mutable double      CPU_TREE, CPU_GRAV, CPU_AEX; ///< CPU timings
     const real          _EPS,_EPSSINK;
     const kern_type     _KERN;
+#ifdef falcON_MPI
+    const real          THETA;             ///< |tolerance parameter|
+#endif
     //@}
     /// build tree and compute forces
     /// \param[in] all   for all bodies (or active only)?
@@ -68,6 +68,24 @@ namespace falcON {
 					 const Neighbour*, int),
 				unsigned&Ni, bool all=0) falcON_THROWING;
   //----------------------------------------------------------------------------
+  /// Like ProcessNearestNeighbours(), but in parallel if compiled with OpenMP.
+  ///
+  /// Each thread has its own neighbour list and search state and processes a
+  /// share of the cells' leaf kids.
+  /// \note The user function is called concurrently from several threads. It
+  ///       must only write data associated with the leaf (or its body) passed.
+  /// \param T tree to use
+  /// \param K number of neighbours to find
+  /// \param f function for processing neighbour list
+  /// \param Ni (output) number of leaf interactions
+  /// \param all (optional) consider all bodies to be active?
+  void ProcessNearestNeighboursParallel(const OctTree*T, int K,
+					void(*f)(const bodies*,
+						 const OctTree::Leaf*,
+						 const Neighbour*, int),
+					unsigned&Ni, bool all=0)
+    falcON_THROWING;
+  //----------------------------------------------------------------------------
   /// Find neighbour list for given body and process it.
   ///
   /// For a given in the tree, we find the K
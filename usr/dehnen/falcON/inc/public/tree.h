@@ -45,6 +45,10 @@
 #  ifndef falcON_included_peano_h
 #    include <proper/peano.h>
 #  endif
+#elif defined(falcON_MPI)
+#  ifndef falcON_included_peano_h
+#    include <parallel/peano.h>
+#  endif
 #else
 namespace falcON {
   typedef uint8_t PeanoMap;
@@ -272,7 +276,7 @@ namespace falcON {
       friend bool     has_leaf_kids (const Cell*);
       friend bool     is_twig       (const Cell*);
       friend bool     is_branch     (const Cell*);
-#ifdef falcON_PROPER
+#if defined(falcON_PROPER) || defined(falcON_MPI)
       friend PeanoMap const&peano   (const Cell*);
       friend uint8_t    const&localkey(const Cell*);
 #endif
@@ -809,7 +813,7 @@ namespace falcON {
   // also serve to inject these functions into namespace falcON               //
   //                                                                          //
   // ///////////////////////////////////////////////////////////////////////////
-#ifdef falcON_PROPER
+#if defined(falcON_PROPER) || defined(falcON_MPI)
   inline PeanoMap const&peano(const OctTree::Cell*C) { return C->PEANO; }
   inline uint8_t const&localkey(const OctTree::Cell*C) { return C->KEY; }
 #endif
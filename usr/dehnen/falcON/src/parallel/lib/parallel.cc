@@ -0,0 +1,97 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file    src/parallel/lib/parallel.cc
+///
+/// \brief   implements inc/parallel/parallel.h and inc/parallel/peano.h
+///
+/// \author  agent
+///
+/// \date    2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// \version 19/10/2026 agent created
+//
+////////////////////////////////////////////////////////////////////////////////
+#include <parallel/parallel.h>
+#include <parallel/peano.h>
+
+using namespace falcON;
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+  double                    T0    = 0.;      // MPI_Wtime() at MPI::Init()
+  const MPI::Communicator  *WORLD = 0;       // all processes
+}
+//------------------------------------------------------------------------------
+void MPI::Init(int argc, const char**argv) falcON_THROWING
+{
+  if(Initialized())
+    falcON_THROW("MPI::Init(): MPI has already been started\n");
+  char**args = const_cast<char**>(argv);
+  check(MPI_Init(&argc,&args),"MPI_Init");
+  T0    = MPI_Wtime();
+  WORLD = new Communicator(MPI_COMM_WORLD);
+  DebugInfo(2,"MPI::Init(): process %d of %d started\n",
+	    WORLD->rank(),WORLD->size());
+}
+//------------------------------------------------------------------------------
+void MPI::Finish()
+{
+  if(!Initialized()) return;
+  if(WORLD) { delete WORLD; WORLD=0; }
+  MPI_Finalize();
+}
+//------------------------------------------------------------------------------
+bool MPI::Initialized()
+{
+  int started, finished;
+  MPI_Initialized(&started);
+  if(!started) return false;
+  MPI_Finalized(&finished);
+  return !finished;
+}
+//------------------------------------------------------------------------------
+double MPI::WallClock()
+{
+  return Initialized()? MPI_Wtime()-T0 : 0.;
+}
+//------------------------------------------------------------------------------
+const MPI::Communicator*MPI::World()
+{
+  return WORLD;
+}
+////////////////////////////////////////////////////////////////////////////////
+//
+// the 12 orientations of the 3D Peano-Hilbert curve: KEY[s][i] is the position
+// along the curve of octant i in a cell of orientation s, NEXT[s][i] the
+// orientation of that octant. Orientation 0 enters at octant 0 (the corner at
+// the lower end of all three axes) and leaves at octant 1.
+//
+const uint8_t PeanoMap::KEY[12][8] = {
+  {0,7,1,6,3,4,2,5}, {0,3,7,4,1,2,6,5}, {0,1,3,2,7,6,4,5}, {6,1,7,0,5,2,4,3},
+  {4,7,3,0,5,6,2,1}, {2,3,1,0,5,4,6,7}, {4,3,5,2,7,0,6,1}, {2,1,5,6,3,0,4,7},
+  {6,7,5,4,1,0,2,3}, {2,5,3,4,1,6,0,7}, {6,5,1,2,7,4,0,3}, {4,5,7,6,3,2,0,1} };
+const uint8_t PeanoMap::NEXT[12][8] = {
+  {1,4,2,8,9,9,2,8}, {2,7,11,7,0,0,3,3}, {0,1,5,1,6,10,5,10}, {11,5,1,4,11,5,6,6},
+  {10,8,10,5,0,0,3,3}, {4,2,4,3,7,2,7,9}, {3,3,2,8,10,7,2,8}, {6,6,9,9,1,8,1,5},
+  {4,0,4,11,7,6,7,11}, {11,5,0,0,11,5,10,7}, {6,6,9,9,2,4,11,4}, {8,1,3,1,8,10,9,10} };
+//---------------------end-of-parallel.cc--------------------------------------
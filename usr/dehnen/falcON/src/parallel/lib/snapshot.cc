@@ -0,0 +1,604 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file    src/parallel/lib/snapshot.cc
+///
+/// \brief   implements inc/parallel/snapshot.h
+///
+/// \author  agent
+///
+/// \date    2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  agent
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// \version 19/10/2026 agent created
+//
+////////////////////////////////////////////////////////////////////////////////
+#include <parallel/snapshot.h>
+#include <parallel/peano.h>
+#include <public/tree.h>
+#ifdef falcON_NEMO
+#  include <public/nemo++.h>
+#endif
+#include <utils/numerics.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+
+using namespace falcON;
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+  const int      Nlev    = 21;                     // levels in Peano keys
+  const unsigned Nsample = 1024;                   // max samples/process
+  //----------------------------------------------------------------------------
+  // Peano-Hilbert key of position x within the cube of size 2^Nlev/s at x0
+  inline peanokey peano_key(vect const&x, const double x0[3], double s)
+  {
+    const unsigned Max = 1u << Nlev;
+    unsigned i[3];
+    for(int d=0; d!=3; ++d) {
+      const double y = s*(x[d]-x0[d]);
+      i[d] = y <= 0.? 0u : y >= Max? Max-1 : unsigned(y);
+    }
+    PeanoMap M;
+    M.set_root();
+    peanokey k = 0;
+    for(int l=Nlev-1; l>=0; --l) {
+      const int o = ((i[0]>>l)&1) | (((i[1]>>l)&1)<<1) | (((i[2]>>l)&1)<<2);
+      k = (k<<3) | M.key(o);
+      M.shift_to_kid(o);
+    }
+    return k;
+  }
+  //----------------------------------------------------------------------------
+  // # bytes per body needed for data fields F
+  inline size_t record_size(fieldset F)
+  {
+    size_t s = 0;
+    for(fieldbit f; f; ++f)
+      if(F.contain(f)) s += falcON::size(f);
+    return s;
+  }
+  //----------------------------------------------------------------------------
+  // set offsets o[r] from counts n[r], return total count
+  inline int set_offsets(std::vector<int> const&n, std::vector<int>&o)
+  {
+    int t = 0;
+    for(size_t r=0; r!=n.size(); ++r) { o[r] = t; t += n[r]; }
+    return t;
+  }
+  //----------------------------------------------------------------------------
+  // pointer to first element of std::vector, NULL if empty
+  template<typename T> inline T*ptr(std::vector<T>&v)
+  { return v.empty()? 0 : &(v[0]); }
+  //----------------------------------------------------------------------------
+  // distance of point x from box [B[0..2], B[3..5]]
+  inline double distance(const double x[3], const double*B)
+  {
+    double q = 0.;
+    for(int d=0; d!=3; ++d) {
+      const double y = x[d] < B[d]? B[d]-x[d] : x[d] > B[3+d]? x[d]-B[3+d] : 0.;
+      q += y*y;
+    }
+    return std::sqrt(q);
+  }
+  //----------------------------------------------------------------------------
+  // properties of a tree cell needed for the local essential tree
+  struct CellSource {
+    unsigned N;                                    // # source bodies
+    double   M;                                    // mass
+    double   X[3];                                 // centre of mass
+    double   S[3][3];                              // 2nd moment about X
+    double   R;                                    // max |x_i - X|
+    double   E;                                    // max eps_i
+  };
+  //----------------------------------------------------------------------------
+  // compute CellSource data for all cells of a tree, bottom-up
+  void set_sources(const OctTree*T, const bodies*B, std::vector<CellSource>&C)
+  {
+    const bool he = B->have(fieldbit::e);
+    C.resize(T->N_cells());
+    for(unsigned c=T->N_cells(); c--; ) {
+      const OctTree::Cell*Ci = T->CellNo(c);
+      CellSource&S = C[c];
+      S.N = 0;
+      S.M = 0.;
+      for(int d=0; d!=3; ++d) S.X[d] = 0.;
+      for(unsigned l=fcleaf(Ci); l!=ecleaf(Ci); ++l) {
+	const OctTree::Leaf*L = T->LeafNo(l);
+	const double m = B->mass(mybody(L));
+	S.N ++;
+	S.M += m;
+	for(int d=0; d!=3; ++d) S.X[d] += m * pos(L)[d];
+      }
+      for(unsigned k=fccell(Ci); k!=eccell(Ci); ++k) {
+	S.N += C[k].N;
+	S.M += C[k].M;
+	for(int d=0; d!=3; ++d) S.X[d] += C[k].M * C[k].X[d];
+      }
+      if(S.M > 0.)
+	for(int d=0; d!=3; ++d) S.X[d] /= S.M;
+      for(int i=0; i!=3; ++i)
+	for(int j=0; j!=3; ++j) S.S[i][j] = 0.;
+      S.R = 0.;
+      S.E = 0.;
+      for(unsigned l=fcleaf(Ci); l!=ecleaf(Ci); ++l) {
+	const OctTree::Leaf*L = T->LeafNo(l);
+	const double m = B->mass(mybody(L));
+	double x[3], q=0.;
+	for(int d=0; d!=3; ++d) { x[d] = pos(L)[d]-S.X[d]; q += x[d]*x[d]; }
+	for(int i=0; i!=3; ++i)
+	  for(int j=0; j!=3; ++j) S.S[i][j] += m*x[i]*x[j];
+	S.R = max(S.R, std::sqrt(q));
+	if(he) S.E = max(S.E, double(B->eps(mybody(L))));
+      }
+      for(unsigned k=fccell(Ci); k!=eccell(Ci); ++k) {
+	CellSource const&K = C[k];
+	double x[3], q=0.;
+	for(int d=0; d!=3; ++d) { x[d] = K.X[d]-S.X[d]; q += x[d]*x[d]; }
+	for(int i=0; i!=3; ++i)
+	  for(int j=0; j!=3; ++j) S.S[i][j] += K.S[i][j] + K.M*x[i]*x[j];
+	S.R = max(S.R, K.R+std::sqrt(q));
+	S.E = max(S.E, K.E);
+      }
+    }
+  }
+  //----------------------------------------------------------------------------
+  // append a source (x,m,e) to an export list
+  inline void add_source(std::vector<real>&X, const double x[3], double m,
+			 double e)
+  {
+    X.push_back(x[0]);
+    X.push_back(x[1]);
+    X.push_back(x[2]);
+    X.push_back(m);
+    X.push_back(e);
+  }
+  // append a body to an export list
+  inline void add_body(std::vector<real>&X, const OctTree::Leaf*L,
+		       const bodies*B, bool he)
+  {
+    X.push_back(pos(L)[0]);
+    X.push_back(pos(L)[1]);
+    X.push_back(pos(L)[2]);
+    X.push_back(B->mass(mybody(L)));
+    X.push_back(he? B->eps(mybody(L)) : zero);
+  }
+  //----------------------------------------------------------------------------
+  // append the sources of a tree which are needed by a process with bodies in
+  // box B to export list X: cells well separated from B are represented by
+  // six pseudo-particles with the cell's mass, centre of mass, and second
+  // moment, other cells are opened.
+  void essentials(const OctTree*T, const bodies*B,
+		  std::vector<CellSource> const&C, const double*Box, double th,
+		  std::vector<real>&X)
+  {
+    const bool he = B->have(fieldbit::e);
+    std::vector<unsigned> stack(1,0u);
+    while(!stack.empty()) {
+      const unsigned c = stack.back();
+      stack.pop_back();
+      const OctTree::Cell*Ci = T->CellNo(c);
+      CellSource const&S = C[c];
+      if(S.N == 0) continue;
+      if(S.R < th*distance(S.X,Box)) {
+	if(S.N <= 6) {
+	  // few bodies: export them
+	  for(unsigned l=fcleaf(Ci); l!=ncleaf(Ci); ++l)
+	    add_body(X,T->LeafNo(l),B,he);
+	} else {
+	  // six pseudo-particles at X +/- a_k e_k with a_k^2 = 3 lambda_k/M
+	  double V[3][3], D[3];
+	  int    r;
+	  WDutils::EigenSymJacobi<3,double>(S.S,V,D,r);
+	  const double m = S.M/6;
+	  for(int k=0; k!=3; ++k) {
+	    const double a = D[k] > 0.? std::sqrt(3*D[k]/S.M) : 0.;
+	    double x[3];
+	    for(int d=0; d!=3; ++d) x[d] = S.X[d] + a*V[d][k];
+	    add_source(X,x,m,S.E);
+	    for(int d=0; d!=3; ++d) x[d] = S.X[d] - a*V[d][k];
+	    add_source(X,x,m,S.E);
+	  }
+	}
+      } else {
+	// open cell: export its leaf kids, consider its cell kids
+	for(unsigned l=fcleaf(Ci); l!=ecleaf(Ci); ++l)
+	  add_body(X,T->LeafNo(l),B,he);
+	for(unsigned k=fccell(Ci); k!=eccell(Ci); ++k)
+	  stack.push_back(k);
+      }
+    }
+  }
+} // namespace {
+////////////////////////////////////////////////////////////////////////////////
+ParallelSnapshot::ParallelSnapshot(const MPI::Communicator*C, fieldset Bd)
+  falcON_THROWING
+: COMM(C), LOCAL(0), NBOD(0), NIMP(0)
+{
+  if(COMM == 0)
+    falcON_THROW("ParallelSnapshot: no communicator (MPI not started?)\n");
+  LOCAL = new snapshot(Bd);
+  LOCAL->set_parallel(this);
+}
+//------------------------------------------------------------------------------
+ParallelSnapshot::~ParallelSnapshot()
+{
+  if(NBOD)  falcON_DEL_A(NBOD);
+  if(LOCAL) falcON_DEL_O(LOCAL);
+}
+//------------------------------------------------------------------------------
+unsigned ParallelSnapshot::N_global(bodytype t) const
+{
+  unsigned n;
+  COMMUN(COMM)->AllReduce<MPI::Sum>(LOCAL->N_bodies(t),n);
+  return n;
+}
+//------------------------------------------------------------------------------
+unsigned ParallelSnapshot::N_global() const
+{
+  unsigned n;
+  COMMUN(COMM)->AllReduce<MPI::Sum>(LOCAL->N_bodies(),n);
+  return n;
+}
+//------------------------------------------------------------------------------
+void ParallelSnapshot::unify_fields() falcON_THROWING
+{
+  fieldset::value_type v = value(LOCAL->all_data());
+  COMMUN(COMM)->AllReduceInPlace<MPI::BOr>(v);
+  LOCAL->add_fields(fieldset(v));
+}
+//------------------------------------------------------------------------------
+char*ParallelSnapshot::pack(body const&b, fieldset F, char*buf)
+{
+  const bodies::block*B = block_of(b);
+  const unsigned      K = subindex(b);
+  for(fieldbit f; f; ++f) if(F.contain(f)) {
+    const size_t s = falcON::size(f);
+    if(B->DATA[value(f)])
+      std::memcpy(buf,static_cast<const char*>(B->DATA[value(f)])+K*s,s);
+    else
+      std::memset(buf,0,s);
+    buf += s;
+  }
+  return buf;
+}
+//------------------------------------------------------------------------------
+const char*ParallelSnapshot::unpack(body const&b, fieldset F, const char*buf)
+{
+  const bodies::block*B = block_of(b);
+  const unsigned      K = subindex(b);
+  for(fieldbit f; f; ++f) if(F.contain(f)) {
+    const size_t s = falcON::size(f);
+    if(B->DATA[value(f)])
+      std::memcpy(static_cast<char*>(B->DATA[value(f)])+K*s,buf,s);
+    buf += s;
+  }
+  return buf;
+}
+//------------------------------------------------------------------------------
+body ParallelSnapshot::activate(unsigned&n, bodytype t, unsigned na)
+  falcON_THROWING
+{
+  for(const bodies::block*B=LOCAL->TYPES[t]; B; B=B->next_of_same_type())
+    if(B->N_free()) {
+      n = min(n,B->N_free());
+      return LOCAL->new_bodies(n,t);
+    }
+  return LOCAL->new_bodies(n,t,max(n,na));
+}
+//------------------------------------------------------------------------------
+void ParallelSnapshot::decompose() falcON_THROWING
+{
+  if(NBOD)
+    falcON_THROW("ParallelSnapshot::decompose(): imported bodies present\n");
+  const int P = COMM->size(), R = COMM->rank();
+  if(P == 1) return;
+  if(!LOCAL->have(fieldbit::f))
+    LOCAL->add_field(fieldbit::f);
+  unify_fields();
+  // 1 cube containing all bodies
+  double X[6] = {-DBL_MAX,-DBL_MAX,-DBL_MAX,-DBL_MAX,-DBL_MAX,-DBL_MAX};
+  LoopAllBodies(LOCAL,b)
+    for(int d=0; d!=3; ++d) {
+      X[d]   = max(X[d]  ,-double(pos(b)[d]));
+      X[3+d] = max(X[3+d], double(pos(b)[d]));
+    }
+  COMMUN(COMM)->AllReduceInPlace<MPI::Max>(X,6);
+  if(X[0] == -DBL_MAX) return;                     // no bodies anywhere
+  double x0[3], L=0.;
+  for(int d=0; d!=3; ++d) {
+    x0[d] =-X[d];
+    L     = max(L,X[3+d]+X[d]);
+  }
+  const double s = L > 0.? (1u<<Nlev)/(1.0001*L) : 1.;
+  // 2 Peano-Hilbert keys of local bodies (in the order of LoopAllBodies)
+  const unsigned N = LOCAL->N_bodies();
+  std::vector<peanokey> K(N);
+  {
+    unsigned i=0;
+    LoopAllBodies(LOCAL,b) K[i++] = peano_key(pos(b),x0,s);
+  }
+  // 3 splitters: process r obtains keys in [S[r-1],S[r]), found from samples
+  //   of the sorted local keys, each sample carrying weight N_local/N_sample
+  std::vector<peanokey> S(P-1);
+  {
+    std::vector<peanokey> Ks(K);
+    std::sort(Ks.begin(),Ks.end());
+    const int      ns = min(N,Nsample);
+    const double   ws = ns? double(N)/double(ns) : 0.;
+    std::vector<peanokey> ks(ns);
+    for(int j=0; j!=ns; ++j)
+      ks[j] = Ks[((2*size_t(j)+1)*N)/(2*ns)];
+    std::vector<int>    n(P), o(P);
+    std::vector<double> w(P);
+    COMMUN(COMM)->AllGather(ns,ptr(n));
+    COMMUN(COMM)->AllGather(ws,ptr(w));
+    const int nt = set_offsets(n,o);
+    std::vector<peanokey> ka(nt);
+    COMMUN(COMM)->AllGatherV(ptr(ks),ns,ptr(ka),ptr(n),ptr(o));
+    std::vector< std::pair<peanokey,double> > sa(nt);
+    double W = 0.;
+    for(int r=0; r!=P; ++r)
+      for(int j=0; j!=n[r]; ++j) {
+	sa[o[r]+j] = std::make_pair(ka[o[r]+j],w[r]);
+	W += w[r];
+      }
+    std::sort(sa.begin(),sa.end());
+    double c = 0.;
+    int    r = 1;
+    for(int j=0; j!=nt && r!=P; ++j) {
+      while(r!=P && c+0.5*sa[j].second >= W*r/P)
+	S[r++ -1] = sa[j].first;
+      c += sa[j].second;
+    }
+    while(r!=P) S[r++ -1] = ~peanokey(0);
+  }
+  // 4 send bodies not in our domain, type by type
+  std::vector<int> D(N);
+  for(unsigned i=0; i!=N; ++i)
+    D[i] = std::upper_bound(S.begin(),S.end(),K[i]) - S.begin();
+  unsigned Ng[bodytype::NUM], Nr[bodytype::NUM];
+  for(bodytype t; t; ++t) Ng[t] = LOCAL->N_bodies(t);
+  COMMUN(COMM)->AllReduceInPlace<MPI::Sum>(Ng,int(bodytype::NUM));
+  std::vector<char> Rcv[bodytype::NUM];
+  std::vector<int>  ns(P), os(P), nr(P), orc(P);
+  unsigned i0 = 0;                                 // first of type t in D[]
+  for(bodytype t; t; ++t) {
+    const unsigned nt = LOCAL->N_bodies(t);
+    Nr[t] = 0;
+    if(Ng[t] == 0) { i0 += nt; continue; }
+    const fieldset F  = LOCAL->all_data() & t.allows();
+    const size_t   rs = record_size(F);
+    for(int r=0; r!=P; ++r) ns[r] = 0;
+    for(unsigned i=i0; i!=i0+nt; ++i)
+      if(D[i] != R) ++(ns[D[i]]);
+    std::vector<char> Snd(set_offsets(ns,os)*rs);
+    std::vector<int>  at(os);
+    unsigned i=i0;
+    LoopTypedBodies(LOCAL,b,t) {
+      if(D[i] != R) {
+	pack(b,F,ptr(Snd)+rs*(at[D[i]]++));
+	b.flag_for_removal();
+      }
+      ++i;
+    }
+    COMMUN(COMM)->AllToAll(ptr(ns),ptr(nr));
+    Nr[t] = set_offsets(nr,orc);
+    Rcv[t].resize(Nr[t]*rs);
+    COMMUN(COMM)->AllToAllV(ptr(Snd),ptr(ns),ptr(os),
+			    ptr(Rcv[t]),ptr(nr),ptr(orc),rs);
+    i0 += nt;
+  }
+  // 5 remove bodies sent (counted in N_del(), such that the next tree is
+  //   built from scratch), add bodies received (not counted in N_new())
+  LOCAL->remove();
+  for(bodytype t; t; ++t) if(Nr[t]) {
+    const fieldset F = LOCAL->all_data() & t.allows();
+    const char*p = ptr(Rcv[t]);
+    for(unsigned k=Nr[t]; k; ) {
+      unsigned m = k;
+      body b = activate(m,t,Nr[t]);
+      for(k-=m; m; --m, ++b)
+	p = unpack(b,F,p);
+    }
+  }
+  DebugInfo(4,"ParallelSnapshot::decompose(): %u -> %u bodies\n",
+	    N,LOCAL->N_bodies());
+}
+//------------------------------------------------------------------------------
+unsigned ParallelSnapshot::import_essential(real th, unsigned Nc)
+  falcON_THROWING
+{
+  if(NBOD)
+    falcON_THROW("ParallelSnapshot::import_essential(): "
+		 "imported bodies present\n");
+  // remember # bodies per block, so that discard_imports() can restore them
+  NBOD = falcON_NEW(unsigned,bodies::index::max_blocks);
+  for(int i=0; i!=bodies::index::max_blocks; ++i)
+    NBOD[i] = LOCAL->BLOCK[i]? LOCAL->BLOCK[i]->NBOD : 0u;
+  NIMP = 0;
+  const int P = COMM->size(), R = COMM->rank();
+  if(P == 1) return 0;
+  // 1 boxes containing the bodies of each process
+  double B[6] = {DBL_MAX,DBL_MAX,DBL_MAX,-DBL_MAX,-DBL_MAX,-DBL_MAX};
+  LoopAllBodies(LOCAL,b)
+    for(int d=0; d!=3; ++d) {
+      B[d]   = min(B[d]  , double(pos(b)[d]));
+      B[3+d] = max(B[3+d], double(pos(b)[d]));
+    }
+  std::vector<double> Ba(6*P);
+  COMMUN(COMM)->AllGather(B,ptr(Ba),6);
+  // 2 find the sources needed by each other process
+  std::vector< std::vector<real> > X(P);
+  if(LOCAL->N_bodies()) {
+    OctTree T(LOCAL,Nc);
+    std::vector<CellSource> C;
+    set_sources(&T,LOCAL,C);
+    for(int r=0; r!=P; ++r)
+      if(r != R && Ba[6*r] <= Ba[6*r+3])
+	essentials(&T,LOCAL,C,ptr(Ba)+6*r,th,X[r]);
+  }
+  // 3 exchange them
+  std::vector<int> ns(P), os(P), nr(P), orc(P);
+  for(int r=0; r!=P; ++r) ns[r] = X[r].size();
+  std::vector<real> Snd(set_offsets(ns,os));
+  for(int r=0; r!=P; ++r)
+    if(ns[r]) std::memcpy(ptr(Snd)+os[r],ptr(X[r]),ns[r]*sizeof(real));
+  COMMUN(COMM)->AllToAll(ptr(ns),ptr(nr));
+  std::vector<real> Rcv(set_offsets(nr,orc));
+  COMMUN(COMM)->AllToAllV(ptr(Snd),ptr(ns),ptr(os),
+			  ptr(Rcv),ptr(nr),ptr(orc));
+  // 4 append them as inactive std bodies
+  NIMP = Rcv.size()/5;
+  const bool  he = LOCAL->have(fieldbit::e);
+  const bool  hf = LOCAL->have(fieldbit::f);
+  const real *p  = ptr(Rcv);
+  for(unsigned k=NIMP; k; ) {
+    unsigned m = k;
+    body b = activate(m,bodytype::std,NIMP);
+    for(k-=m; m; --m, ++b, p+=5) {
+      b.pos()[0] = p[0];
+      b.pos()[1] = p[1];
+      b.pos()[2] = p[2];
+      b.mass()   = p[3];
+      if(he) b.eps()  = p[4];
+      if(hf) b.flag() = flags::empty;
+    }
+  }
+  DebugInfo(4,"ParallelSnapshot::import_essential(): imported %u sources\n",
+	    NIMP);
+  return NIMP;
+}
+//------------------------------------------------------------------------------
+void ParallelSnapshot::discard_imports() falcON_THROWING
+{
+  if(NBOD == 0) return;
+  for(int i=0; i!=bodies::index::max_blocks; ++i)
+    if(LOCAL->BLOCK[i]) LOCAL->BLOCK[i]->NBOD = NBOD[i];
+  LOCAL->set_firsts();
+  LOCAL->NDEL[bodytype::std] += NIMP;              // tree: don't use leaf order
+  falcON_DEL_A(NBOD);
+  NBOD = 0;
+  NIMP = 0;
+}
+#ifdef falcON_NEMO
+//------------------------------------------------------------------------------
+bool ParallelSnapshot::read_nemo(nemo_in const&Is, fieldset&Read, fieldset Get,
+				 const char*range, bool warn) falcON_THROWING
+{
+  if(NBOD)
+    falcON_THROW("ParallelSnapshot::read_nemo(): imported bodies present\n");
+  int                  got = 0;
+  double               tim = 0.;
+  fieldset::value_type red = 0;
+  if(COMM->is_master()) {
+    if(Is.has_snapshot()) {
+      got = LOCAL->read_nemo(Is,Read,Get,range,warn);
+      tim = LOCAL->time();
+      red = value(Read);
+    } else
+      got = -1;
+  }
+  COMMUN(COMM)->BroadCast(0,got);
+  if(got < 0)
+    falcON_THROW("ParallelSnapshot::read_nemo(): no snapshot to read");
+  COMMUN(COMM)->BroadCast(0,red);
+  Read = fieldset(red);
+  if(!got) return false;
+  COMMUN(COMM)->BroadCast(0,tim);
+  LOCAL->set_time(tim);
+  if(!COMM->is_master()) {
+    const unsigned N0[bodytype::NUM] = {0u};
+    LOCAL->resetN(N0);
+  }
+  // keys remember the order in input, used by write_nemo()
+  if(!Read.contain(fieldbit::k)) {
+    LOCAL->add_field(fieldbit::k);
+    if(COMM->is_master()) LOCAL->reset_keys();
+  }
+  decompose();
+  LOCAL->reset_Nnew();
+  LOCAL->reset_Ndel();
+  return true;
+}
+//------------------------------------------------------------------------------
+void ParallelSnapshot::write_nemo(nemo_out const&Os, fieldset Bd) const
+  falcON_THROWING
+{
+  int state = 0;                                   // 0: sink, 1: open, -1: not
+  if(COMM->is_master())
+    state = Os.is_sink()? 0 : Os.is_open()? 1 : -1;
+  COMMUN(COMM)->BroadCast(0,state);
+  if(state < 0)
+    falcON_THROW("ParallelSnapshot::write_nemo(): nemo device not open\n");
+  if(state == 0) return;
+  if(NBOD)
+    falcON_THROW("ParallelSnapshot::write_nemo(): imported bodies present\n");
+  const int  P = COMM->size();
+  const bool M = COMM->is_master();
+  const bool sorted = LOCAL->have(fieldbit::k);
+  const fieldset W  = LOCAL->all_data() & (sorted? Bd|fieldset::k : Bd);
+  unsigned Nt[bodytype::NUM];
+  for(bodytype t; t; ++t) Nt[t] = LOCAL->N_bodies(t);
+  COMMUN(COMM)->AllReduceInPlace<MPI::Sum>(Nt,int(bodytype::NUM));
+  snapshot*S = M? new snapshot(LOCAL->time(),Nt,W) : 0;
+  std::vector<int> n(P), o(P);
+  for(bodytype t; t; ++t) if(Nt[t]) {
+    // collect bodies of type t at rank 0
+    const fieldset F  = W & t.allows();
+    const size_t   rs = record_size(F);
+    const int      nl = LOCAL->N_bodies(t);
+    COMMUN(COMM)->AllGather(nl,ptr(n));
+    set_offsets(n,o);
+    std::vector<char> Snd(nl*rs), All(M? Nt[t]*rs : 0);
+    char*p = ptr(Snd);
+    LoopTypedBodies(LOCAL,b,t)
+      p = pack(b,F,p);
+    COMMUN(COMM)->GatherV(0,ptr(Snd),nl,ptr(All),ptr(n),ptr(o),rs);
+    if(!M) continue;
+    // put them in the order of their keys, if any
+    std::vector<unsigned> I(Nt[t]);
+    for(unsigned i=0; i!=Nt[t]; ++i) I[i] = i;
+    if(sorted) {
+      size_t ok = 0;
+      for(fieldbit f; f && f != fieldbit::k; ++f)
+	if(F.contain(f)) ok += falcON::size(f);
+      std::vector< std::pair<int,unsigned> > KI(Nt[t]);
+      for(unsigned i=0; i!=Nt[t]; ++i) {
+	std::memcpy(&(KI[i].first),ptr(All)+i*rs+ok,sizeof(int));
+	KI[i].second = i;
+      }
+      std::sort(KI.begin(),KI.end());
+      for(unsigned i=0; i!=Nt[t]; ++i) I[i] = KI[i].second;
+    }
+    unsigned i = 0;
+    LoopTypedBodies(S,b,t)
+      unpack(b,F,ptr(All)+I[i++]*rs);
+  }
+  if(M) {
+    S->write_nemo(Os,Bd);
+    falcON_DEL_O(S);
+  }
+}
+#endif // falcON_NEMO
+//---------------------end-of-snapshot.cc--------------------------------------
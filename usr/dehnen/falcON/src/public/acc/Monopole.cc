@@ -25,6 +25,7 @@
 // 0.1    18/02/2005  WD compiled & debugged. seems to work ok.                |
 // 0.2    17/05/2005  WD deBUGged (forces were wrong if t0<t<t1)               |
 // 0.3    09/08/2006  WD use $NEMOINC/defacc.h                                 |
+// 0.4    19/10/2026     monopole part: loop over bodies in parallel           |
 //-----------------------------------------------------------------------------+
 #include <iostream>
 #include <fstream>
@@ -409,7 +410,10 @@ namespace {
 			    table_type       *dy = 0,
 			    table_type       *d2y= 0)
     {
-      static int lo=0;
+      static int lo=0;                             // hint for find(), per thread
+#ifdef _OPENMP
+#     pragma omp threadprivate(lo)
+#endif
       find(lo,n,x,xi);
       if(lo==n-1) --lo;
       return evaluate(xi,x+lo,y+lo,y1+lo,y3+lo,dy,d2y);
@@ -655,9 +659,11 @@ namespace {
   {
     const scalar pmono = 1-ampl, fmono = -2*pmono;
     nemo_dprintf(4,"Monopole: setting P = %f * Phi_0\n",pmono);
-    for(int n=0; n!=nbod; ++n,x+=NDIM,p++,a+=NDIM)
+#pragma omp parallel for if(nbod > 256) schedule(static)
+    for(int n=0; n<nbod; ++n)
       if(f==0 || f[n] & 1) {
-	double xq = v_norm<NDIM>(x), f0, p0;
+	const scalar*xn = x+NDIM*n;
+	double xq = v_norm<NDIM>(xn), f0, p0;
 	if(xq > RQMAX) {
 	  double r = sqrt(RQMAX/xq);
 	  p0 = M0[N1] * r;
@@ -667,8 +673,8 @@ namespace {
 	  f0 = M1[0];
 	} else
 	  p0 = penta_splines::eval(NR,xq,RQ,M0,M1,M3,&f0);
-	set<NDIM,ADD_P>::s(p[0], pmono*p0);
-	set<NDIM,ADD_A>::v(a,x,fmono*scalar(f0));
+	set<NDIM,ADD_P>::s(p[n], pmono*p0);
+	set<NDIM,ADD_A>::v(a+NDIM*n,xn,fmono*scalar(f0));
       }
   }
   //////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,126 @@
+// -*- C -*-                                                                   |
+//-----------------------------------------------------------------------------+
+//                                                                             |
+// TestReuseC.c                                                                |
+//                                                                             |
+// Copyright (C) 2026 agent                                                    |
+//                                                                             |
+// This program is free software; you can redistribute it and/or modify        |
+// it under the terms of the GNU General Public License as published by        |
+// the Free Software Foundation; either version 2 of the License, or (at       |
+// your option) any later version.                                             |
+//                                                                             |
+// This program is distributed in the hope that it will be useful, but         |
+// WITHOUT ANY WARRANTY; without even the implied warranty of                  |
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           |
+// General Public License for more details.                                    |
+//                                                                             |
+// You should have received a copy of the GNU General Public License           |
+// along with this program; if not, write to the Free Software                 |
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.                   |
+//                                                                             |
+//-----------------------------------------------------------------------------+
+//                                                                             |
+// tests tree re-use via the C interface:                                      |
+// - falcON_reuse() before any tree exists grows one instead;                  |
+// - falcON_gravity(Nc,Nreuse) re-uses the tree Nreuse times, then grows it;   |
+// - forces from a re-used tree agree with those from a fresh tree.            |
+// returns 0 on success, 1 on failure                                          |
+//                                                                             |
+//-----------------------------------------------------------------------------+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <forces_C.h>
+
+#ifdef falcON_DOUBLE
+#  define INPUT_TYPE double
+#else
+#  define INPUT_TYPE float
+#endif
+
+typedef INPUT_TYPE INPUT_VECT[3];
+
+#define Pi   3.14159265358979323846264338328
+#define TPi  (2*Pi)
+
+int main(int argc, char* argv[])
+{
+  int         N, S, Ncrit, Nreuse=2, *F, i, j, k, grown, fail=0;
+  INPUT_TYPE *M,*PH,*RHO;
+  INPUT_VECT *X,*A,*A0;
+  double      r,cth,R,phi,a2,da2,drms=0.;
+
+  if(argc < 2 || argc > 4) {
+    printf("\"TestReuseC N [S Nc]\" with \n");
+    printf(" N                   : number of bodies (Plummer sphere)\n");
+    printf(" S  (default    1)   : seed for RNG\n");
+    printf(" Nc (default   %2d)   : don't split cells with N <= Nc bodies\n",
+	   falcON_default_Ncrit());
+    exit(1);
+  }
+  N     = atoi(argv[1]);
+  S     = argc>2? atoi(argv[2]) : 1;
+  Ncrit = argc>3? atoi(argv[3]) : falcON_default_Ncrit();
+
+  F   = (int       *)malloc(sizeof(int)       *N);
+  M   = (INPUT_TYPE*)malloc(sizeof(INPUT_TYPE)*N);
+  PH  = (INPUT_TYPE*)malloc(sizeof(INPUT_TYPE)*N);
+  RHO = (INPUT_TYPE*)malloc(sizeof(INPUT_TYPE)*N);
+  X   = (INPUT_VECT*)malloc(sizeof(INPUT_VECT)*N);
+  A   = (INPUT_VECT*)malloc(sizeof(INPUT_VECT)*N);
+  A0  = (INPUT_VECT*)malloc(sizeof(INPUT_VECT)*N);
+  srand(S);
+  for(i=0; i!=N; ++i) {
+    r      = 1./sqrt(pow((rand()+1.)/(RAND_MAX+2.),-2./3.)-1.);
+    cth    = 2*(rand()/(RAND_MAX+1.))-1;
+    R      = r*sqrt(1.-cth*cth);
+    phi    = TPi*(rand()/(RAND_MAX+1.));
+    F[i]   = 1;
+    M[i]   = 1./N;
+    X[i][0]= R*sin(phi);
+    X[i][1]= R*cos(phi);
+    X[i][2]= r*cth;
+  }
+  falcON_initialize(F,M,(INPUT_TYPE*)X,0,(INPUT_TYPE*)A,PH,RHO,N,0,
+		    0.01,falcON_default_theta(),falcON_default_kernel(),1);
+  /*
+   * reuse before any grow: must grow instead
+   */
+  falcON_reuse();
+  falcON_approx_grav();
+  for(i=0; i!=N; ++i) for(j=0; j!=3; ++j) A0[i][j] = A[i][j];
+  /*
+   * Nreuse re-uses, then a grow; the re-uses must see the tree grown above
+   */
+  for(k=0; k<=Nreuse; ++k) {
+    grown = falcON_gravity(Ncrit,Nreuse);
+    if(grown != (k==Nreuse)) {
+      printf(" falcON_gravity() call %d: %s, expected %s\n",k,
+	     grown? "grown":"re-used", k==Nreuse? "grown":"re-used");
+      fail = 1;
+    }
+  }
+  /*
+   * forces from a re-used tree (positions unchanged) must agree with the
+   * forces from the fresh tree, up to the force approximation (the cells
+   * are re-sized on re-use, so the interactions are not quite the same)
+   */
+  falcON_reuse();
+  falcON_approx_grav();
+  for(i=0; i!=N; ++i) {
+    for(a2=da2=0.,j=0; j!=3; ++j) {
+      a2 += A0[i][j]*A0[i][j];
+      da2+= (A[i][j]-A0[i][j])*(A[i][j]-A0[i][j]);
+    }
+    if(a2>0.) drms += da2/a2;
+  }
+  drms = sqrt(drms/N);
+  printf(" rms |dacc|/|acc| between re-used and fresh tree: %g\n",drms);
+  if(drms > 1.e-2) fail = 1;                    /* typical: 1.e-4 - 1.e-3 */
+  falcON_clearup();
+  printf(fail? " TestReuseC: FAILED\n" : " TestReuseC: OK\n");
+  free(F); free(M); free(PH); free(RHO); free(X); free(A); free(A0);
+  return fail;
+}
@@ -42,9 +42,10 @@
 // v 3.0.1  09/09/2007  WD ?                                                    
 // v 3.0.2  20/05/2008  WD renamed routine from neighbour.h                     
 // v 3.0.3  20/05/2008  WD happy gcc 4.3.1                                      
+// v 3.1    19/10/2026      parallel neighbour processing (OpenMP)             
 ////////////////////////////////////////////////////////////////////////////////
-#define falcON_VERSION   "3.0.3"
-#define falcON_VERSION_D "10-sep-2008 Walter Dehnen                          "
+#define falcON_VERSION   "3.1"
+#define falcON_VERSION_D "19-oct-2026                                        "
 //-----------------------------------------------------------------------------+
 #ifndef falcON_NEMO                                // this is a NEMO program    
 #  error You need NEMO to compile "density"
@@ -148,7 +149,7 @@ void falcON::main() falcON_THROWING
     // estimate density
     SHOT.add_field(fieldbit::r);
     unsigned NIAC;
-    ProcessNearestNeighbours(&TREE,K,&SetDensity,NIAC,true);
+    ProcessNearestNeighboursParallel(&TREE,K,&SetDensity,NIAC,true);
 
     // for non-chosen bodies set density to zero
     if(BF)
@@ -147,6 +147,7 @@
 // v 3.5    15/06/2011  WD recompute forces if manipulator changes masses
 // v 3.5.1  30/06/2011  WD eps required (no default value)
 // v 3.6    19/06/2011  WD happy gcc 4.7.0
+//          19/10/2026  agent: MPI parallel, if compiled with falcON_MPI
 ////////////////////////////////////////////////////////////////////////////////
 #define falcON_VERSION   "3.6"
 #define falcON_VERSION_D "19-jun-2012 Walter Dehnen                          "
@@ -155,6 +156,7 @@
 #  error You need "NEMO" to compile gyrfalcON
 #endif
 #define falcON_RepAction 1                         // do action reporting
+#define falcON_PARALLEL                            // use MPI if falcON_MPI
 #include <public/nbody.h>                          // the N-body code
 #include <public/manip.h>                          // N-body manipulators
 #include <main.h>                                  // main & NEMO stuf
@@ -243,6 +245,13 @@ void falcON::main() falcON_THROWING
 			  getparam_z("manippath"));
   const fieldset need(MANIP? MANIP.need() : fieldset(fieldset::empty));
   const bool recforce(MANIP && MANIP.change().contain(fieldbit::m));
+#ifdef falcON_USE_MPI
+  // manipulators only see the bodies of their process, so that e.g. a centre
+  // or Lagrange radii would silently differ between processes: refuse them.
+  if(MANIP && MPI::World()->size() > 1)
+    falcON_THROW("manipname: manipulators are not supported "
+		 "with more than one MPI process");
+#endif
   if(Nlev>1 &&
      ! (hasvalue("fac") || hasvalue("fph") ||
 	hasvalue("fpa") || hasvalue("fea") ))
@@ -304,20 +313,32 @@ void falcON::main() falcON_THROWING
     return;
   }
   // 3. open output streams & make initial outputs                              
-  output LOGOUT(getparam("logfile"),resume);
+  //    with MPI, only rank 0 opens them, but all ranks take part in outputs
+#ifdef falcON_USE_MPI
+  const bool master = MPI::World()->is_master();
+#else
+  const bool master = true;
+#endif
+  output LOGOUT(master? getparam("logfile") : ".",resume);
   if(!resume && !hasvalue("out"))
     falcON_THROW("you must provide an output file");
-  nemo_out OUT(hasvalue("out")? getparam("out") : getparam("in"),
+  nemo_out OUT(master? (hasvalue("out")? getparam("out") : getparam("in")) : 0,
 	       !hasvalue("out"));
+  bool logging = LOGOUT, writing = OUT, appending = LOGOUT.is_appending();
+#ifdef falcON_USE_MPI
+  COMMUN(MPI::World())->BroadCast(0,logging);
+  COMMUN(MPI::World())->BroadCast(0,writing);
+  COMMUN(MPI::World())->BroadCast(0,appending);
+#endif
   bool written=false;
   if(!resume && getbparam("startout")) {
     NBDY.write(OUT,write);
     written = true;
   }
-  if(LOGOUT) {
+  if(logging) {
     NBDY.describe  (LOGOUT);
     NBDY.stats_head(LOGOUT);
-    if(!LOGOUT.is_appending())
+    if(!appending)
       NBDY.stats   (LOGOUT);
   }
   // 4. time integration & outputs                                              
@@ -325,12 +346,15 @@ void falcON::main() falcON_THROWING
   bool HaltFile=false, HaltManip=false;
   for(int steps=1; never_ending || NBDY.time() < t_end; ++steps) {
     HaltFile = stopfile && file_exists(getparam("stopfile"));
+#ifdef falcON_USE_MPI
+    COMMUN(MPI::World())->BroadCast(0,HaltFile);
+#endif
     if(HaltFile) break;
     NBDY.full_step(recforce);
-    if(LOGOUT && steps%logstep ==0)
+    if(logging && steps%logstep ==0)
       NBDY.stats(LOGOUT);
     HaltManip = MANIP && MANIP(NBDY.my_snapshot());
-    if(OUT && NBDY.time() >= t_out) {
+    if(writing && NBDY.time() >= t_out) {
       NBDY.write(OUT,write);
       t_out += dt_out;
       written = true;
@@ -338,7 +362,7 @@ void falcON::main() falcON_THROWING
       written = false;
     if(HaltManip) break;
   }
-  if(OUT && !written && lastout)
+  if(writing && !written && lastout)
     NBDY.write(OUT,write);
   if(LOGOUT && HaltFile)
     LOGOUT <<"# simulation STOPPED because file \""
@@ -25,6 +25,9 @@
 #include <cstring>
 #include <iomanip>
 #include <rpc/rpc.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 #undef MAX
 #undef MIN
 #ifdef   falcON_NEMO
@@ -2174,13 +2177,15 @@ namespace {
 		   int       mark) {               // I: source mark            
       K = 0;                                       //   reset buffer            
       if(mark && f) {                              //   IF only marked bodies   
-	for(int i=0; i!=n; ++i)                    //     LOOP bodies           
+#pragma omp for schedule(static)
+	for(int i=0; i<n; ++i)                     //     LOOP bodies           
 	  if(f[i]&mark && m[i] != 0) {             //       IF marked & massive 
 	    load(m[i],x[i]);                       //         load into buffer  
 	    if(K==4) flush<SYM>();                 //         flush full buffer 
 	  }                                        //     END LOOP              
       } else {                                     //   ELSE (all bodies)       
-	for(int i=0; i!=n; ++i)                    //     LOOP bodies           
+#pragma omp for schedule(static)
+	for(int i=0; i<n; ++i)                     //     LOOP bodies           
 	  if(m[i] != 0) {                          //       IF massive          
 	    load(m[i],x[i]);                       //         load into buffer  
 	    if(K==4) flush<SYM>();                 //         flush full buffer 
@@ -2198,11 +2203,12 @@ namespace {
       PotExp::scalar rd,ct,st,cp,sp;
       AnlRec         Psi(C->nmax(),C->lmax());
       YlmRec         Ylm(C->lmax());
-      for(int i=0; i!=n; ++i) {
+#pragma omp for schedule(static)
+      for(int i=0; i<n; ++i) {
 	Spherical(rd,ct,st,cp,sp,x[i]);
 	SetPsi<SYM>(Psi,rd,T(1));
 	SetYlm<SYM>(Ylm,ct,st,cp,sp);
-	for(int j=0; j!=m; ++m)
+	for(int j=0; j!=m; ++j)
 	  AUX<SYM>::template Connect<_addT>(C[j],Psi,Ylm,y[i][j]);
       }
     }
@@ -2461,12 +2467,14 @@ namespace {
 		      int       add) {             // I: add or assign?         
       K = 0;                                       //   reset buffer            
       if(f) {                                      //   IF only flagged bodies  
-	for(int i=0; i!=n; ++i) if(f[i] & 1) {     //     LOOP flagged bodies   
+#pragma omp for
+	for(int i=0; i<n; ++i) if(f[i] & 1) {      //     LOOP flagged bodies   
 	  load(i,x[i]);                            //       load into buffer    
 	  if(K==4) flush<SYM>(p,add);              //       flush full buffer   
 	}                                          //     END LOOP              
       } else {                                     //   ELSE: all bodies        
-	for(int i=0; i!=n; ++i) {                  //     LOOP all bodies       
+#pragma omp for
+	for(int i=0; i<n; ++i) {                   //     LOOP all bodies       
 	  load(i,x[i]);                            //       load into buffer    
 	  if(K==4) flush<SYM>(p,add);              //       flush full buffer   
 	}                                          //     END LOOP              
@@ -2614,10 +2622,36 @@ void PotExp::AddCoeffs  (Anlm             &C,       // O: C_nlm coefficients
   // where the sum includes either all (mass-carrying) bodies if k==0, or       
   // all bodies whose flag contains (at least one of) the bits in mark.         
   //                                                                            
+  // With OpenMP, each thread adds to its own coefficients, which are then     
+  // summed in thread order, so that the result does not depend on timing;     
+  // it agrees with the serial sum up to round-off.                            
+  //                                                                            
 {
   CHECKMISMATCH("AddCoeffs",C);
   setAL(AL);
   setR0(R0);
+#ifdef _OPENMP
+  if(omp_get_max_threads() > 1 && !omp_in_parallel()) {
+    const int nt = omp_get_max_threads();
+    Anlm**Ct = falcON_NEW(Anlm*,nt);
+    for(int t=0; t!=nt; ++t) Ct[t] = 0;
+#pragma omp parallel num_threads(nt)
+    {
+      Anlm*Ci = falcON_NEW(Anlm,1);
+      Ci->reset(C.nmax(),C.lmax());
+      Ci->reset();
+      Ct[omp_get_thread_num()] = Ci;
+      CBlock<T> B4(*Ci);
+      B4.AddCoeffs(SYM,n,m,x,f,k);
+    }
+    for(int t=0; t!=nt; ++t) if(Ct[t]) {
+      C.add(*Ct[t],SYM);
+      falcON_DEL_A(Ct[t]);
+    }
+    falcON_DEL_A(Ct);
+    return;
+  }
+#endif
   CBlock<T> B4(C);
   B4.AddCoeffs(SYM,n,m,x,f,k);
 }
@@ -2649,6 +2683,30 @@ void PotExp::AddCoeffs  (int               m,       // I: # quantities
   for(int j=0; j!=m; ++j) { CHECKMISMATCH("AddCoeffs",C[j]); }
   setAL(AL);
   setR0(R0);
+#ifdef _OPENMP
+  if(omp_get_max_threads() > 1 && !omp_in_parallel()) {
+    const int nt = omp_get_max_threads();
+    Anlm**Ct = falcON_NEW(Anlm*,nt);
+    for(int t=0; t!=nt; ++t) Ct[t] = 0;
+#pragma omp parallel num_threads(nt)
+    {
+      Anlm*Ci = falcON_NEW(Anlm,m);
+      for(int j=0; j!=m; ++j) {
+	Ci[j].reset(C[j].nmax(),C[j].lmax());
+	Ci[j].reset();
+      }
+      Ct[omp_get_thread_num()] = Ci;
+      CBlock<T>::AddCoeffs(SYM,n,m,x,y,Ci);
+    }
+    for(int t=0; t!=nt; ++t) if(Ct[t]) {
+      for(int j=0; j!=m; ++j)
+	C[j].add(Ct[t][j],SYM);
+      falcON_DEL_A(Ct[t]);
+    }
+    falcON_DEL_A(Ct);
+    return;
+  }
+#endif
   CBlock<T>::AddCoeffs(SYM,n,m,x,y,C);
 }
 //------------------------------------------------------------------------------
@@ -2757,8 +2815,11 @@ void PotExp::SetPotential(Anlm const       &C,      // I: C_nlm coefficients
   CHECKMISMATCH("SetPotential",C);
   setAL(AL);
   setR0(R0);
-  PBlock<T> B4(C);
-  B4.AddPotential(SYM,n,x,p,f,add);
+#pragma omp parallel
+  {
+    PBlock<T> B4(C);
+    B4.AddPotential(SYM,n,x,p,f,add);
+  }
 }
 //------------------------------------------------------------------------------
 template void PotExp::
@@ -840,15 +840,15 @@ void bodies::reset(char, fieldbit f, void*D) falcON_THROWING
 {
   if(!C_FORTRAN || !FIRST || BLOCK[0] != FIRST)
     falcON_THROW("bodies::reset() called from wrongly initialized bodies");
-  if(D) {
-    char* DATA = static_cast<char*>(D);
-    BITS |= fieldset(f);
-    for(bodytype t; t; ++t)
-      if( TYPES[t] && t.allows(f) ) {
-	TYPES[t]->set_data_void(f,DATA);
-	DATA += falcON::size(f) * TYPES[t]->NALL;
-      }
-  }
+  // the data are external: simply (re-)set or clear the pointers
+  char* DATA = static_cast<char*>(D);
+  if(D) BITS |= fieldset(f);
+  else  BITS -= fieldset(f);
+  for(bodytype t; t; ++t)
+    if( TYPES[t] && t.allows(f) ) {
+      TYPES[t]->DATA[value(f)] = DATA;
+      if(DATA) DATA += falcON::size(f) * TYPES[t]->NALL;
+    }
 }
 //
 void bodies::swap_bytes(fieldbit f) falcON_THROWING
@@ -34,6 +34,7 @@ namespace {
   }     *BODIES = 0;
   forces*FALCON = 0;
   bool   BUILT  = 0;
+  int    REUSED = 0;                               // # reuse() since last grow()
   //===========================================================================#
   // auxiliary routines                                                        |
   //===========================================================================#
@@ -124,6 +125,46 @@ namespace {
 			real(G),
 			TH<0? const_theta : theta_of_M);
     BUILT   = false;
+    REUSED  = 0;
+  }
+  //===========================================================================#
+  // re-register the external arrays: the tree and all settings are kept       |
+  inline void __falcON_reset_arrays(int *F,
+				    real*M,
+				    real*X,
+				    real*E,
+				    real*A,
+				    real*P,
+				    real*R)
+  {
+    __falcON_error("falcON_reset_arrays");
+    if(E==0 && FALCON->use_individual_eps())
+      falcON_Error("falcON_reset_arrays(): individual softening "
+		   "but no eps_i given\n");
+    BODIES->reset(fieldbit::f,F);
+    BODIES->reset(fieldbit::m,M);
+    BODIES->reset(fieldbit::x,X);
+    BODIES->reset(fieldbit::e,E);
+    BODIES->reset(fieldbit::a,A);
+    BODIES->reset(fieldbit::p,P);
+    BODIES->reset(fieldbit::r,R);
+  }
+  //===========================================================================#
+  // grow or re-use the tree, then approximate gravity for active bodies       |
+  inline int __falcON_gravity(int Ncrit, int Nreuse)
+  {
+    __falcON_error("falcON_gravity");
+    int grown = !BUILT || REUSED >= Nreuse;
+    if(grown) {
+      FALCON->grow(Ncrit);
+      BUILT  = true;
+      REUSED = 0;
+    } else {
+      FALCON->reuse();
+      ++REUSED;
+    }
+    FALCON->approximate_gravity();
+    return grown;
   }
   //===========================================================================#
   typedef unsigned elem_pair[2];
@@ -217,6 +258,33 @@ extern "C" {
     __falcON_initialize(F,M,X,E,A,P,R,*Nt,*Ns,*EPS,*TH,*K,*G);
   }
   //===========================================================================#
+  void falcON_reset_arrays(const int *F,
+			   const real*M,
+			   const real*X,
+			   const real*E,
+			   real      *A,
+			   real      *P,
+			   real      *R)
+  {
+    __falcON_reset_arrays(const_cast<int *>(F),
+			  const_cast<real*>(M),
+			  const_cast<real*>(X),
+			  const_cast<real*>(E),
+			  A,P,R);
+  }
+  //----------------------------------------------------------------------------
+  void falcon_reset_arrays_ (int *F, real*M, real*X, real*E,
+			     real*A, real*P, real*R)
+  {
+    __falcON_reset_arrays(F,M,X,E,A,P,R);
+  }
+  //----------------------------------------------------------------------------
+  void falcon_reset_arrays__(int *F, real*M, real*X, real*E,
+			     real*A, real*P, real*R)
+  {
+    __falcON_reset_arrays(F,M,X,E,A,P,R);
+  }
+  //===========================================================================#
   void falcON_resetsoftening(real EPS, int K)
   {
     if(__falcON_warning("falcON_resetsoftening")) return;
@@ -260,6 +328,7 @@ extern "C" {
     if(BODIES) falcON_DEL_O(BODIES);
     BODIES = 0;
     BUILT  = 0;
+    REUSED = 0;
   }
   //----------------------------------------------------------------------------
   void falcon_clearup_()
@@ -269,6 +338,7 @@ extern "C" {
     if(BODIES) falcON_DEL_O(BODIES);
     BODIES = 0;
     BUILT  = 0;
+    REUSED = 0;
   }
   //----------------------------------------------------------------------------
   void falcon_clearup__()
@@ -278,27 +348,31 @@ extern "C" {
     if(BODIES) falcON_DEL_O(BODIES);
     BODIES = 0;
     BUILT  = 0;
+    REUSED = 0;
   }
   //===========================================================================#
   void falcON_grow(int Nc)
   {
     __falcON_error("falcON_grow");
     FALCON->grow(Nc);
-    BUILT = true;
+    BUILT  = true;
+    REUSED = 0;
   }
   //----------------------------------------------------------------------------
   void falcon_grow_(int *Nc)
   {
     __falcON_error("falcon_grow");
     FALCON->grow(*Nc);
-    BUILT = true;
+    BUILT  = true;
+    REUSED = 0;
   }
   //----------------------------------------------------------------------------
   void falcon_grow__(int *Nc)
   {
     __falcON_error("falcon_grow");
     FALCON->grow(*Nc);
-    BUILT = true;
+    BUILT  = true;
+    REUSED = 0;
   }
   //===========================================================================#
   void falcON_reuse()
@@ -309,9 +383,12 @@ extern "C" {
 		     " called before a tree has been grown\n"
 		     "   I will grow the tree (via falcON_grow()) instead\n");
       FALCON->grow();
-      BUILT = true;
-    } else
+      BUILT  = true;
+      REUSED = 0;
+    } else {
       FALCON->reuse();
+      ++REUSED;
+    }
   }
   //----------------------------------------------------------------------------
   void falcon_reuse_()
@@ -322,9 +399,12 @@ extern "C" {
 		     " called before a tree has been grown\n"
 		     "   I will grow the tree (via falcON_grow()) instead\n");
       FALCON->grow();
-      BUILT = true;
-    } else
+      BUILT  = true;
+      REUSED = 0;
+    } else {
       FALCON->reuse();
+      ++REUSED;
+    }
   }
   //----------------------------------------------------------------------------
   void falcon_reuse__()
@@ -335,9 +415,12 @@ extern "C" {
 		     " called before a tree has been grown\n"
 		     "   I will grow the tree (via falcON_grow()) instead\n");
       FALCON->grow();
-      BUILT = true;
-    } else
+      BUILT  = true;
+      REUSED = 0;
+    } else {
       FALCON->reuse();
+      ++REUSED;
+    }
   }
   //===========================================================================#
   void falcON_approx_grav()
@@ -360,6 +443,21 @@ extern "C" {
     __falcON_grown("falcon_approx_gravity");
     FALCON->approximate_gravity();
   }  
+  //===========================================================================#
+  int falcON_gravity(int Nc, int Nr)
+  {
+    return __falcON_gravity(Nc,Nr);
+  }
+  //----------------------------------------------------------------------------
+  int falcon_gravity_(int*Nc, int*Nr)
+  {
+    return __falcON_gravity(*Nc,*Nr);
+  }
+  //----------------------------------------------------------------------------
+  int falcon_gravity__(int*Nc, int*Nr)
+  {
+    return __falcON_gravity(*Nc,*Nr);
+  }
 #ifdef falcON_ADAP
   //===========================================================================#
   void falcON_adjust_epsi_and_approx_grav(real Nsoft, int Nref, real fac)
@@ -33,6 +33,9 @@
 #include <public/interact.h>
 #include <public/kernel.h>
 #include <numerics.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 using namespace falcON;
 ////////////////////////////////////////////////////////////////////////////////
@@ -441,6 +444,10 @@ namespace {
       eval_grav(C,TaylorSeries(cofm(C)));          // start recursion           
     }
     //--------------------------------------------------------------------------
+    void flush() const {                           // finish interactions       
+      flush_buffers();
+    }
+    //--------------------------------------------------------------------------
     void set_sink(real e, real f)
     {
       reset_eps(e);
@@ -568,6 +575,10 @@ namespace {
       eval_grav_all(C,TaylorSeries(cofm(C)));      // start recursion           
     }
     //--------------------------------------------------------------------------
+    void flush() const {                           // finish interactions       
+      flush_buffers();
+    }
+    //--------------------------------------------------------------------------
     void set_sink(real e, real f)
     {
       reset_eps(e);
@@ -977,6 +988,165 @@ void GravEstimator::exact(bool       al
 #endif
   TREE->mark_grav_usage();
 }
+#ifdef _OPENMP
+//------------------------------------------------------------------------------
+namespace {
+  using namespace grav;
+  const unsigned Nmin_parallel = 4096;             // min # leafs for threads   
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                            
+  // class CoarseIact<IACT>                                                     
+  //                                                                            
+  // performs the tasks of GravEstimator::parallel_iact<>() for one thread,    
+  // which has its own interactor (with its own pool of Taylor coefficients,   
+  // its own buffers of blocked interactions and its own statistics) and its   
+  // own MutualInteractor (with its own interaction stacks). Sinks are treated 
+  // as in the serial code of GravEstimator::approx().                         
+  //                                                                            
+  // After each task, the buffers of blocked interactions are flushed, since   
+  // the nodes involved may be updated by another thread in the next round.    
+  //                                                                            
+  //////////////////////////////////////////////////////////////////////////////
+  template<typename IACT> class CoarseIact {
+    typedef MutualTasks<IACT> tasks;
+    IACT                         &GK;              // gravity interactor        
+    const MutualInteractor<IACT> &MI;              // mutual interactor         
+    const tasks                  &T;               // coarse nodes & tasks      
+    const bool                    ALL;             // all are active?           
+    const real                    EPS,EPSSINK,FSINK;
+    //--------------------------------------------------------------------------
+    void leaf_leaf(leaf_iter const&A, leaf_iter const&B) const {
+      if(is_sink(A) || is_sink(B)) {               // IF either is sink         
+	GK.set_sink(EPSSINK,FSINK);                //   switch to sink          
+	GK.interact(A,B);                          //   interaction A,B         
+	GK.unset_sink(EPS);                        //   switch back             
+      } else                                       // ELSE                      
+	GK.interact(A,B);                          //   interaction A,B         
+    }
+    //--------------------------------------------------------------------------
+    void cell_leaf(cell_iter const&A, leaf_iter const&B) const {
+      if(!ALL && !is_active(A) && !is_active(B))   // no interaction -> DONE    
+	return;
+      if(is_sink(B)) {                             // IF B is sink              
+	GK.set_sink(EPSSINK,FSINK);                //   switch to sink          
+	if(ALL) MI.cell_leaf(A,B);                 //   interaction A,B         
+	else    GK.direct_summation(A,B);          //   interact by direct      
+	GK.unset_sink(EPS);                        //   switch back             
+      } else                                       // ELSE                      
+	MI.cell_leaf(A,B);                         //   interaction A,B         
+    }
+    //--------------------------------------------------------------------------
+  public:
+    CoarseIact(IACT                        &gk,
+	       MutualInteractor<IACT> const&mi,
+	       tasks                  const&t,
+	       bool al, real e, real es, real fs)
+      : GK(gk), MI(mi), T(t), ALL(al), EPS(e), EPSSINK(es), FSINK(fs) {}
+    //--------------------------------------------------------------------------
+    // self-interaction of coarse node i                                        
+    void self(unsigned i) const {
+      if(i < T.N_cells()) {                        // IF cell                   
+	if(ALL || is_active(T.cell(i)))            //   IF active               
+	  MI.cell_self(T.cell(i));                 //     self-iaction          
+      } else {                                     // ELSE: leaf group          
+	cell_iter const&G = T.group(i-T.N_cells());
+	LoopLeafKids(cell_iter,G,A)                //   LOOP leafs A            
+	  LoopLeafSecd(cell_iter,G,A+1,B)          //     LOOP leafs B>A        
+	    leaf_leaf(A,B);                        //       interaction A,B     
+      }                                            // ENDIF                     
+      GK.flush();
+    }
+    //--------------------------------------------------------------------------
+    // mutual interaction of coarse nodes i < j                                 
+    void pair(unsigned i, unsigned j) const {
+      const unsigned nc = T.N_cells();
+      if(j < nc) {                                 // IF cell-cell              
+	if(ALL || is_active(T.cell(i)) || is_active(T.cell(j)))
+	  MI.cell_cell(T.cell(i),T.cell(j));       //   interaction i,j         
+      } else if(i < nc) {                          // ELIF cell-group           
+	cell_iter const&G = T.group(j-nc);
+	LoopLeafKids(cell_iter,G,B)                //   LOOP leafs B in j       
+	  cell_leaf(T.cell(i),B);                  //     interaction i,B       
+      } else {                                     // ELSE group-group          
+	cell_iter const&G = T.group(i-nc), &H = T.group(j-nc);
+	LoopLeafKids(cell_iter,G,A)                //   LOOP leafs A in i       
+	  LoopLeafKids(cell_iter,H,B)              //     LOOP leafs B in j     
+	    leaf_leaf(A,B);                        //       interaction A,B     
+      }                                            // ENDIF                     
+      GK.flush();
+    }
+    //--------------------------------------------------------------------------
+    // evaluation phase for coarse node i                                       
+    void evaluate(unsigned i) const {
+      if(i < T.N_cells()) {                        // IF cell                   
+	if(ALL || is_active(T.cell(i)))            //   IF active               
+	  GK.evaluate(T.cell(i));                  //     evaluation phase      
+      } else {                                     // ELSE: leaf group          
+	cell_iter const&G = T.group(i-T.N_cells());
+	LoopLeafKids(cell_iter,G,A)                //   LOOP leafs A            
+	  if(ALL || is_active(A))                  //     IF active             
+	    A->normalize_grav();                   //       evaluation phase    
+      }                                            // ENDIF                     
+    }
+  };
+} // namespace {
+//------------------------------------------------------------------------------
+// The root self-interaction is split into coarse tasks (see MutualTasks<> in   
+// interact.h), which are distributed to the threads dynamically. The tasks of 
+// one round update disjoint sub-trees, hence need no locking; the rounds are  
+// separated by barriers. After all interactions are done, the evaluation      
+// phase is done in parallel over the coarse nodes.                            
+//                                                                              
+// NOTE. A cell receives its Taylor coefficients from the pool of the thread   
+// which first interacts it, but these may be returned to the pool of another  
+// thread in the evaluation phase. This is harmless, since no pool hands out   
+// memory after the interaction phase and all pools outlive the evaluation.    
+//------------------------------------------------------------------------------
+template<typename IACT>
+void GravEstimator::parallel_iact(bool all)
+{
+  const int      nt = omp_get_max_threads();       // # threads                 
+  const unsigned np = 4+Ncsize/nt;                 // pool size per thread      
+  MutualTasks<IACT> T(root(),8*nt);                // cut tree into coarse nodes
+  const int      nn = T.N_nodes();                 // # coarse nodes            
+  const int      nr = T.N_rounds();                // # rounds of pair tasks    
+  const int      nk = T.N_pairs();                 // # pair tasks per round    
+  unsigned       nco= 0, nch= 0;
+#pragma omp parallel
+  {
+    GravStats ST;                                  // statistics of thread      
+    ST.reset(
+#ifdef WRITE_IACTION_INFO
+	     TREE
+#endif
+	     );
+    IACT GK(KERNEL,&ST,EPS,np,INDI_SOFT,DIR);      // gravity kernel of thread  
+    MutualInteractor<IACT> MI(&GK,TREE->depth()-1);// mutual interactor         
+    CoarseIact<IACT> CI(GK,MI,T,all,EPS,EPSSINK,FSINK);
+#pragma omp for schedule(dynamic,1)
+    for(int i=0; i<nn; ++i)                        // LOOP coarse nodes         
+      CI.self(i);                                  //   self-iaction            
+    for(int r=0; r<nr; ++r) {                      // LOOP rounds               
+#pragma omp for schedule(dynamic,1)
+      for(int k=0; k<nk; ++k) {                    //   LOOP pairs of round     
+	unsigned i,j;
+	if(T.pair(r,k,i,j)) CI.pair(i,j);          //     mutual iaction        
+      }                                            //   END LOOP (barrier)      
+    }                                              // END LOOP                  
+#pragma omp for schedule(dynamic,1)
+    for(int i=0; i<nn; ++i)                        // LOOP coarse nodes         
+      CI.evaluate(i);                              //   evaluation phase        
+#pragma omp critical (GravEstimator_parallel_iact)
+    {
+      STATS->add(ST);                              // add statistics            
+      nco += GK.coeffs_used();                     // add # coeffs used         
+      nch += GK.chunks_used();                     // add # chunks used         
+    }
+  }
+  Ncoeffs = nco;                                   // remember # coeffs used    
+  Nchunks = nch;                                   // remember # chunks used    
+}
+#endif // _OPENMP
 //------------------------------------------------------------------------------
 void GravEstimator::approx(const GravMAC*GMAC,
 			   bool          al
@@ -1017,6 +1187,13 @@ void GravEstimator::approx(const GravMAC*GMAC,
 #endif
                );
   Ncsize = 4+(all? TREE->N_cells() : N_active_cells())/16;
+#ifdef _OPENMP
+  if(omp_get_max_threads() > 1 && !omp_in_parallel() &&
+     TREE->N_leafs() > Nmin_parallel) {
+    if(all) parallel_iact<GravIactAll>(1);         // IF(threads) all active    
+    else    parallel_iact<GravIact>   (0);         // IF(threads) some active   
+  } else
+#endif
   if(all) {                                        // IF all are active         
     GravIactAll GK(KERNEL,STATS,EPS,Ncsize,INDI_SOFT,DIR);
                                                    //   init gravity kernel     
@@ -309,10 +309,32 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 // D_n = (-1/r d/dr)^n g(r) at r=|R|                                            
 //                                                                              
 //==============================================================================
+//==============================================================================
+//                                                                              
+// The DSINGL macros are only used in the _dblock_*() functions below, which   
+// gcc compiles for several architectures, see falcON_KERNEL_CLONES. For their 
+// loops to be vectorized, sqrt() must not set errno (kernel.cc is compiled   
+// with -fno-math-errno, see makepub) and must be inlined, hence DSQRT().      
+//                                                                              
+//==============================================================================
+#if defined(__GNUC__) && __GNUC__ >= 6 && !defined(__clang__) &&	\
+   !defined(__INTEL_COMPILER) && defined(__x86_64__) && defined(__linux__)
+#  define falcON_KERNEL_CLONES						\
+  __attribute__((target_clones("arch=skylake-avx512","arch=haswell","default"),\
+		 optimize("tree-vectorize","vect-cost-model=dynamic")))
+#  ifdef falcON_REAL_IS_FLOAT
+#    define DSQRT(X) __builtin_sqrtf(X)
+#  else
+#    define DSQRT(X) __builtin_sqrt(X)
+#  endif
+#else
+#  define falcON_KERNEL_CLONES
+#  define DSQRT(X) sqrt(X)
+#endif
 # define DSINGL_P0_G				\
   register real					\
   XX  = one/D1;					\
-  D0 *= sqrt(XX);				\
+  D0 *= DSQRT(XX);				\
   D1  = XX * D0;
 # define DSINGL_P0_I				\
   DSINGL_P0_G
@@ -320,7 +342,7 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 # define DSINGL_P1_G				\
   register real					\
   XX  = one/D1;					\
-  D0 *= sqrt(XX);				\
+  D0 *= DSQRT(XX);				\
   D1  = XX * D0;				\
   XX *= 3  * D1;          /* XX == T2 */	\
   D0 += HQ * D1;				\
@@ -332,7 +354,7 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 # define DSINGL_P2_G				\
   register real					\
   XX  = one/D1;					\
-  D0 *= sqrt(XX);				\
+  D0 *= DSQRT(XX);				\
   D1  = XX * D0;				\
   register real					\
   D2  = 3 * XX * D1;				\
@@ -346,7 +368,7 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 # define DSINGL_P3_G				\
   register real					\
   XX  = one/D1;					\
-  D0 *= sqrt(XX);				\
+  D0 *= DSQRT(XX);				\
   D1  =     XX * D0;				\
   register real					\
   D2  = 3 * XX * D1;				\
@@ -369,6 +391,15 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 //                                                                              
 // we have to take care for active and non-active                               
 //                                                                              
+// The interactions of the left leaf with the right leafs are done in blocks   
+// of up to NBLK: the right leafs are loaded, then the kernel is evaluated for 
+// the whole block by a function _dblock_*(), and finally the results are put. 
+// Only the loading and putting involves leaf data, such that the compiler can 
+// vectorize the evaluation of the kernel. With gcc on x86-64, the _dblock_*() 
+// functions are compiled for AVX-512 (16 floats or 8 doubles at a time), for  
+// AVX2 (8 floats or 4 doubles) and for the default architecture, and the      
+// version appropriate for the cpu is chosen at run time.                      
+//                                                                              
 //==============================================================================
 //                                                                              
 // These macros assume:                                                         
@@ -377,75 +408,95 @@ void GravKernAll::single(leaf_iter const &A, leaf_iter const&B) const
 // - real    M0     mass of left leaf                                           
 // - vect    F0     force for left leaf (if used)                               
 // - real    P0     potential for left leaf (if used)                           
-// - vect    dR     to be filled with  X0-X_j                                   
-// - real    D0     to be filled with  M0*M_j                                   
-// - real    D1     to be filled with  norm(dR[J])+eps^2  on loading            
+// - vect    dR[n]  to be filled with  X0-X_j                                   
+// - real    D0[n]  to be filled with  M0*M_j                                   
+// - real    D1[n]  to be filled with  norm(dR[n])+eps^2  on loading           
+// - real    Eq[n]  to be filled with  eps^2   for individual softening         
 //                                                                              
 //==============================================================================
 #define LOAD_G					\
-  dR = X0 - cofm(B);				\
-  D1 = norm(dR) + EQ;				\
-  D0 = M0 * mass(B);
+  dR[n] = X0 - cofm(B);				\
+  D1[n] = norm(dR[n]) + EQ;			\
+  D0[n] = M0 * mass(B);
 //------------------------------------------------------------------------------
 #define LOAD_I					\
-  dR = X0 - cofm(B);				\
-  EQ = square(E0+eph(B));			\
-  D1 = norm(dR) + EQ;				\
-  D0 = M0 * mass(B);
+  dR[n] = X0 - cofm(B);				\
+  EQ    = square(E0+eph(B));			\
+  Eq[n] = EQ;					\
+  D1[n] = norm(dR[n]) + EQ;			\
+  D0[n] = M0 * mass(B);
 //------------------------------------------------------------------------------
 #define PUT_LEFT				\
-  dR *= D1;					\
-  P0 -= D0;					\
-  F0 -= dR;
+  dR[n] *= D1[n];				\
+  P0    -= D0[n];				\
+  F0    -= dR[n];
 //------------------------------------------------------------------------------
 #define PUT_RGHT				\
-  dR       *= D1;				\
-  B->pot() -= D0;				\
-  B->acc() += dR;
+  dR[n]    *= D1[n];				\
+  B->pot() -= D0[n];				\
+  B->acc() += dR[n];
 //------------------------------------------------------------------------------
 #define PUT_BOTH				\
-  dR       *= D1;				\
-  P0       -= D0;				\
-  F0       -= dR;				\
-  B->pot() -= D0;				\
-  B->acc() += dR;
+  dR[n]    *= D1[n];				\
+  P0       -= D0[n];				\
+  F0       -= dR[n];				\
+  B->pot() -= D0[n];				\
+  B->acc() += dR[n];
 //------------------------------------------------------------------------------
 #define PUT_SOME				\
-  dR *= D1;					\
-  P0 -= D0;					\
-  F0 -= dR;					\
+  dR[n] *= D1[n];				\
+  P0    -= D0[n];				\
+  F0    -= dR[n];				\
   if(is_active(B)) {				\
-    B->pot() -= D0;				\
-    B->acc() += dR;				\
+    B->pot() -= D0[n];				\
+    B->acc() += dR[n];				\
   }
 //------------------------------------------------------------------------------
-#define GRAV_ALL(LOAD,DSINGL,PUT)		\
-for(register leaf_iter B=B0; B!=BN; ++B) {	\
-  LOAD						\
-  DSINGL					\
-  PUT						\
-} 
-//------------------------------------------------------------------------------
-#define GRAV_FEW(LOAD,DSINGL)			\
-for(register leaf_iter B=B0; B!=BN; ++B)	\
-  if(is_active(B)) {				\
+#define GRAV_ALL(LOAD,BLOCK,PUT)		\
+for(leaf_iter Bi=B0; Bi!=BN; ) {		\
+  leaf_iter B=Bi;				\
+  int n=0, N;					\
+  for(; B!=BN && n!=NBLK; ++B,++n) {		\
     LOAD					\
-    DSINGL					\
+  }						\
+  BLOCK(N=n,D0,D1,Eq,HQ,QQ);			\
+  for(B=Bi,n=0; n!=N; ++B,++n) {		\
+    PUT						\
+  }						\
+  Bi = B;					\
+}
+//------------------------------------------------------------------------------
+#define GRAV_FEW(LOAD,BLOCK)			\
+for(leaf_iter Bi=B0; Bi!=BN; ) {		\
+  leaf_iter Bl[NBLK];				\
+  int n=0, N;					\
+  for(; Bi!=BN && n!=NBLK; ++Bi)		\
+    if(is_active(Bi)) {				\
+      const leaf_iter&B=Bi;			\
+      LOAD					\
+      Bl[n++] = Bi;				\
+    }						\
+  BLOCK(N=n,D0,D1,Eq,HQ,QQ);			\
+  for(n=0; n!=N; ++n) {				\
+    const leaf_iter&B=Bl[n];			\
     PUT_RGHT					\
-  } 
+  }						\
+}
 //------------------------------------------------------------------------------
 #define START_G					\
   const    real      M0=mass(A);		\
   const    vect      X0=cofm(A);		\
-           vect      dR;			\
-  register real      D0,D1;
+           vect      dR[NBLK];			\
+           real      D0[NBLK],D1[NBLK];		\
+           real     *Eq=0;
 //------------------------------------------------------------------------------
 #define START_I					\
   const    real      E0=eph(A);			\
   const    real      M0=mass(A);		\
   const    vect      X0=cofm(A);		\
-           vect      dR;			\
-  register real      D0,D1;
+           vect      dR[NBLK];			\
+           real      D0[NBLK],D1[NBLK];		\
+           real      Eq[NBLK];
 //==============================================================================
 // now defining auxiliary inline functions for the computation of  N            
 // interactions. There are the following 10 cases:                              
@@ -454,30 +505,68 @@ for(register leaf_iter B=B0; B!=BN; ++B)	\
 //==============================================================================
 namespace {
   using namespace falcON; using namespace falcON::grav;
+  const int NBLK = 32;                             // max # interactions/block  
+  //////////////////////////////////////////////////////////////////////////////
+  // kernel evaluation for a block of n interactions, see DSINGL_* above       
+  //////////////////////////////////////////////////////////////////////////////
+#define DBLOCK_G(NAME,DSINGL,HQ_,QQ_)				\
+  falcON_KERNEL_CLONES						\
+  void NAME(int n, real*d0, real*d1, const real*,		\
+	    real HQ_, real QQ_)					\
+  {								\
+    for(int j=0; j!=n; ++j) {					\
+      register real D0=d0[j], D1=d1[j];				\
+      DSINGL							\
+      d0[j] = D0;						\
+      d1[j] = D1;						\
+    }								\
+  }
+#define DBLOCK_I(NAME,DSINGL,DECL)				\
+  falcON_KERNEL_CLONES						\
+  void NAME(int n, real*d0, real*d1, const real*eq,		\
+	    real, real)						\
+  {								\
+    for(int j=0; j!=n; ++j) {					\
+      register real D0=d0[j], D1=d1[j], EQ=eq[j];		\
+      register real DECL;					\
+      DSINGL							\
+      d0[j] = D0;						\
+      d1[j] = D1;						\
+    }								\
+  }
+  DBLOCK_G(_dblock_p0,  DSINGL_P0_G,  ,  )
+  DBLOCK_G(_dblock_p1_g,DSINGL_P1_G,HQ,  )
+  DBLOCK_G(_dblock_p2_g,DSINGL_P2_G,HQ,  )
+  DBLOCK_G(_dblock_p3_g,DSINGL_P3_G,HQ,QQ)
+  DBLOCK_I(_dblock_p1_i,DSINGL_P1_I,HQ)
+  DBLOCK_I(_dblock_p2_i,DSINGL_P2_I,HQ)
+  DBLOCK_I(_dblock_p3_i,DSINGL_P3_I,HQ; register real QQ)
+#undef DBLOCK_G
+#undef DBLOCK_I
   //////////////////////////////////////////////////////////////////////////////
-#define DIRECT(START,LOAD,DSINGL)				\
+#define DIRECT(START,LOAD,BLOCK)				\
     static void many_YA(ARGS) {					\
       START; register real P0(zero); vect F0(zero);		\
-      GRAV_ALL(LOAD,DSINGL,PUT_BOTH)				\
+      GRAV_ALL(LOAD,BLOCK,PUT_BOTH)				\
       A->pot()+=P0;  A->acc()+=F0;				\
     }								\
     static void many_YS(ARGS) {					\
       START; register real P0(zero); vect F0(zero);		\
-      GRAV_ALL(LOAD,DSINGL,PUT_SOME)				\
+      GRAV_ALL(LOAD,BLOCK,PUT_SOME)				\
       A->pot()+=P0; A->acc()+=F0;				\
     }								\
     static void many_YN(ARGS) {					\
       START; register real P0(zero); vect F0(zero);		\
-      GRAV_ALL(LOAD,DSINGL,PUT_LEFT)				\
+      GRAV_ALL(LOAD,BLOCK,PUT_LEFT)				\
       A->pot()+=P0; A->acc()+=F0;				\
     }								\
     static void many_NA(ARGS) {					\
       START;							\
-      GRAV_ALL(LOAD,DSINGL,PUT_RGHT)				\
+      GRAV_ALL(LOAD,BLOCK,PUT_RGHT)				\
     }								\
     static void many_NS(ARGS) {					\
       START;							\
-      GRAV_FEW(LOAD,DSINGL)					\
+      GRAV_FEW(LOAD,BLOCK)					\
     }
   //////////////////////////////////////////////////////////////////////////////
   template<kern_type, bool> struct _direct;
@@ -486,48 +575,34 @@ namespace {
   leaf_iter const&A,				\
   leaf_iter const&B0,				\
   leaf_iter const&BN,				\
-  real&EQ, real&, real& 
+  real&EQ, real&HQ, real&QQ 
 
   template<> struct _direct<p0,0> {
-    DIRECT(START_G,LOAD_G,DSINGL_P0_G);
+    DIRECT(START_G,LOAD_G,_dblock_p0);
   };
   template<> struct _direct<p0,1> {
-    DIRECT(START_I,LOAD_I,DSINGL_P0_I);
+    DIRECT(START_I,LOAD_I,_dblock_p0);
   };
   //----------------------------------------------------------------------------
-#undef  ARGS
-#define ARGS					\
-  leaf_iter const&A,				\
-  leaf_iter const&B0,				\
-  leaf_iter const&BN,				\
-  real&EQ, real&HQ, real& 
-
   template<> struct _direct<p1,0> {
-    DIRECT(START_G,LOAD_G,DSINGL_P1_G);
+    DIRECT(START_G,LOAD_G,_dblock_p1_g);
   };
   template<> struct _direct<p1,1> {
-    DIRECT(START_I,LOAD_I,DSINGL_P1_I);
+    DIRECT(START_I,LOAD_I,_dblock_p1_i);
   };
   //----------------------------------------------------------------------------
   template<> struct _direct<p2,0> {
-    DIRECT(START_G,LOAD_G,DSINGL_P2_G);
+    DIRECT(START_G,LOAD_G,_dblock_p2_g);
   };
   template<> struct _direct<p2,1> {
-    DIRECT(START_I,LOAD_I,DSINGL_P2_I);
+    DIRECT(START_I,LOAD_I,_dblock_p2_i);
   };
   //----------------------------------------------------------------------------
-#undef  ARGS
-#define ARGS					\
-  leaf_iter const&A,				\
-  leaf_iter const&B0,				\
-  leaf_iter const&BN,				\
-  real&EQ, real&HQ, real&QQ 
-
   template<> struct _direct<p3,0> {
-    DIRECT(START_G,LOAD_G,DSINGL_P3_G);
+    DIRECT(START_G,LOAD_G,_dblock_p3_g);
   };
   template<> struct _direct<p3,1> {
-    DIRECT(START_I,LOAD_I,DSINGL_P3_I);
+    DIRECT(START_I,LOAD_I,_dblock_p3_i);
   };
 #undef LOAD_G
 #undef LOAD_I
@@ -158,6 +158,25 @@ namespace {
 	b. template datum<TYPE>() += real(dt[level(b)]) * const_datum<DERIV>(b);
   }
   //----------------------------------------------------------------------------
+  template<int TYPE, int DERIV>
+  inline void move_list_i(const bodies*B, const double*dt,
+			  const bodies::index*A, unsigned n) {
+    for(unsigned i=0; i!=n; ++i) {
+      body b = B->bodyIn(A[i]);
+      b. template datum<TYPE>() += real(dt[level(b)]) * const_datum<DERIV>(b);
+    }
+  }
+  //----------------------------------------------------------------------------
+  template<int TYPE, int DERIV>
+  inline void move_slist_i(const bodies*B, const double*dt,
+			   const bodies::index*A, unsigned n) {
+    for(unsigned i=0; i!=n; ++i) {
+      body b = B->bodyIn(A[i]);
+      if(is_sph(b))
+	b. template datum<TYPE>() += real(dt[level(b)]) * const_datum<DERIV>(b);
+    }
+  }
+  //----------------------------------------------------------------------------
   template<int TYPE, int COPY>
   inline void copy_all(const bodies*B, bool all) {
     if(all)
@@ -177,6 +196,23 @@ namespace {
       LoopSPHBodies(B,b) if(is_active(b))
 	b. template datum<TYPE>() = const_datum<COPY>(b);
   }
+  //----------------------------------------------------------------------------
+  template<int TYPE, int COPY>
+  inline void copy_list(const bodies*B, const bodies::index*A, unsigned n) {
+    for(unsigned i=0; i!=n; ++i) {
+      body b = B->bodyIn(A[i]);
+      b. template datum<TYPE>() = const_datum<COPY>(b);
+    }
+  }
+  //----------------------------------------------------------------------------
+  template<int TYPE, int COPY>
+  inline void copy_slist(const bodies*B, const bodies::index*A, unsigned n) {
+    for(unsigned i=0; i!=n; ++i) {
+      body b = B->bodyIn(A[i]);
+      if(is_sph(b))
+	b. template datum<TYPE>() = const_datum<COPY>(b);
+    }
+  }
 }
 //------------------------------------------------------------------------------
 void Integrator::drift(double dt, bool all) const
@@ -212,6 +248,17 @@ void Integrator::kick_i(const double*dt, bool all) const
 #endif
 }
 //------------------------------------------------------------------------------
+void Integrator::kick_i(const double*dt, const bodies::index*A, unsigned n)
+  const
+{
+  const snapshot*const&B(SOLVER->snap_shot());
+  if(kickALL & fieldset::v) move_list_i<fieldbit::v,fieldbit::a>(B,dt,A,n);
+#ifdef falcON_SPH
+  if(kickSPH & fieldset::v) move_slist_i<fieldbit::v,fieldbit::a>(B,dt,A,n);
+  if(kickSPH & fieldset::U) move_slist_i<fieldbit::U,fieldbit::I>(B,dt,A,n);
+#endif
+}
+//------------------------------------------------------------------------------
 void Integrator::remember(bool all) const
 {
   const snapshot*const&B(SOLVER->snap_shot());
@@ -222,6 +269,16 @@ void Integrator::remember(bool all) const
 #endif
 }
 //------------------------------------------------------------------------------
+void Integrator::remember(const bodies::index*A, unsigned n) const
+{
+  const snapshot*const&B(SOLVER->snap_shot());
+  if(rembALL & fieldset::u) copy_list<fieldbit::u,fieldbit::v>(B,A,n);
+#ifdef falcON_SPH
+  if(rembSPH & fieldset::V) copy_slist<fieldbit::V,fieldbit::v>(B,A,n);
+  if(rembSPH & fieldset::Y) copy_slist<fieldbit::Y,fieldbit::U>(B,A,n);
+#endif
+}
+//------------------------------------------------------------------------------
 void Integrator::cpu_stats_body(output&to) const
 {
   SOLVER->cpu_stats_body(to);
@@ -287,7 +344,12 @@ LeapFrogCode::LeapFrogCode(int kstep, const ForceAndDiagnose *F,
 }
 //------------------------------------------------------------------------------
 void LeapFrogCode::account_new() const {
-  if(snap_shot()->N_new()) {
+  unsigned nnew = snap_shot()->N_new();
+#ifdef falcON_MPI
+  if(snap_shot()->parallel())                      // forces are collective     
+    COMMUN(Comm(snap_shot()))->AllReduceInPlace<MPI::Sum>(nnew);
+#endif
+  if(nnew) {
     LoopAllBodies(snap_shot(),b) 
       if(is_new(b)) b.flag_as_active();
       else          b.unflag_active ();
@@ -299,6 +361,10 @@ void LeapFrogCode::account_new() const {
 //------------------------------------------------------------------------------
 void LeapFrogCode::fullstep(bool rf) const {
   reset_CPU();                                     // reset cpu timers          
+#ifdef falcON_MPI
+  if(snap_shot()->parallel())                      // IF parallel               
+    snap_shot()->parallel()->decompose();          //   re-distribute bodies    
+#endif
   account_new();                                   // account for new bodies    
   if(rf) set_time_derivs(1,1,0.);                  // re-compute initial forces 
   kick(tauh(0));                                   // eg: v+= a*tau/2           
@@ -327,7 +393,7 @@ void BlockStepCode::elementary_step(int t) const { // I: number of step
 #ifdef falcON_MPI
   if(snap_shot()->parallel())
     COMMUN(snap_shot()->parallel()->Comm())->
-      AllReduceInPlace<MPI::And>(move);
+      AllReduceInPlace<MPI::Or>(move);
 #endif
   if(!move) return;                                // none moving anywhere: DONE
   bool all=true;                                   // are all active?           
@@ -336,20 +402,68 @@ void BlockStepCode::elementary_step(int t) const { // I: number of step
   double dt=tau_min() * m;                         // dt = m*tau_min            
   drift(dt);                                       // predict @ new time        
   m = 0;                                           // reset m = 0               
-  LoopAllBodies(snap_shot(),b)                     // LOOP bodies               
-    if(level(b) >= l) b.flag_as_active();          //   IF(level>=l): active    
-    else              b.unflag_active ();          //   ELSE        : inactive  
+  unsigned na=0;                                   // # active bodies           
+  for(unsigned i=l; i!=Nsteps(); ++i) na += N[i];  // = # bodies in levels >= l 
+  for(unsigned i=0; i!=na; ++i)                    // LOOP active: A[0..na[     
+    snap_shot()->bodyIn(A[i]).flag_as_active();    //   flag as active          
+  for(unsigned i=na; i<NF; ++i)                    // LOOP no longer active     
+    snap_shot()->bodyIn(A[i]).unflag_active();     //   unflag                  
+  NF = na;                                         // remember # flagged        
   set_time_derivs(all,l==0,dt);                    // set accelerations etc     
-  kick_i(tauh(),all);                              // kick velocity etc         
+  if(all) kick_i(tauh(),true);                     // kick velocity etc         
+  else    kick_i(tauh(),A,na);                     //   of active bodies only   
   if(l != highest_level() ||                       // IF(levels may change OR   
      ST->always_adjust() )                         //    always adjusting       
-    adjust_levels(l, l==0);                        //   h -> h'                 
+    adjust_active(l, na);                          //   h -> h'; re-sort A      
   if(l) {                                          // IF not last step          
-    remember(all);                                 //   remember to be predicted
-    kick_i(tauh(),all);                            //   kick by half a step     
+    remember(A,na);                                //   remember to be predicted
+    kick_i(tauh(),A,na);                           //   kick by half a step     
   }                                                // ENDIF                     
 }
 //------------------------------------------------------------------------------
+// sort bodies by level into A[], highest level first, such that the bodies
+// active in an elementary step with lowest moving level l are A[0..na[ with
+// na = sum_{i>=l} N[i]; also (re-)sets N[] and unflags all bodies.
+void BlockStepCode::sort_levels() const {
+  const unsigned n = snap_shot()->N_bodies();
+  if(n > NA) {
+    if(A)  falcON_DEL_A(A);
+    if(AT) falcON_DEL_A(AT);
+    NA = n;
+    A  = falcON_NEW(bodies::index,NA);
+    AT = falcON_NEW(bodies::index,NA);
+  }
+  for(unsigned l=0; l!=Nsteps(); ++l) N[l] = 0;
+  LoopAllBodies(snap_shot(),b) {
+    b.unflag_active();
+    ++(N[level(b)]);
+  }
+  unsigned*C = falcON_NEW(unsigned,Nsteps());
+  for(unsigned l=Nsteps(), o=0; l--; o+=N[l]) C[l] = o;
+  LoopAllBodies(snap_shot(),b)
+    A[C[level(b)]++] = bodies::index(b);
+  falcON_DEL_A(C);
+  NF = 0;
+}
+//------------------------------------------------------------------------------
+// adjust the levels of the active bodies A[0..na[ and re-sort them by level.
+// As their new levels are >= low, A[] remains sorted.
+void BlockStepCode::adjust_active(int low, unsigned na) const {
+  unsigned*C = falcON_NEW(unsigned,Nsteps());
+  for(unsigned l=0; l!=Nsteps(); ++l) C[l] = 0;
+  for(unsigned i=0; i!=na; ++i) {
+    body b = snap_shot()->bodyIn(A[i]);
+    ST->adjust_level(b, N, low, highest_level());
+    ++(C[level(b)]);
+  }
+  for(unsigned l=Nsteps(), o=0, c; l--; o+=c) { c=C[l]; C[l]=o; }
+  for(unsigned i=0; i!=na; ++i)
+    AT[C[level(snap_shot()->bodyIn(A[i]))]++] = A[i];
+  for(unsigned i=0; i!=na; ++i)
+    A[i] = AT[i];
+  falcON_DEL_A(C);
+}
+//------------------------------------------------------------------------------
 inline void BlockStepCode::account_del() const {
   if(snap_shot()->N_del()) {
     for(unsigned l=0; l!=Nsteps(); ++l)
@@ -360,7 +474,12 @@ inline void BlockStepCode::account_del() const {
 }
 //------------------------------------------------------------------------------
 inline void BlockStepCode::account_new() const {
-  if(snap_shot()->N_new()) {
+  unsigned nnew = snap_shot()->N_new();
+#ifdef falcON_MPI
+  if(snap_shot()->parallel())                      // forces are collective     
+    COMMUN(Comm(snap_shot()))->AllReduceInPlace<MPI::Sum>(nnew);
+#endif
+  if(nnew) {
     LoopAllBodies(snap_shot(),b) 
       if(is_new(b)) b.flag_as_active();
       else          b.unflag_active ();
@@ -379,15 +498,6 @@ void BlockStepCode::assign_levels() const {
     ST->assign_level(b, N, highest_level());
 }
 //------------------------------------------------------------------------------
-void BlockStepCode::adjust_levels(int low, bool all) const {
-  if(all)
-    LoopAllBodies(snap_shot(),b)
-      ST->adjust_level(b, N, low, highest_level());
-  else
-    LoopAllBodies(snap_shot(),b) if(is_active(b))
-      ST->adjust_level(b, N, low, highest_level());
-}
-//------------------------------------------------------------------------------
 void BlockStepCode::update_Nlev(const bodies*B) {
   for(unsigned l=0; l!=Nsteps(); ++l) N[l] = 0;
   LoopAllBodies(B,b)
@@ -396,8 +506,13 @@ void BlockStepCode::update_Nlev(const bodies*B) {
 //------------------------------------------------------------------------------
 void BlockStepCode::fullstep(bool rf) const {
   reset_CPU();                                     // reset cpu timers          
+#ifdef falcON_MPI
+  if(snap_shot()->parallel())                      // IF parallel               
+    snap_shot()->parallel()->decompose();          //   re-distribute bodies    
+#endif
   account_new();                                   // account for new bodies    
   account_del();                                   // account for removed bodies
+  sort_levels();                                   // sort bodies by level      
   if(rf) set_time_derivs(1,1,0.);                  // re-compute initial forces 
   remember(true);                                  // remember to be predicted  
   kick_i(tauh(),true);                             // kick by half a step       
@@ -409,6 +524,28 @@ void BlockStepCode::fullstep(bool rf) const {
   add_to_cpu_step();                               // record CPU time           
 }
 //------------------------------------------------------------------------------
+void BlockStepCode::stats_body(output&to) const {
+  SOLVER -> dia_stats_body(to);
+  if(highest_level()) {
+    const unsigned*Nl = N;
+#ifdef falcON_MPI
+    unsigned*Ng = 0;
+    if(snap_shot()->parallel()) {                  // IF parallel: global N[]   
+      Nl = Ng = falcON_NEW(unsigned,Nsteps());
+      COMMUN(Comm(snap_shot()))->Reduce<MPI::Sum>(0,N,Ng,Nsteps());
+    }
+#endif
+    if(to)
+      for(unsigned l=0; l!=Nsteps(); ++l)
+	to<<std::setw(W)<<Nl[l]<<' ';
+#ifdef falcON_MPI
+    if(Ng) falcON_DEL_A(Ng);
+#endif
+  }
+  cpu_stats_body(to);
+  if(to) to<<std::endl;
+}
+//------------------------------------------------------------------------------
 BlockStepCode::BlockStepCode(int      km,          // I: tau_max = 2^-kmax      
 			     unsigned Ns,          // I: #steps                 
 			     const ForceAndDiagnose *F,
@@ -420,7 +557,11 @@ BlockStepCode::BlockStepCode(int      km,          // I: tau_max = 2^-kmax
   bodies::TimeSteps ( km, Ns),
   N                 ( Ns? falcON_NEW(unsigned,Ns) : 0 ),
   W                 ( (kmax()+highest_level())>9? max(5,w) : max(4,w) ),
-  ST                ( S )
+  ST                ( S ),
+  A                 ( 0 ),
+  AT                ( 0 ),
+  NA                ( 0 ),
+  NF                ( 0 )
 {
   snap_shot()->set_steps(this);                    // set time steps in bodies  
   snap_shot()->add_fields(fieldset::l);            // make sure we have levels  
@@ -529,13 +670,17 @@ void NBodyCode::init(const ForceAndDiagnose         *FS,
   DebugInfo(5,"NBodyCode::init(): called ... \n");
   try {
     if(FS->acc_ext()) SHOT->add_fields(fieldset::q);
+    unsigned Nb = SHOT->N_bodies();
+#ifdef falcON_MPI
+    if(SHOT->parallel()) Nb = SHOT->parallel()->N_global();
+#endif
     if(Nlev <= 1 || St == 0)
       CODE = static_cast<const Integrator*>
 	( new LeapFrogCode(kmax,FS,p,k,r,P,K,R) );
     else
       CODE = static_cast<const Integrator*>
 	( new BlockStepCode(kmax,Nlev,FS,St,p,k,r,P,K,R,
-			    int(1+std::log10(double(SHOT->N_bodies())))));
+			    int(1+std::log10(double(Nb)))));
   } catch(falcON::exception E) {
     DebugInfo(2,"NBodyCode::init(): caught error \"%s\"\n",E.what());
     falcON_RETHROW(E);
@@ -878,10 +1023,14 @@ ForceALCON::ForceALCON(snapshot          *s,       // I: snapshot: time & bodies
   _EPS          ( e ),
   _EPSSINK      ( es? es:e ),
   _KERN         ( ke )
-{
 #ifdef falcON_MPI
-  if(SELF_GRAV && MPI::Initialized())
-    falcON_THROW("ForceALCON: cannot (yet) do parallel self-gravity\n");
+  ,THETA        ( abs(th) )
+#endif
+{
+#if defined(falcON_MPI) && defined(falcON_ADAP)
+  if(SELF_GRAV && SOFTENING == individual_adaptive && snap_shot()->parallel())
+    falcON_THROW("ForceALCON: cannot do parallel self-gravity with "
+		 "individual adaptive softening\n");
 #endif
   if(SOFTENING==individual_fixed && !snap_shot()->have(fieldbit::e)) 
     falcON_THROW("ForceALCON: individual fixed softening, but no eps_i given");
@@ -907,6 +1056,45 @@ ForceALCON::ForceALCON(snapshot          *s,       // I: snapshot: time & bodies
 void ForceALCON::set_tree_and_forces(bool all, bool build_tree) const
 {
   clock_t cpu = clock();
+#ifdef falcON_MPI
+  // 0. parallel self-gravity: add the local essential tree to our bodies,
+  //    compute the forces on our (active) bodies, remove the imports again.
+  if(SELF_GRAV && snap_shot()->parallel()) {
+    ParallelSnapshot*P = snap_shot()->parallel();
+    bool*active = 0;
+    bool any    = false;                           // any of ours active?       
+    if(all) {                                      // IF all: make all active   
+      active = falcON_NEW(bool,snap_shot()->N_bodies());
+      unsigned i=0;
+      LoopAllBodies(snap_shot(),b) {
+	active[i++] = is_active(b);
+	b.flag_as_active();
+      }
+      any = snap_shot()->N_bodies() > 0;
+    } else
+      LoopAllBodies(snap_shot(),b)
+	if(is_active(b)) { any = true; break; }
+    P->import_essential(half*THETA,NCRIT);         // add remote sources        
+    if(any) {                                      // IF any of ours active     
+      FALCON.grow(NCRIT,ROOTCENTRE);               //   grow tree (not re-used) 
+      Integrator::record_cpu(cpu,CPU_TREE);        //   record CPU consumption  
+      FALCON.approximate_gravity(false);           //   forces on active ones   
+    }                                              // ENDIF                     
+    P->discard_imports();                          // remove remote sources     
+    if(active) {                                   // IF all: restore flags     
+      unsigned i=0;
+      LoopAllBodies(snap_shot(),b)
+	if(!active[i++]) b.unflag_active();
+      falcON_DEL_A(active);
+    }
+    Integrator::record_cpu(cpu,CPU_GRAV);          // record CPU consumption    
+    if(acc_ext()) {
+      acc_ext() -> set(snap_shot(), all, 2);
+      Integrator::record_cpu(cpu,CPU_AEX);         // record CPU consumption    
+    }
+    return;
+  }
+#endif
   // 1. build tree if required
   if(SELF_GRAV || build_tree) {
     if(REUSED < REUSE) {                           // IF may re-use old tree    
@@ -33,10 +33,14 @@
 // \version 06/11/2007 WD copy flags only if required.
 // \version 20/05/2008 WD added FindLeaf(), ProcessNeighbours()
 // \version 18/03/2009 WD avoid warnings from -Wshadow
+// \version 19/10/2026    added ProcessNearestNeighboursParallel(); batched dist_sq
 //
 ////////////////////////////////////////////////////////////////////////////////
 #include <public/neighbours.h>
 #include <utils/heap.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 using namespace falcON;
 
@@ -310,9 +314,8 @@ namespace {
       return NeighbourSearchBase::inside(LIST->Q,c);
     }
     //--------------------------------------------------------------------------
-    /// updates the list w.r.t. a leaf
-    void add_leaf(const leaf*l) {
-      real q = dist_sq(X,pos(l));
+    /// updates the list w.r.t. a leaf at distance^2 q
+    void add_leaf(const leaf*l, real q) {
       if(LIST->Q > q) {
 	LIST->Q = q;
 	LIST->L = l;
@@ -322,6 +325,27 @@ namespace {
       }
     }
     //--------------------------------------------------------------------------
+    /// updates the list w.r.t. a leaf
+    void add_leaf(const leaf*l) {
+      add_leaf(l,dist_sq(X,pos(l)));
+    }
+    //--------------------------------------------------------------------------
+    /// updates the list w.r.t. a contiguous range of leafs, except L
+    /// \note distances are computed for a batch of leafs in a first, simple
+    ///       loop (which the compiler may vectorize); only those within the
+    ///       current search sphere are considered for the list.
+    void add_leafs(const leaf*l0, const leaf*l1) {
+      const int NB=32;
+      real q[NB];
+      for(; l0<l1; l0+=NB) {
+	const int n = l1-l0 < NB? int(l1-l0) : NB;
+	for(int i=0; i<n; ++i)
+	  q[i] = dist_sq(X,pos(l0+i));
+	for(int i=0; i<n; ++i)
+	  if(LIST->Q > q[i] && l0+i != L) add_leaf(l0+i,q[i]);
+      }
+    }
+    //--------------------------------------------------------------------------
     /// updates the list w.r.t. a cell, recursive
     /// \param Ci cell to be processed
     /// \param cL does Ci contain L?
@@ -330,8 +354,7 @@ namespace {
       if(cC==0 &&
 	 number(Ci) <= (M<=0? NDIR:max(static_cast<unsigned>(M),NDIR))) {
 	// direct loop
-	if(cL) { LoopAllLeafs(TREE,Ci,l) if(l!=L) add_leaf(l); }
-	else   { LoopAllLeafs(TREE,Ci,l) add_leaf(l); }
+	add_leafs(TREE->LeafNo(fcleaf(Ci)),TREE->LeafNo(ncleaf(Ci)));
       } else {
 	// process leaf kids
       	if(nleafs(Ci)) {
@@ -383,10 +406,14 @@ namespace {
     /// \param k number of neighbours
     /// \param n direct-loop control; default: k/4
     /// \param copy_flags if true, body flags will be copied (if present)
-    NearestNeighbourSearch(const OctTree*t, unsigned n, bool copy_flags=0)
+    /// \param setup if false, the leafs have been set up already
+    NearestNeighbourSearch(const OctTree*t, unsigned n, bool copy_flags=0,
+			   bool setup=1)
       : NeighbourSearchBase(t), NDIR(max(1u,n)),
 	BIGQ(12*square(TREE->root_radius())), NIAC(0), LIST(0) 
     {
+      if(!setup)
+	return;
       if(copy_flags && TREE->my_bodies()->have_flag())
 	for(leaf*l=TREE->begin_leafs(); l!=TREE->end_leafs(); ++l) {
 	  l->scalar()=TREE->my_bodies()->mass(mybody(l));
@@ -417,6 +444,39 @@ void falcON::ProcessNearestNeighbours(const OctTree*T, int K,
   Ni = NNS.N_iact();
 }
 // /////////////////////////////////////////////////////////////////////////////
+void falcON::ProcessNearestNeighboursParallel(const OctTree*T, int K,
+					      void(*f)(const bodies*,
+						       const leaf*,
+						       const Neighbour*, int),
+					      unsigned&Ni, bool all)
+  falcON_THROWING
+{
+#ifdef _OPENMP
+  if(omp_get_max_threads() > 1 && !omp_in_parallel()) {
+    NearestNeighbourSearch SETUP(T,K/4,!all);      // set up leafs (serial)     
+    const int Nc = T->N_cells();
+    unsigned  Na = 0;
+#pragma omp parallel reduction(+:Na)
+    {
+      NearestNeighbourSearch NNS(T,K/4,!all,0);    // per-thread search state   
+      Array<Neighbour> E(K);                       // per-thread list           
+#pragma omp for schedule(dynamic,16)
+      for(int ic=0; ic<Nc; ++ic) {
+	const cell*C = T->CellNo(ic);
+	LoopLeafKids(T,C,L) if(all || is_active(L)) {
+	  NNS.make_list(L,C,E.array(),K);
+	  f(T->my_bodies(),L,E.array(),K);
+	}
+      }
+      Na += NNS.N_iact();
+    }
+    Ni = Na;
+    return;
+  }
+#endif
+  ProcessNearestNeighbours(T,K,f,Ni,all);
+}
+// /////////////////////////////////////////////////////////////////////////////
 void falcON::ProcessNearestNeighbours(const OctTree*T, int K,
 				      void(*f)(const Neighbour*, int),
 				      bodies::index i)
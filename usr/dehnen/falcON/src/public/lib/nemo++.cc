@@ -505,8 +505,9 @@ bool falcON::nemo_in::has_snapshot() const
 {
   // added to read any history padded between snapshots (note that gyrfalcON
   // does that upon appending to an existing file when resuming a simulation)
+  if(!STREAM) return false;
   get_history(STREAM);
-  return STREAM && get_tag_ok(STREAM,SnapShotTag);
+  return get_tag_ok(STREAM,SnapShotTag);
 }
 //------------------------------------------------------------------------------
 // class falcON::snap_in
@@ -31,6 +31,11 @@
 #include <memory.h>
 #include <body.h>
 #include <sstream>
+#ifdef _OPENMP
+#  include <vector>
+#  include <algorithm>
+#  include <omp.h>
+#endif
 
 #ifdef  falcON_PROPER
 #  define falcON_track_bug
@@ -270,6 +275,10 @@ namespace {
   public:
     typedef node *node_pter;                       // pointer to node           
     node() {}                                      // default constructor       
+    node&operator=(const node&N) {                 // copy assignment           
+      POS = N.POS;
+      return *this;
+    }
     vect      &pos()       { return POS; }
     vect const&pos() const { return POS; }
   };
@@ -479,6 +488,9 @@ falcON_TRAITS(::dot,"{tree.cc}::dot");
 falcON_TRAITS(::box,"{tree.cc}::box");
 ////////////////////////////////////////////////////////////////////////////////
 namespace {
+#ifdef _OPENMP
+  const size_t Nmin_parallel = 16384;              // min # dots for threads    
+#endif
   //////////////////////////////////////////////////////////////////////////////
   //                                                                          //
   // class falcON::estimate_N_alloc                                           //
@@ -778,6 +790,25 @@ namespace {
       P0->PEANO.set_root();
 #endif
     }
+#ifdef _OPENMP
+    //--------------------------------------------------------------------------
+    // to be called instead of reset() by a helper building parts of the tree  
+    // of M: shares everything but the box allocator (nb boxes initially)      
+    void share(const BoxDotTree*M,                 // I: tree to help building  
+	       size_t           nb)                // I: #boxes initially alloc 
+    {
+      NCRIT    = M->NCRIT;
+      DMAX     = M->DMAX;
+      NDOTS    = M->NDOTS;
+      if(BM) falcON_DEL_O(BM);
+      BM       = new block_alloc<box>(nb);
+      TREE     = M->TREE;
+      RA       = M->RA;
+      P0       = M->P0;
+      D0       = M->D0;
+      DN       = M->DN;
+    }
+#endif
     //--------------------------------------------------------------------------
     ~BoxDotTree()
     {
@@ -964,6 +995,68 @@ namespace {
     dep++;                                         // increment depth           
     return dep;                                    // return cell's depth       
   }
+#ifdef _OPENMP
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                            
+  // class falcON::SubBoxBuilder                                                
+  //                                                                            
+  // for parallel tree-building: builds, for one thread, the box-dot sub-trees 
+  // below some boxes of the box-dot tree of a TreeBuilder. It has its own box 
+  // allocator, but shares everything else with that TreeBuilder. The boxes    
+  // are needed for linking, so the SubBoxBuilder must live until then.       
+  //                                                                            
+  //////////////////////////////////////////////////////////////////////////////
+  class SubBoxBuilder : public BoxDotTree {
+    SubBoxBuilder           (const SubBoxBuilder&);// not implemented           
+    SubBoxBuilder& operator=(const SubBoxBuilder&);// not implemented           
+    //--------------------------------------------------------------------------
+    size_t NADD;                                   // # dots added sofar        
+    size_t NT;                                     // # helpers sharing dots    
+    //--------------------------------------------------------------------------
+  public:
+    SubBoxBuilder() : NADD(0), NT(1) {}
+    //--------------------------------------------------------------------------
+    void reset(const BoxDotTree*M,                 // I: tree to help building  
+	       int               nt)               // I: # helpers              
+    {
+      NADD = 0;
+      NT   = nt;
+      share(M, 1+M->N_dots()/(4*nt));
+    }
+    //--------------------------------------------------------------------------
+    ~SubBoxBuilder() {
+      RA = 0;                                      // RA is not ours to delete  
+    }
+    //--------------------------------------------------------------------------
+    // adds dots [Di,Dn) to an empty (daughter) box B                          
+    void add(box*B, dot*Di, dot*Dn)
+    {
+      for(; Di!=Dn; ++Di,++NADD) {                 // LOOP(dots)                
+	size_t nl = 1+NADD*NT;                     //   estimated # dots added  
+	if(nl >= NDOTS) nl = NDOTS-1;              //   by all helpers sofar    
+	if(NCRIT > 1) adddot_N(B,Di,nl);           //   add dot                 
+	else          adddot_1(B,Di,nl);
+      }                                            // END LOOP                  
+    }
+    //--------------------------------------------------------------------------
+    // links a box made by add() to its pre-allocated cell, see link_cells_N() 
+    int link(const box*P, int o, int k,
+	     OctTree::Cell*C, OctTree::Cell*Cf, OctTree::Leaf*Lf) const
+    {
+      return NCRIT > 1?
+	link_cells_N(P,o,k,C,Cf,Lf) :
+	link_cells_1(P,o,k,C,Cf,Lf) ;
+    }
+#ifdef falcON_track_bug
+    //--------------------------------------------------------------------------
+    void set_ends()
+    {
+      LEND = EndLeaf(TREE);
+      CEND = EndCell(TREE);
+    }
+#endif
+  };
+#endif // _OPENMP
   //////////////////////////////////////////////////////////////////////////////
   //                                                                            
   // class falcON::TreeBuilder                                                  
@@ -981,6 +1074,33 @@ namespace {
     const bool  OUT;                               // # put sink in root only?
     size_t      NOUT;                              // # dots only in root
     vect        XAVE, XMIN, XMAX;                  // extreme positions         
+#ifdef _OPENMP
+    //--------------------------------------------------------------------------
+    // data for parallel building                                               
+    //--------------------------------------------------------------------------
+    struct task {                                  // sub-tree built by helper  
+      box          *B;                             //   its root box            
+      size_t        I0,I1;                         //   its range of sorted dots
+      int           W;                             //   helper having built it  
+      size_t        NB;                            //   # boxes, including B    
+      int           O,K;                           //   octant & peano key of B 
+      OctTree::Cell*C,*Cf;                         //   cell of B, free cells   
+      OctTree::Leaf*Lf;                            //   free leafs              
+    };
+    int                NW;                         // # helpers                 
+    SubBoxBuilder     *WB;                         // helpers, one per thread   
+    int                LT;                         // # levels in dot keys      
+    size_t             NTASK;                      // max # dots per task       
+    unsigned          *KEY;                        // sorted dot keys           
+    std::vector<task>  TASKS;                      // sub-trees built by helpers
+    //--------------------------------------------------------------------------
+    void sort_dots();
+    void split_top(box*, size_t, size_t);
+    void build_parallel();
+    int  link_top(const box*, int, int, OctTree::Cell*,
+		  OctTree::Cell*&, OctTree::Leaf*&, size_t&);
+    int  link_parallel(OctTree::Cell*, OctTree::Cell*, OctTree::Leaf*);
+#endif
     //--------------------------------------------------------------------------
     // This routines returns the root centre nearest to the mean position       
     inline vect root_centre() {
@@ -1039,6 +1159,11 @@ namespace {
       OctTree::Cell*C0 = FstCell(TREE), *Cf=C0+1;
       OctTree::Leaf*Lf = FstLeaf(TREE) + NOUT;
       pacell_(C0) = OctTree::Cell::INVALID;
+#ifdef _OPENMP
+      if(WB)
+	DEPTH = link_parallel(C0,Cf,Lf);
+      else
+#endif
       DEPTH = NCRIT > 1?
 	link_cells_N(P0,0,0,C0,Cf,Lf) :
 	link_cells_1(P0,0,0,C0,Cf,Lf) ;
@@ -1059,6 +1184,17 @@ namespace {
       }
     }
     //--------------------------------------------------------------------------
+    // # boxes, including those of any helpers                                  
+    //--------------------------------------------------------------------------
+    size_t N_boxes() const
+    {
+      size_t n = BoxDotTree::N_boxes();
+#ifdef _OPENMP
+      for(int w=0; w!=NW; ++w) n += WB[w].N_boxes();
+#endif
+      return n;
+    }
+    //--------------------------------------------------------------------------
     // constructors of class TreeBuilder                                        
     //--------------------------------------------------------------------------
     // 1   completely from scratch                                              
@@ -1092,6 +1228,10 @@ namespace {
     //--------------------------------------------------------------------------
     inline ~TreeBuilder()  {
       falcON_DEL_A(D0);
+#ifdef _OPENMP
+      if(WB ) falcON_DEL_A(WB);
+      if(KEY) falcON_DEL_A(KEY);
+#endif
     }
     //--------------------------------------------------------------------------
   };
@@ -1101,6 +1241,11 @@ namespace {
   void TreeBuilder::build()
   {
     report REPORT("TreeBuilder::build()");
+#ifdef _OPENMP
+    if(omp_get_max_threads() > 1 && !omp_in_parallel() &&
+       N_dots()-NOUT > Nmin_parallel)
+      return build_parallel();
+#endif
     size_t nl=0;                                   // counter: # dots added     
     dot   *Di;                                     // actual dot loaded         
     if(Ncrit() > 1)                                // IF(N_crit > 1)            
@@ -1110,6 +1255,260 @@ namespace {
       for(Di=D0+NOUT; Di!=DN; ++Di,++nl)           //   LOOP(dots)              
 	adddot_1(P0,Di,nl);                        //     add dots              
   }
+#ifdef _OPENMP
+  //----------------------------------------------------------------------------
+  // sorts the dots (except root-only dots) by their keys, which encode the
+  // octants of the boxes at levels 1 to LT containing them, so that the dots
+  // of any box at level <= LT are contiguous in memory.
+  // The keys are computed exactly as the boxes' centres and octants in
+  // make_subbox() and adddot_N(), and are sorted by a parallel radix sort of
+  // 10 bits per pass, which is stable, so that the dots of any box remain in
+  // their original order.
+  //----------------------------------------------------------------------------
+  void TreeBuilder::sort_dots()
+  {
+    const int   nb = 10, nd = 1<<nb;               // # bits & digits per pass  
+    const int   n  = DN-D0-NOUT;                   // # dots to be sorted       
+    const int   nt = omp_get_max_threads();        // # threads                 
+    const dot  *D  = D0+NOUT;                      // dots to be sorted         
+    unsigned   *K  = falcON_NEW(unsigned,n);       // keys                      
+    unsigned   *Kt = falcON_NEW(unsigned,n);       // keys, temporary           
+    int        *I  = falcON_NEW(int,n);            // indices                   
+    int        *It = falcON_NEW(int,n);            // indices, temporary        
+    int        *H  = falcON_NEW(int,nt*nd);        // histograms of threads     
+#pragma omp parallel for
+    for(int i=0; i<n; ++i) {                       // LOOP dots                 
+      vect     X = P0->centre();                   //   centre of root box      
+      unsigned k = 0;
+      for(int l=1; l<=LT; ++l) {                   //   LOOP levels             
+	int o = ::octant(X,D[i].pos());            //     octant at level l-1   
+	k = (k<<3) | o;                            //     add to key            
+	real r = RA[l];                            //     centre at level l     
+	if(o&1) X[0] += r;  else  X[0] -= r;
+	if(o&2) X[1] += r;  else  X[1] -= r;
+	if(o&4) X[2] += r;  else  X[2] -= r;
+      }                                            //   END LOOP                
+      K[i] = k;
+      I[i] = i;
+    }                                              // END LOOP                  
+    for(int s=0; s<3*LT; s+=nb) {                  // LOOP radix passes         
+#pragma omp parallel
+      {
+	const int t = omp_get_thread_num();
+	const int m = omp_get_num_threads();
+	const int i0= int((size_t(n)*t)/m), i1= int((size_t(n)*(t+1))/m);
+	int*h = H+t*nd;
+	for(int d=0; d!=nd; ++d) h[d] = 0;         //   count digits of my dots 
+	for(int i=i0; i!=i1; ++i) ++h[(K[i]>>s)&(nd-1)];
+#pragma omp barrier
+#pragma omp single
+	for(int d=0,o=0; d!=nd; ++d)               //   offsets: digit, thread  
+	  for(int u=0; u!=m; ++u) {
+	    int c = H[u*nd+d];
+	    H[u*nd+d] = o;
+	    o += c;
+	  }
+	for(int i=i0; i!=i1; ++i) {                //   scatter my dots         
+	  int j = h[(K[i]>>s)&(nd-1)]++;
+	  Kt[j] = K[i];
+	  It[j] = I[i];
+	}
+      }
+      std::swap(K,Kt);
+      std::swap(I,It);
+    }                                              // END LOOP                  
+    dot*Ds = falcON_NEW(dot,DN-D0);                // sorted dots               
+    for(int i=0; i!=int(NOUT); ++i) Ds[i] = D0[i];
+#pragma omp parallel for
+    for(int i=0; i<n; ++i) Ds[NOUT+i] = D[I[i]];
+    falcON_DEL_A(D0);
+    DN  = Ds + (DN-D0);
+    D0  = Ds;
+    KEY = K;
+    falcON_DEL_A(Kt);
+    falcON_DEL_A(I);
+    falcON_DEL_A(It);
+    falcON_DEL_A(H);
+  }
+  //----------------------------------------------------------------------------
+  // RECURSIVE                                                                  
+  // builds the top of the box-dot tree from sorted dots [i0,i1) in branch box
+  // P: these are the same boxes as made by adddot_N() or adddot_1(). Boxes at
+  // level LT or with at most NTASK dots are left empty, but recorded as tasks.
+  //----------------------------------------------------------------------------
+  void TreeBuilder::split_top(box*P, size_t i0, size_t i1)
+  {
+    const int      l = P->LEVEL;                   // level of P                
+    const int      s = 3*(LT-l-1);                 // shift for octant in keys  
+    const unsigned k = KEY[i0] >> (s+3);           // key of P                  
+    dot*const      D = D0+NOUT;                    // sorted dots               
+    for(int b=0; b!=Nsub; ++b) {                   // LOOP octants              
+      const unsigned e = ((k<<3) + (b+1)) << s;    //   first key beyond octant 
+      size_t ib = i0;                              //   find end of octant's    
+      for(size_t n=i1-i0; n; ) {                   //   dots by bisection       
+	size_t h = n>>1;
+	if(KEY[i0+h] < e) { i0 += h+1; n -= h+1; }
+	else                           n  = h;
+      }
+      const size_t n = i0-ib;                      //   # dots in octant        
+      if(n == 1)                                   //   IF single dot           
+	P->OCT[b] = D+ib;                          //     put into octant       
+      else if(n > 1) {                             //   ELIF many dots          
+	box*S = make_subbox(P,b,NDOTS,D+ib,0);     //     make sub-box          
+	P->OCT[b] = S;                             //     put into octant       
+	P->mark_as_box(b);                         //     mark octant as box    
+	if(int(n) <= NCRIT)                        //     IF twig box           
+	  for(size_t i=ib; i!=i0; ++i)             //       add dots to list    
+	    S->adddot_to_list(D+i);
+	else if(l+1 < LT && n > NTASK) {           //     ELIF big branch box   
+	  S->NUMBER = n;                           //       split it here       
+	  split_top(S,ib,i0);
+	} else {                                   //     ELSE                  
+	  task T;                                  //       leave it to helper  
+	  T.B  = S;
+	  T.I0 = ib;
+	  T.I1 = i0;
+	  TASKS.push_back(T);
+	}
+      }
+    }                                              // END LOOP                  
+  }
+  //----------------------------------------------------------------------------
+  // parallel version of build():
+  // - sort dots by their keys, see sort_dots()
+  // - build the top of the box-dot tree serially, see split_top()
+  // - build the sub-trees below in parallel, one helper per thread, which use
+  //   their own box allocators
+  // The resulting box-dot tree is that made by build(), except for the order
+  // of dots in the linked lists of twig boxes.
+  //----------------------------------------------------------------------------
+  void TreeBuilder::build_parallel()
+  {
+    report REPORT("TreeBuilder::build_parallel()");
+    const size_t nd = N_dots()-NOUT;               // # dots to be added        
+    NW    = omp_get_max_threads();                 // # threads                 
+    LT    = DMAX < 10? DMAX : 10;                  // keys fit into 30 bits     
+    NTASK = nd/(16*NW);                            // want >= 16 tasks/thread   
+    if(NTASK < size_t(NCRIT)) NTASK = NCRIT;
+    sort_dots();                                   // sort dots by keys         
+    P0->NUMBER = nd;                               // root box = branch box     
+    split_top(P0,0,nd);                            // build top of tree         
+    WB = falcON_NEW(SubBoxBuilder,NW);             // helpers                   
+    for(int w=0; w!=NW; ++w)
+      WB[w].reset(this,NW);
+    const int nt = TASKS.size();
+#pragma omp parallel
+    {
+      const int w = omp_get_thread_num();
+#pragma omp for schedule(dynamic,1)
+      for(int t=0; t<nt; ++t) {                    // LOOP tasks                
+	task &T = TASKS[t];
+	size_t nb = WB[w].N_boxes();
+	WB[w].add(T.B,D0+NOUT+T.I0,D0+NOUT+T.I1);  //   build sub-tree          
+	T.W  = w;
+	T.NB = 1+WB[w].N_boxes()-nb;               //   # boxes in sub-tree     
+      }                                            // END LOOP                  
+    }
+  }
+  //----------------------------------------------------------------------------
+  // RECURSIVE                                                                  
+  // as link_cells_N(), but for the top of the tree built by split_top(): the
+  // boxes of tasks are not linked, but given their cell, free cells and free
+  // leafs, as these would be in link_cells_N(). Returns the depth of the cell
+  // ignoring those of tasks.
+  //----------------------------------------------------------------------------
+  int TreeBuilder::link_top(const box*     P,      // I:   current box          
+			    int            o,      // I:   octant of current box
+			    int            k,      // I:   local peano key      
+			    OctTree::Cell* C,      // I:   current cell         
+			    OctTree::Cell*&Cf,     // I/O: index: free cells    
+			    OctTree::Leaf*&Lf,     // I/O: index: free leafs    
+			    size_t        &it)     // I/O: index: next task     
+  {
+    if(P->is_twig())                               // IF box==twig              
+      return link_cells_N(P,o,k,C,Cf,Lf);          //   link as usual           
+    int dep=0;                                     // depth of cell             
+    level_ (C) = P->LEVEL;                         // copy level                
+    octant_(C) = o;                                // set octant                
+#ifdef falcON_MPI
+    peano_ (C) = P->PEANO;                         // copy peano map            
+    key_   (C) = k;                                // set local peano key       
+#endif
+    centre_(C) = P->centre();                      // copy centre               
+    number_(C) = P->NUMBER;                        // copy number               
+    fcleaf_(C) = NoLeaf(TREE,Lf);                  // set cell: leaf kids       
+    nleafs_(C) = 0;                                // reset cell: # leaf kids   
+    int i,nsub=0;                                  // octant, # sub-boxes       
+    node*const*N;                                  // sub-node pointer          
+    for(i=0, N=P->OCT; i!=Nsub; ++i,++N) if(*N) {  // LOOP non-empty octants    
+      if(P->marked_as_box(i)) ++nsub;              //   IF   sub-boxes: count   
+      else {                                       //   ELIF sub-dots:          
+	static_cast<dot*>(*N)->set_leaf(Lf++);     //     set leaf              
+	nleafs_(C)++;                              //     inc # sub-leafs       
+      }                                            //   END IF                  
+    }                                              // END LOOP                  
+    if(nsub) {                                     // IF has sub-boxes          
+      int c = NoCell(TREE,C);                      //   index of cell           
+      OctTree::Cell*Ci=Cf;                         //   remember free cells     
+      fccell_(C) = NoCell(TREE,Ci);                //   set cell: 1st sub-cell  
+      ncells_(C) = nsub;                           //   set cell: # cell kids   
+      Cf += nsub;                                  //   reserve nsub cells      
+      for(i=0, N=P->OCT; i!=Nsub; ++i,++N)         //   LOOP octants            
+	if(*N && P->marked_as_box(i)) {            //     IF sub-box            
+	  const box*B = static_cast<box*>(*N);
+	  int ki =
+#ifdef falcON_MPI
+	    P->PEANO.key(i);
+#else
+	    0;
+#endif
+	  pacell_(Ci) = c;                         //       sub-cell's parent   
+	  if(it < TASKS.size() && TASKS[it].B == B) {//     IF box of task      
+	    task &T = TASKS[it++];
+	    T.O  = i;                              //         remember where to 
+	    T.K  = ki;                             //         link it later     
+	    T.C  = Ci++;
+	    T.Cf = Cf;
+	    T.Lf = Lf;
+	    Cf  += T.NB-1;                         //         reserve its cells 
+	    Lf  += B->NUMBER;                      //         and leafs         
+	  } else {                                 //       ELSE                
+	    int de = link_top(B,i,ki,Ci++,Cf,Lf,it);//        link it now       
+	    if(de>dep) dep=de;                     //         update depth      
+	  }                                        //       ENDIF               
+	}                                          //   END LOOP                
+    } else {                                       // ELSE (no sub-boxes)       
+      fcCell_(C) =-1;                              //   set cell: 1st sub-cell  
+      ncells_(C) = 0;                              //   set cell: # sub-cells   
+    }                                              // ENDIF                     
+    dep++;                                         // increment depth           
+    return dep;                                    // return cell's depth       
+  }
+  //----------------------------------------------------------------------------
+  // parallel version of the linking in link(): the top of the tree serially,
+  // then the sub-trees of the tasks in parallel.
+  //----------------------------------------------------------------------------
+  int TreeBuilder::link_parallel(OctTree::Cell*C0, // I: root cell              
+				 OctTree::Cell*Cf, // I: free cells             
+				 OctTree::Leaf*Lf) // I: free leafs             
+  {
+    size_t it  = 0;
+    int    dep = link_top(P0,0,0,C0,Cf,Lf,it);     // link top of tree          
+    if(it != TASKS.size())
+      falcON_Error("TreeBuilder::link_parallel(): task mismatch");
+#ifdef falcON_track_bug
+    for(int w=0; w!=NW; ++w) WB[w].set_ends();
+#endif
+    const int nt = TASKS.size();
+#pragma omp parallel for schedule(dynamic,1) reduction(max:dep)
+    for(int t=0; t<nt; ++t) {                      // LOOP tasks                
+      const task &T = TASKS[t];                    //   link sub-tree           
+      int de = T.B->LEVEL + WB[T.W].link(T.B,T.O,T.K,T.C,T.Cf,T.Lf);
+      if(de>dep) dep=de;                           //   update depth            
+    }                                              // END LOOP                  
+    return dep;
+  }
+#endif // _OPENMP
   //----------------------------------------------------------------------------
   void TreeBuilder::report_infnan() const falcON_THROWING
   {
@@ -1197,6 +1596,9 @@ namespace {
 			   const vect   *xmax,
 			   bool          out) falcON_THROWING
   : ROOTCENTRE(x0), OUT(out)
+#ifdef _OPENMP
+  , NW(0), WB(0), KEY(0)
+#endif
   {
     report REPORT("TreeBuilder::TreeBuilder(): 1");
     TREE = tr;
@@ -1212,6 +1614,9 @@ namespace {
 			   int           dm,
 			   bool          out) falcON_THROWING
   : ROOTCENTRE(x0), OUT(out)
+#ifdef _OPENMP
+  , NW(0), WB(0), KEY(0)
+#endif
   {
     report REPORT("TreeBuilder::TreeBuilder(): 2");
     TREE = tr;
@@ -39,6 +39,7 @@
 // v 0.5    05/11/2008  WD register time of manipulation under trho
 // v 0.5.1  13/04/2010  WD removed use of initial_time()
 // v 0.6    25/06/2010  WD manipulation if time=integer*step (or step==0)
+// v 0.7    19/10/2026     parallel neighbour processing (OpenMP)
 ////////////////////////////////////////////////////////////////////////////////
 #include <public/defman.h>
 #include <public/neighbours.h>
@@ -178,7 +179,7 @@ namespace Manipulate {
       const_cast<snapshot*>(S)->add_field(fieldbit::r);
     prepare(N);
     unsigned NIAC;
-    ProcessNearestNeighbours(&TREE,K,&SetDensity,NIAC,true);
+    ProcessNearestNeighboursParallel(&TREE,K,&SetDensity,NIAC,true);
     if(falcON::debug(1)) {
       clock_t CPU1 = clock();
       DebugInfo("density::manipulate(): %f sec needed for density estimation;"
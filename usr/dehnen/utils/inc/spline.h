@@ -6,7 +6,7 @@
 ///
 /// \author  Walter Dehnen
 ///
-/// \date    1994-2007,2010,2013
+/// \date    1994-2007,2010,2013,2026
 ///
 ////////////////////////////////////////////////////////////////////////////////
 //
@@ -198,7 +198,6 @@ namespace WDutils {
     const scalar_type *x;                         ///< ordered table of points
     const table_type  *y;                         ///< table of function values
     table_type  *const y2;                        ///< table of y''
-    mutable int        lo;                        ///< x[lo] <= xi <= x[lo+1]
     //@}
   public:
     /// constructor from arrays
@@ -215,7 +214,7 @@ namespace WDutils {
 	   const table_type *_y,
 	   const table_type *yp1=0,
 	   const table_type *ypn=0)
-      : n(_n), x(_x), y(_y), y2(0), lo(0)
+      : n(_n), x(_x), y(_y), y2(0)
     {
       DebugInfo(6,"constructing spline of %d %s vs %s\n",n,
 		nameof(scalar_type),nameof(table_type));
@@ -234,7 +233,7 @@ namespace WDutils {
 	   Array<table_type ,1> const&_y,
 	   const table_type *yp1=0,
 	   const table_type *ypn=0)
-      : n(_x.size()), x(_x.array()), y(_y.array()), y2(0), lo(0)
+      : n(_x.size()), x(_x.array()), y(_y.array()), y2(0)
     {
       DebugInfo(6,"constructing spline of %d %s vs %s\n",n,
 		nameof(scalar_type),nameof(table_type));
@@ -259,9 +258,10 @@ namespace WDutils {
 			   table_type *dy = 0,
 			   table_type *d2y= 0) const
     {
-      find(lo,n,x,xi);
-      if(lo==n-1) --lo;
-      return evaluate(xi,x+lo,y+lo,y2+lo,dy,d2y);
+      int l=-1;                                  // no shared search hint:
+      find(l,n,x,xi);                            // guess, then hunt()
+      if(l==n-1) --l;
+      return evaluate(xi,x+l,y+l,y2+l,dy,d2y);
     }
     /// \name direct constant access to data
     //{@
@@ -498,7 +498,6 @@ namespace WDutils {
     const table_type  *y;                         ///< table of function values 
     const table_type  *y1;                        ///< table of 1st derivatives 
     table_type  *const y3;                        ///< table of 3rd derivatives 
-    mutable int        lo;                        ///< x[lo] <= xi <= x[lo+1]   
     //@}
   public:
     //--------------------------------------------------------------------------
@@ -513,7 +512,7 @@ namespace WDutils {
 	    const scalar_type*_x,
 	    const table_type *_y,
 	    const table_type *_y1)
-      : n(_n), x(_x), y(_y), y1(_y1), y3(WDutils_NEW(table_type,n)), lo(0)
+      : n(_n), x(_x), y(_y), y1(_y1), y3(WDutils_NEW(table_type,n))
     {
       construct(n,x,y,y1,y3);
     }
@@ -526,7 +525,7 @@ namespace WDutils {
 	    Array<table_type ,1>const&_y,
 	    Array<table_type ,1>const&_y1) :
       n(_x.size()), x(_x.array()), y(_y.array()), y1(_y1.array()),
-      y3(WDutils_NEW(table_type,n)), lo(0)
+      y3(WDutils_NEW(table_type,n))
     {
       if(_x.size() != _y.size() || _x.size() != _y1.size())
 	WDutils_Error("size mismatch in Pspline construction\n");
@@ -547,9 +546,10 @@ namespace WDutils {
 			   table_type *d2y= 0)
       const
     {
-      find(lo,n,x,xi);
-      if(lo==n-1) --lo;
-      return evaluate(xi,x+lo,y+lo,y1+lo,y3+lo,dy,d2y);
+      int l=-1;                                  // no shared search hint:
+      find(l,n,x,xi);                            // guess, then hunt()
+      if(l==n-1) --l;
+      return evaluate(xi,x+l,y+l,y1+l,y3+l,dy,d2y);
     }
     //--------------------------------------------------------------------------
     /// \name direct access to tables